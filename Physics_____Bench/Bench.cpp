@@ -0,0 +1,288 @@
+#include "World.hpp"
+#include "Scene.hpp"
+#include "Triggers.hpp"
+#include "SimdKernels.hpp"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <new>
+#include <string>
+#include <vector>
+
+// Headless benchmark: steps generated scenes over a sweep of body counts
+// and writes one JSON document with the per-step costs.
+//
+//   Physics_____Bench [options]
+//
+//   --scenes list  comma-separated, from rain, pile, stacks, mixed,
+//                  triggers, ropes (default: all)
+//   --sizes list   comma-separated body counts (default 1000,2000,5000,10000,20000)
+//   --steps N      measured steps per run (default 300)
+//   --warmup N     steps run before measuring (default 60)
+//   --dt seconds   step length (default 1/60)
+//   --threads N    solve contact islands on N threads (default 1)
+//   --simd level   scalar, sse2 or avx2 (default: best supported)
+//   --no-sleep     keep every body awake
+//   --seed N       generator seed (default 1)
+//   --out path     write the JSON there instead of stdout
+//
+// Scenes are generated the same on every platform, so two builds (or two
+// machines) given the same arguments run the same work. Only the engine
+// sources and the header-only SFML vector/rect types are needed, e.g. on
+// Linux:
+//
+//   g++ -std=c++20 -O2 -I<sfml>/include -IPhysics_____Engine Physics_____Bench/Bench.cpp
+//       Physics_____Engine/{World,Scene,SceneBinary,BodyStore,Broadphase,AabbTree,Islands,
+//       ThreadPool,SimdKernels,Collision,ContactSolver,Profiler,Triggers,Joints}.cpp -lpthread
+
+// --- Allocation counting ---
+// Every heap allocation in the process goes through these, so the
+// counters see the engine's vectors, the thread pool and the library.
+static std::atomic<uint64_t> allocCount{ 0 };
+static std::atomic<uint64_t> allocBytes{ 0 };
+
+static void* countedAlloc(std::size_t n) {
+    allocCount.fetch_add(1, std::memory_order_relaxed);
+    allocBytes.fetch_add(n, std::memory_order_relaxed);
+    if (void* p = std::malloc(n ? n : 1)) return p;
+    throw std::bad_alloc();
+}
+
+static void* countedAlignedAlloc(std::size_t n, std::size_t align) {
+    allocCount.fetch_add(1, std::memory_order_relaxed);
+    allocBytes.fetch_add(n, std::memory_order_relaxed);
+#ifdef _WIN32
+    if (void* p = _aligned_malloc(n ? n : 1, align)) return p;
+#else
+    // aligned_alloc wants a multiple of the alignment
+    if (void* p = std::aligned_alloc(align, std::max(align, (n + align - 1) / align * align))) return p;
+#endif
+    throw std::bad_alloc();
+}
+
+static void alignedFree(void* p) {
+#ifdef _WIN32
+    _aligned_free(p);
+#else
+    std::free(p);
+#endif
+}
+
+void* operator new(std::size_t n) { return countedAlloc(n); }
+void operator delete(void* p) noexcept { std::free(p); }
+void operator delete(void* p, std::size_t) noexcept { std::free(p); }
+void* operator new(std::size_t n, std::align_val_t a) { return countedAlignedAlloc(n, static_cast<std::size_t>(a)); }
+void operator delete(void* p, std::align_val_t) noexcept { alignedFree(p); }
+void operator delete(void* p, std::size_t, std::align_val_t) noexcept { alignedFree(p); }
+
+// --- Runs ---
+struct BenchSettings {
+    long long steps = 300;
+    long long warmup = 60;
+    float dt = 1.f / 60.f;
+    bool sleep = true;
+    uint32_t seed = 1;
+    ThreadPool* pool = nullptr;
+};
+
+struct BenchResult {
+    std::string scene;
+    size_t bodies = 0;
+    size_t lines = 0;
+    size_t joints = 0;
+    double nsPerStep = 0.0;
+    double nsPerBodyStep = 0.0;
+    double worstStepNs = 0.0;
+    double pairsPerStep = 0.0;
+    double contactsPerStep = 0.0;
+    double allocationsPerStep = 0.0;
+    double allocatedBytesPerStep = 0.0;
+    double triggerCrossingsPerStep = 0.0;
+    size_t awakeAtEnd = 0;
+};
+
+static const char* const sceneNames[] = { "rain", "pile", "stacks", "mixed", "triggers", "ropes" };
+
+static void generateScene(const std::string& scene, World& world, size_t count, TriggerSet& triggers, uint32_t seed) {
+    std::vector<SceneLine> lines;
+    if (scene == "rain") generateRain(world, count, 4.f);
+    else if (scene == "pile") generatePile(world, count, seed);
+    else if (scene == "stacks") generateStacks(world, count);
+    else if (scene == "mixed") generateMixed(world, count, seed);
+    else if (scene == "triggers") generateTriggerField(world, count, lines, seed);
+    else if (scene == "ropes") generateRopes(world, count, 30, seed);
+    for (const SceneLine& line : lines) triggers.add(line.start, line.end);
+}
+
+static BenchResult runScene(const std::string& scene, size_t count, const BenchSettings& settings) {
+    World world;
+    world.setThreadPool(settings.pool);
+    TriggerSet triggers;
+    generateScene(scene, world, count, triggers, settings.seed);
+    world.setSleepEnabled(settings.sleep);
+
+    // The crossing pass runs after every step, as in the editor
+    std::vector<TriggerEvent> events;
+    for (long long s = 0; s < settings.warmup; ++s) {
+        world.step(settings.dt);
+        events.clear();
+        triggers.detect(world, 0.f, settings.dt, events);
+    }
+
+    // Only the step (and the trigger pass) is timed, not the counting
+    size_t pairs = 0, contacts = 0, crossings = 0;
+    double ns = 0.0, worst = 0.0;
+    const uint64_t allocs0 = allocCount.load(std::memory_order_relaxed);
+    const uint64_t bytes0 = allocBytes.load(std::memory_order_relaxed);
+    for (long long s = 0; s < settings.steps; ++s) {
+        const auto start = std::chrono::steady_clock::now();
+        world.step(settings.dt);
+        events.clear();
+        triggers.detect(world, 0.f, settings.dt, events);
+        const double stepNs = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+        ns += stepNs;
+        worst = std::max(worst, stepNs);
+
+        pairs += world.getPairCount();
+        contacts += world.getContactCount();
+        crossings += events.size();
+    }
+    const double steps = static_cast<double>(settings.steps);
+
+    BenchResult r;
+    r.scene = scene;
+    r.bodies = world.size();
+    r.lines = triggers.size();
+    r.joints = world.getJointCount();
+    r.nsPerStep = ns / steps;
+    r.nsPerBodyStep = r.bodies ? r.nsPerStep / static_cast<double>(r.bodies) : 0.0;
+    r.worstStepNs = worst;
+    r.pairsPerStep = static_cast<double>(pairs) / steps;
+    r.contactsPerStep = static_cast<double>(contacts) / steps;
+    r.allocationsPerStep = static_cast<double>(allocCount.load(std::memory_order_relaxed) - allocs0) / steps;
+    r.allocatedBytesPerStep = static_cast<double>(allocBytes.load(std::memory_order_relaxed) - bytes0) / steps;
+    r.triggerCrossingsPerStep = static_cast<double>(crossings) / steps;
+    r.awakeAtEnd = world.getAwakeCount();
+    return r;
+}
+
+// --- Output ---
+static void writeJson(FILE* out, const BenchSettings& settings, unsigned threads, const std::vector<BenchResult>& results) {
+    std::fprintf(out, "{\n");
+    std::fprintf(out, "  \"steps\": %lld,\n  \"warmup\": %lld,\n  \"dt\": %.9g,\n", settings.steps, settings.warmup, settings.dt);
+    std::fprintf(out, "  \"threads\": %u,\n  \"simd\": \"%s\",\n  \"sleep\": %s,\n  \"seed\": %u,\n", threads,
+                 simdLevelName(getSimdLevel()), settings.sleep ? "true" : "false", settings.seed);
+    std::fprintf(out, "  \"results\": [");
+    for (size_t i = 0; i < results.size(); ++i) {
+        const BenchResult& r = results[i];
+        std::fprintf(out, "%s\n    {\"scene\": \"%s\", \"bodies\": %zu, \"trigger_lines\": %zu, \"joints\": %zu,",
+                     i ? "," : "", r.scene.c_str(), r.bodies, r.lines, r.joints);
+        std::fprintf(out, " \"ns_per_step\": %.1f, \"ns_per_body_step\": %.3f, \"worst_step_ns\": %.1f,",
+                     r.nsPerStep, r.nsPerBodyStep, r.worstStepNs);
+        std::fprintf(out, " \"pairs_per_step\": %.1f, \"contacts_per_step\": %.1f,", r.pairsPerStep, r.contactsPerStep);
+        std::fprintf(out, " \"allocations_per_step\": %.2f, \"allocated_bytes_per_step\": %.1f,",
+                     r.allocationsPerStep, r.allocatedBytesPerStep);
+        std::fprintf(out, " \"trigger_crossings_per_step\": %.2f, \"awake_at_end\": %zu}",
+                     r.triggerCrossingsPerStep, r.awakeAtEnd);
+    }
+    std::fprintf(out, "\n  ]\n}\n");
+}
+
+static std::vector<std::string> splitList(const char* text) {
+    std::vector<std::string> items;
+    std::string item;
+    for (const char* c = text; ; ++c) {
+        if (*c == ',' || *c == '\0') {
+            if (!item.empty()) items.push_back(item);
+            item.clear();
+            if (*c == '\0') break;
+        }
+        else {
+            item += *c;
+        }
+    }
+    return items;
+}
+
+static void printUsage() {
+    std::printf("usage: Physics_____Bench [--scenes rain,pile,stacks,mixed,triggers,ropes] [--sizes N,N,...] [--steps N] [--warmup N] [--dt seconds] [--threads N] [--simd level] [--no-sleep] [--seed N] [--out path]\n");
+}
+
+int main(int argc, char** argv)
+{
+    std::vector<std::string> scenes(std::begin(sceneNames), std::end(sceneNames));
+    std::vector<size_t> sizes = { 1000, 2000, 5000, 10000, 20000 };
+    BenchSettings settings;
+    unsigned threads = 1;
+    std::string outPath;
+
+    for (int i = 1; i < argc; ++i) {
+        if (std::strcmp(argv[i], "--scenes") == 0 && i + 1 < argc)
+            scenes = splitList(argv[++i]);
+        else if (std::strcmp(argv[i], "--sizes") == 0 && i + 1 < argc) {
+            sizes.clear();
+            for (const std::string& s : splitList(argv[++i])) sizes.push_back(static_cast<size_t>(std::atoll(s.c_str())));
+        }
+        else if (std::strcmp(argv[i], "--steps") == 0 && i + 1 < argc)
+            settings.steps = std::atoll(argv[++i]);
+        else if (std::strcmp(argv[i], "--warmup") == 0 && i + 1 < argc)
+            settings.warmup = std::atoll(argv[++i]);
+        else if (std::strcmp(argv[i], "--dt") == 0 && i + 1 < argc)
+            settings.dt = static_cast<float>(std::atof(argv[++i]));
+        else if (std::strcmp(argv[i], "--threads") == 0 && i + 1 < argc)
+            threads = static_cast<unsigned>(std::atoi(argv[++i]));
+        else if (std::strcmp(argv[i], "--simd") == 0 && i + 1 < argc) {
+            const char* level = argv[++i];
+            setSimdLevel(std::strcmp(level, "scalar") == 0 ? SimdLevel::Scalar
+                : std::strcmp(level, "sse2") == 0 ? SimdLevel::Sse2 : SimdLevel::Avx2);
+        }
+        else if (std::strcmp(argv[i], "--no-sleep") == 0)
+            settings.sleep = false;
+        else if (std::strcmp(argv[i], "--seed") == 0 && i + 1 < argc)
+            settings.seed = static_cast<uint32_t>(std::atoll(argv[++i]));
+        else if (std::strcmp(argv[i], "--out") == 0 && i + 1 < argc)
+            outPath = argv[++i];
+        else {
+            printUsage();
+            return 1;
+        }
+    }
+
+    if (settings.steps <= 0 || settings.warmup < 0 || settings.dt <= 0.f || scenes.empty() || sizes.empty()) {
+        printUsage();
+        return 1;
+    }
+    for (const std::string& scene : scenes) {
+        if (std::find(std::begin(sceneNames), std::end(sceneNames), scene) == std::end(sceneNames)) {
+            std::fprintf(stderr, "error: unknown scene '%s'\n", scene.c_str());
+            return 1;
+        }
+    }
+
+    std::unique_ptr<ThreadPool> pool;
+    if (threads > 1) pool = std::make_unique<ThreadPool>(threads);
+    settings.pool = pool.get();
+
+    // Progress goes to stderr so stdout stays valid JSON
+    std::vector<BenchResult> results;
+    for (const std::string& scene : scenes) {
+        for (size_t count : sizes) {
+            std::fprintf(stderr, "%-9s %8zu bodies ... ", scene.c_str(), count);
+            results.push_back(runScene(scene, count, settings));
+            std::fprintf(stderr, "%.1f ns/body/step\n", results.back().nsPerBodyStep);
+        }
+    }
+
+    FILE* out = stdout;
+    if (!outPath.empty() && !(out = std::fopen(outPath.c_str(), "w"))) {
+        std::fprintf(stderr, "error: cannot write %s\n", outPath.c_str());
+        return 1;
+    }
+    writeJson(out, settings, pool ? pool->getThreadCount() : 1u, results);
+    if (out != stdout) std::fclose(out);
+    return 0;
+}
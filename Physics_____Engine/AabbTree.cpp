@@ -0,0 +1,331 @@
+#include "AabbTree.hpp"
+#include <cmath>
+
+float segmentAabb(const sf::Vector2f& from, const sf::Vector2f& to, const Aabb& box, float maxT) {
+    const float d[2] = { to.x - from.x, to.y - from.y };
+    const float o[2] = { from.x, from.y };
+    const float lo[2] = { box.minX, box.minY };
+    const float hi[2] = { box.maxX, box.maxY };
+
+    float tMin = 0.f, tMax = maxT;
+    for (int axis = 0; axis < 2; ++axis) {
+        if (std::abs(d[axis]) < 1e-12f) {
+            if (o[axis] < lo[axis] || o[axis] > hi[axis]) return -1.f;
+            continue;
+        }
+        const float inv = 1.f / d[axis];
+        float t1 = (lo[axis] - o[axis]) * inv;
+        float t2 = (hi[axis] - o[axis]) * inv;
+        if (t1 > t2) std::swap(t1, t2);
+        tMin = std::max(tMin, t1);
+        tMax = std::min(tMax, t2);
+        if (tMin > tMax) return -1.f;
+    }
+    return tMin;
+}
+
+// --- Node pool ---
+int32_t AabbTree::allocateNode() {
+    int32_t id;
+    if (freeList != nullNode) {
+        id = freeList;
+        freeList = nodes[id].parent;
+        nodes[id] = Node{};
+    }
+    else {
+        id = static_cast<int32_t>(nodes.size());
+        nodes.emplace_back();
+    }
+    nodes[id].height = 0;
+    return id;
+}
+
+void AabbTree::freeNode(int32_t node) {
+    nodes[node].parent = freeList;
+    nodes[node].height = -1;
+    freeList = node;
+}
+
+// --- Proxies ---
+int32_t AabbTree::insert(const Aabb& box, uint32_t userData) {
+    const int32_t leaf = allocateNode();
+    nodes[leaf].box = { box.minX - margin, box.minY - margin, box.maxX + margin, box.maxY + margin };
+    nodes[leaf].userData = userData;
+    insertLeaf(leaf);
+    ++proxyCount;
+    return leaf;
+}
+
+void AabbTree::remove(int32_t proxy) {
+    removeLeaf(proxy);
+    freeNode(proxy);
+    --proxyCount;
+}
+
+bool AabbTree::move(int32_t proxy, const Aabb& box) {
+    if (nodes[proxy].box.contains(box)) return false;
+
+    removeLeaf(proxy);
+    nodes[proxy].box = { box.minX - margin, box.minY - margin, box.maxX + margin, box.maxY + margin };
+    insertLeaf(proxy);
+    return true;
+}
+
+void AabbTree::clear() {
+    nodes.clear();
+    root = nullNode;
+    freeList = nullNode;
+    proxyCount = 0;
+}
+
+// --- Bulk build ---
+void AabbTree::build(const Aabb* boxes, size_t n, uint32_t firstUserData, int32_t* proxies) {
+    clear();
+    if (n == 0) return;
+
+    // Leaves first, so leaf i is node i; internal nodes follow
+    nodes.reserve(2 * n - 1);
+    nodes.resize(n);
+    Aabb bounds = boxes[0];
+    for (size_t i = 0; i < n; ++i) {
+        Node& leaf = nodes[i];
+        leaf.box = { boxes[i].minX - margin, boxes[i].minY - margin, boxes[i].maxX + margin, boxes[i].maxY + margin };
+        leaf.height = 0;
+        leaf.userData = firstUserData + static_cast<uint32_t>(i);
+        proxies[i] = static_cast<int32_t>(i);
+        bounds = Aabb::merge(bounds, boxes[i]);
+    }
+
+    // Leaves sorted along a Z-order curve through their centres, with the
+    // leaf index in the low bits of the key
+    const float scaleX = 65535.f / std::max(bounds.maxX - bounds.minX, 1e-6f);
+    const float scaleY = 65535.f / std::max(bounds.maxY - bounds.minY, 1e-6f);
+    auto spread = [](uint32_t v) {
+        v = (v | (v << 8)) & 0x00FF00FFu;
+        v = (v | (v << 4)) & 0x0F0F0F0Fu;
+        v = (v | (v << 2)) & 0x33333333u;
+        v = (v | (v << 1)) & 0x55555555u;
+        return v;
+    };
+    std::vector<uint64_t> keys(n);
+    for (size_t i = 0; i < n; ++i) {
+        const float cx = 0.5f * (boxes[i].minX + boxes[i].maxX) - bounds.minX;
+        const float cy = 0.5f * (boxes[i].minY + boxes[i].maxY) - bounds.minY;
+        const uint32_t code = spread(static_cast<uint32_t>(cx * scaleX)) | spread(static_cast<uint32_t>(cy * scaleY)) << 1;
+        keys[i] = static_cast<uint64_t>(code) << 32 | i;
+    }
+    std::sort(keys.begin(), keys.end());
+
+    root = buildRange(keys.data(), n);
+    nodes[root].parent = nullNode;
+    proxyCount = n;
+}
+
+// Halves the sorted range, so nearby leaves share subtrees and the tree
+// comes out balanced
+int32_t AabbTree::buildRange(const uint64_t* keys, size_t count) {
+    if (count == 1) return static_cast<int32_t>(keys[0] & 0xFFFFFFFFu);
+
+    const size_t half = count / 2;
+    const int32_t child1 = buildRange(keys, half);
+    const int32_t child2 = buildRange(keys + half, count - half);
+
+    const int32_t index = allocateNode();
+    Node& node = nodes[index];
+    node.box = Aabb::merge(nodes[child1].box, nodes[child2].box);
+    node.child1 = child1;
+    node.child2 = child2;
+    node.height = 1 + std::max(nodes[child1].height, nodes[child2].height);
+    nodes[child1].parent = index;
+    nodes[child2].parent = index;
+    return index;
+}
+
+// --- Tree maintenance ---
+void AabbTree::insertLeaf(int32_t leaf) {
+    if (root == nullNode) {
+        root = leaf;
+        nodes[root].parent = nullNode;
+        return;
+    }
+
+    // Descend to the sibling with the lowest perimeter cost
+    const Aabb leafBox = nodes[leaf].box;
+    int32_t index = root;
+    while (!nodes[index].isLeaf()) {
+        const Node& node = nodes[index];
+        const float area = node.box.perimeter();
+        const float combinedArea = Aabb::merge(node.box, leafBox).perimeter();
+
+        const float cost = 2.f * combinedArea;
+        const float inheritance = 2.f * (combinedArea - area);
+
+        auto childCost = [&](int32_t child) {
+            const Node& c = nodes[child];
+            const float merged = Aabb::merge(leafBox, c.box).perimeter();
+            return (c.isLeaf() ? merged : merged - c.box.perimeter()) + inheritance;
+        };
+        const float cost1 = childCost(node.child1);
+        const float cost2 = childCost(node.child2);
+
+        if (cost < cost1 && cost < cost2) break;
+        index = cost1 < cost2 ? node.child1 : node.child2;
+    }
+
+    const int32_t sibling = index;
+    const int32_t oldParent = nodes[sibling].parent;
+    const int32_t newParent = allocateNode();
+
+    Node& parent = nodes[newParent];
+    parent.parent = oldParent;
+    parent.box = Aabb::merge(leafBox, nodes[sibling].box);
+    parent.height = nodes[sibling].height + 1;
+    parent.child1 = sibling;
+    parent.child2 = leaf;
+    nodes[sibling].parent = newParent;
+    nodes[leaf].parent = newParent;
+
+    if (oldParent != nullNode) {
+        if (nodes[oldParent].child1 == sibling) nodes[oldParent].child1 = newParent;
+        else nodes[oldParent].child2 = newParent;
+    }
+    else {
+        root = newParent;
+    }
+
+    // Refit and rebalance on the way back up
+    index = nodes[leaf].parent;
+    while (index != nullNode) {
+        index = balance(index);
+        Node& node = nodes[index];
+        node.height = 1 + std::max(nodes[node.child1].height, nodes[node.child2].height);
+        node.box = Aabb::merge(nodes[node.child1].box, nodes[node.child2].box);
+        index = node.parent;
+    }
+}
+
+void AabbTree::removeLeaf(int32_t leaf) {
+    if (leaf == root) {
+        root = nullNode;
+        return;
+    }
+
+    const int32_t parent = nodes[leaf].parent;
+    const int32_t grandParent = nodes[parent].parent;
+    const int32_t sibling = nodes[parent].child1 == leaf ? nodes[parent].child2 : nodes[parent].child1;
+
+    if (grandParent == nullNode) {
+        root = sibling;
+        nodes[sibling].parent = nullNode;
+        freeNode(parent);
+        return;
+    }
+
+    if (nodes[grandParent].child1 == parent) nodes[grandParent].child1 = sibling;
+    else nodes[grandParent].child2 = sibling;
+    nodes[sibling].parent = grandParent;
+    freeNode(parent);
+
+    int32_t index = grandParent;
+    while (index != nullNode) {
+        index = balance(index);
+        Node& node = nodes[index];
+        node.height = 1 + std::max(nodes[node.child1].height, nodes[node.child2].height);
+        node.box = Aabb::merge(nodes[node.child1].box, nodes[node.child2].box);
+        index = node.parent;
+    }
+}
+
+// Rotates the taller grandchild up when A's subtrees differ in height by
+// more than one. Returns the index of the new subtree root.
+int32_t AabbTree::balance(int32_t iA) {
+    Node& A = nodes[iA];
+    if (A.isLeaf() || A.height < 2) return iA;
+
+    const int32_t iB = A.child1;
+    const int32_t iC = A.child2;
+    Node& B = nodes[iB];
+    Node& C = nodes[iC];
+
+    const int32_t diff = C.height - B.height;
+
+    auto replaceChild = [this, iA](int32_t parentIndex, int32_t newChild) {
+        if (parentIndex == nullNode) {
+            root = newChild;
+        }
+        else if (nodes[parentIndex].child1 == iA) {
+            nodes[parentIndex].child1 = newChild;
+        }
+        else {
+            nodes[parentIndex].child2 = newChild;
+        }
+    };
+
+    // Rotate C up
+    if (diff > 1) {
+        const int32_t iF = C.child1;
+        const int32_t iG = C.child2;
+        Node& F = nodes[iF];
+        Node& G = nodes[iG];
+
+        C.child1 = iA;
+        C.parent = A.parent;
+        A.parent = iC;
+        replaceChild(C.parent, iC);
+
+        if (F.height > G.height) {
+            C.child2 = iF;
+            A.child2 = iG;
+            G.parent = iA;
+            A.box = Aabb::merge(B.box, G.box);
+            C.box = Aabb::merge(A.box, F.box);
+            A.height = 1 + std::max(B.height, G.height);
+            C.height = 1 + std::max(A.height, F.height);
+        }
+        else {
+            C.child2 = iG;
+            A.child2 = iF;
+            F.parent = iA;
+            A.box = Aabb::merge(B.box, F.box);
+            C.box = Aabb::merge(A.box, G.box);
+            A.height = 1 + std::max(B.height, F.height);
+            C.height = 1 + std::max(A.height, G.height);
+        }
+        return iC;
+    }
+
+    // Rotate B up
+    if (diff < -1) {
+        const int32_t iD = B.child1;
+        const int32_t iE = B.child2;
+        Node& D = nodes[iD];
+        Node& E = nodes[iE];
+
+        B.child1 = iA;
+        B.parent = A.parent;
+        A.parent = iB;
+        replaceChild(B.parent, iB);
+
+        if (D.height > E.height) {
+            B.child2 = iD;
+            A.child1 = iE;
+            E.parent = iA;
+            A.box = Aabb::merge(C.box, E.box);
+            B.box = Aabb::merge(A.box, D.box);
+            A.height = 1 + std::max(C.height, E.height);
+            B.height = 1 + std::max(A.height, D.height);
+        }
+        else {
+            B.child2 = iE;
+            A.child1 = iD;
+            D.parent = iA;
+            A.box = Aabb::merge(C.box, D.box);
+            B.box = Aabb::merge(A.box, E.box);
+            A.height = 1 + std::max(C.height, D.height);
+            B.height = 1 + std::max(A.height, E.height);
+        }
+        return iB;
+    }
+
+    return iA;
+}
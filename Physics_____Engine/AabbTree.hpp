@@ -0,0 +1,162 @@
+#pragma once
+#include <SFML/System/Vector2.hpp>
+#include <SFML/Graphics/Rect.hpp>
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+
+// ---------------------
+// Axis-aligned box with min/max corners (cheaper to merge and test than
+// sf::FloatRect's position/size form).
+// ---------------------
+struct Aabb {
+    float minX = 0.f, minY = 0.f, maxX = 0.f, maxY = 0.f;
+
+    Aabb() = default;
+    Aabb(float x0, float y0, float x1, float y1) : minX(x0), minY(y0), maxX(x1), maxY(y1) {}
+    Aabb(const sf::FloatRect& r) : minX(r.left), minY(r.top), maxX(r.left + r.width), maxY(r.top + r.height) {}
+
+    bool contains(const Aabb& o) const {
+        return minX <= o.minX && minY <= o.minY && o.maxX <= maxX && o.maxY <= maxY;
+    }
+    bool contains(const sf::Vector2f& p) const {
+        return p.x >= minX && p.x < maxX && p.y >= minY && p.y < maxY;
+    }
+    bool overlaps(const Aabb& o) const {
+        return minX < o.maxX && o.minX < maxX && minY < o.maxY && o.minY < maxY;
+    }
+    float perimeter() const { return 2.f * ((maxX - minX) + (maxY - minY)); }
+
+    static Aabb merge(const Aabb& a, const Aabb& b) {
+        return { std::min(a.minX, b.minX), std::min(a.minY, b.minY), std::max(a.maxX, b.maxX), std::max(a.maxY, b.maxY) };
+    }
+};
+
+// Slab test of the segment from + t * (to - from), t in [0, maxT].
+// Returns the entry fraction, or a negative value on a miss.
+float segmentAabb(const sf::Vector2f& from, const sf::Vector2f& to, const Aabb& box, float maxT = 1.f);
+
+// ---------------------
+// Dynamic AABB tree (bounding volume hierarchy with fattened leaves).
+//
+// Leaves store the user's box grown by 'margin', so a proxy whose box
+// moves a little inside its fat box costs nothing; it is only removed and
+// re-inserted once it escapes. Insertion picks the sibling by perimeter
+// cost and the tree is kept balanced with AVL-style rotations.
+// ---------------------
+class AabbTree {
+public:
+    static constexpr int32_t nullNode = -1;
+
+    explicit AabbTree(float margin = 4.f) : margin(margin) {}
+
+    int32_t insert(const Aabb& box, uint32_t userData);
+    void remove(int32_t proxy);
+    // Returns true if the proxy had to be re-inserted
+    bool move(int32_t proxy, const Aabb& box);
+    void clear();
+
+    // Replaces the contents with leaves for boxes[0 .. n), user data
+    // firstUserData + i, built over the boxes in Z-order. Much faster than
+    // n inserts for a freshly loaded scene; proxies[i] receives leaf i.
+    void build(const Aabb* boxes, size_t n, uint32_t firstUserData, int32_t* proxies);
+
+    uint32_t getUserData(int32_t proxy) const { return nodes[proxy].userData; }
+    void setUserData(int32_t proxy, uint32_t userData) { nodes[proxy].userData = userData; }
+    const Aabb& getFatBounds(int32_t proxy) const { return nodes[proxy].box; }
+
+    size_t getProxyCount() const { return proxyCount; }
+    int getHeight() const { return root == nullNode ? 0 : nodes[root].height; }
+
+    // callback(userData) -> bool, return false to stop the query
+    template <typename F> void queryPoint(const sf::Vector2f& p, F&& callback) const;
+    template <typename F> void queryRect(const Aabb& box, F&& callback) const;
+
+    // callback(userData, from, to, maxT) -> float. Return the new clip
+    // fraction (< maxT to shorten the ray, 0 to stop, maxT to continue).
+    template <typename F> void raycast(const sf::Vector2f& from, const sf::Vector2f& to, F&& callback) const;
+
+private:
+    struct Node {
+        Aabb box;
+        int32_t parent = nullNode;   // next free node while on the free list
+        int32_t child1 = nullNode;
+        int32_t child2 = nullNode;
+        int32_t height = -1;         // -1 = free, 0 = leaf
+        uint32_t userData = 0;
+
+        bool isLeaf() const { return child1 == nullNode; }
+    };
+
+    int32_t allocateNode();
+    void freeNode(int32_t node);
+    void insertLeaf(int32_t leaf);
+    void removeLeaf(int32_t leaf);
+    int32_t balance(int32_t a);
+    int32_t buildRange(const uint64_t* keys, size_t count);
+
+    template <typename Test, typename F> void walk(Test&& test, F&& callback) const;
+
+private:
+    std::vector<Node> nodes;
+    int32_t root = nullNode;
+    int32_t freeList = nullNode;
+    size_t proxyCount = 0;
+    float margin;
+};
+
+// The stack lives on the call stack while it fits (a balanced tree of a
+// billion leaves is ~45 deep), so queries in hot loops do not allocate
+template <typename Test, typename F>
+void AabbTree::walk(Test&& test, F&& callback) const {
+    if (root == nullNode) return;
+    int32_t fixed[64];
+    std::vector<int32_t> spill;
+    int32_t* stack = fixed;
+    size_t capacity = 64;
+    size_t size = 0;
+    stack[size++] = root;
+
+    while (size > 0) {
+        const int32_t id = stack[--size];
+
+        const Node& node = nodes[id];
+        if (!test(node.box)) continue;
+
+        if (node.isLeaf()) {
+            if (!callback(node.userData)) return;
+        }
+        else {
+            if (size + 2 > capacity) {
+                if (spill.empty()) spill.assign(stack, stack + size);
+                spill.resize(capacity * 2);
+                stack = spill.data();
+                capacity = spill.size();
+            }
+            stack[size++] = node.child1;
+            stack[size++] = node.child2;
+        }
+    }
+}
+
+template <typename F>
+void AabbTree::queryPoint(const sf::Vector2f& p, F&& callback) const {
+    walk([&p](const Aabb& b) { return b.contains(p); }, callback);
+}
+
+template <typename F>
+void AabbTree::queryRect(const Aabb& box, F&& callback) const {
+    walk([&box](const Aabb& b) { return b.overlaps(box); }, callback);
+}
+
+template <typename F>
+void AabbTree::raycast(const sf::Vector2f& from, const sf::Vector2f& to, F&& callback) const {
+    float maxT = 1.f;
+    walk([&](const Aabb& b) { return segmentAabb(from, to, b, maxT) >= 0.f; },
+        [&](uint32_t userData) {
+            const float t = callback(userData, from, to, maxT);
+            if (t <= 0.f) return false;
+            maxT = std::min(maxT, t);
+            return true;
+        });
+}
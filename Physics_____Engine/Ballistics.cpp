@@ -0,0 +1,214 @@
+#include "Ballistics.hpp"
+#include "SimdKernels.hpp"
+#include "Profiler.hpp"
+#include <algorithm>
+#include <cmath>
+
+BallisticSettings BallisticSettings::fromWorld(const World& world, float dt) {
+    BallisticSettings s;
+    s.dt = dt;
+    s.gravity = world.getGravity();
+    s.groundY = world.getGroundY();
+    s.groundFriction = world.getGroundFriction();
+    return s;
+}
+
+void BallisticBatch::clear() {
+    launches.clear();
+    results.clear();
+    slides.clear();
+    flights.clear();
+    flightStart.assign(1, 0);
+}
+
+size_t BallisticBatch::add(const BallisticLaunch& launch) {
+    launches.push_back(launch);
+    return launches.size() - 1;
+}
+
+size_t BallisticBatch::addBody(const World& world, size_t index) {
+    const BodyStore& b = world.getStore();
+    return add({ { b.posX[index], b.posY[index] }, { b.velX[index], b.velY[index] },
+                 b.restitution[index], b.localMaxY[index] });
+}
+
+// --- Prediction ---
+void BallisticBatch::predict(const BallisticSettings& s) {
+    PROFILE_ZONE("Ballistics");
+    settings = s;
+    const size_t count = launches.size();
+    const float maxSteps = 16777216.f;
+    horizonSteps = static_cast<uint32_t>(std::clamp(std::ceil(s.horizon / s.dt), 1.f, maxSteps));
+
+    results.assign(count, {});
+    slides.assign(count, {});
+    passFlights.clear();
+    passLaunch.clear();
+
+    for (auto* lane : { &px, &py, &vx, &vy, &steps, &landed, &e, &bottom }) lane->resize(count);
+    laneLaunch.resize(count);
+    laneStep.assign(count, 0);
+    for (size_t i = 0; i < count; ++i) {
+        const BallisticLaunch& l = launches[i];
+        px[i] = l.position.x;
+        py[i] = l.position.y;
+        vx[i] = l.velocity.x;
+        vy[i] = l.velocity.y;
+        e[i] = l.restitution;
+        bottom[i] = l.bottom;
+        laneLaunch[i] = static_cast<uint32_t>(i);
+    }
+
+    const BallisticParams params{ s.dt, s.gravity, s.groundY, s.groundFriction, static_cast<float>(horizonSteps) };
+    const BallisticStreams streams{ px.data(), py.data(), vx.data(), vy.data(), steps.data(), landed.data(),
+                                    e.data(), bottom.data() };
+    const uint32_t maxFlights = std::max<uint32_t>(1, s.maxBounces);
+    flightCount.assign(count, 0);
+
+    size_t active = count;
+    while (active) {
+        startX.assign(px.begin(), px.begin() + active);
+        startY.assign(py.begin(), py.begin() + active);
+        startVX.assign(vx.begin(), vx.begin() + active);
+        startVY.assign(vy.begin(), vy.begin() + active);
+
+        advanceBallistic(streams, active, params);
+
+        // Record each lane's flight; keep the ones still bouncing, in order
+        size_t kept = 0;
+        for (size_t k = 0; k < active; ++k) {
+            const uint32_t i = laneLaunch[k];
+            BallisticFlight f{ { startX[k], startY[k] }, { startVX[k], startVY[k] }, { px[k], py[k] },
+                               laneStep[k], static_cast<uint32_t>(steps[k]), landed[k] != 0.f };
+
+            // On the ground at the very next step: it is sliding from here
+            if (f.landed && f.steps == 1) {
+                startSlide(i, f.position, f.velocity.x, f.startStep);
+                continue;
+            }
+            if (f.startStep + f.steps > horizonSteps) {
+                f.steps = horizonSteps - f.startStep;
+                f.end = flightAt(f, f.steps);
+                f.landed = false;
+            }
+
+            BallisticResult& r = results[i];
+            const uint32_t endStep = f.startStep + f.steps;
+            if (f.landed) {
+                if (!r.landed) {
+                    r.landed = true;
+                    r.landing = f.end;
+                    r.landingTime = static_cast<float>(endStep) * s.dt;
+                }
+                ++r.bounces;
+            }
+            if (s.keepFlights) {
+                passFlights.push_back(f);
+                passLaunch.push_back(i);
+            }
+
+            if (!f.landed || endStep >= horizonSteps || ++flightCount[i] == maxFlights) {
+                r.rest = f.end;
+                r.restTime = static_cast<float>(endStep) * s.dt;
+                continue;
+            }
+
+            px[kept] = px[k]; py[kept] = py[k];
+            vx[kept] = vx[k]; vy[kept] = vy[k];
+            e[kept] = e[k]; bottom[kept] = bottom[k];
+            laneLaunch[kept] = i;
+            laneStep[kept] = endStep;
+            ++kept;
+        }
+        active = kept;
+    }
+
+    // Passes append flights of many launches; group them by launch
+    flightStart.assign(count + 1, 0);
+    for (uint32_t i : passLaunch) ++flightStart[i + 1];
+    for (size_t i = 0; i < count; ++i) flightStart[i + 1] += flightStart[i];
+    flights.resize(passFlights.size());
+    flightCount.assign(flightStart.begin(), flightStart.end() - 1);
+    for (size_t k = 0; k < passFlights.size(); ++k) flights[flightCount[passLaunch[k]]++] = passFlights[k];
+}
+
+// Friction scales vx by 'keep' on every step in contact and snaps it to 0
+// below 1, so it stops after the first m with |vx| * keep^m < 1, having
+// moved vx * dt * (1 - keep^m) / (1 - keep)
+void BallisticBatch::startSlide(size_t launch, const sf::Vector2f& position, float vx0, uint32_t step) {
+    Slide& slide = slides[launch];
+    slide = { position, vx0, step, 0, true };
+
+    BallisticResult& r = results[launch];
+    if (!r.landed) {
+        r.landed = true;
+        r.landing = position;
+        r.landingTime = static_cast<float>(step) * settings.dt;
+    }
+
+    const float keep = std::clamp(1.f - settings.groundFriction, 0.f, 1.f);
+    const float speed = std::abs(vx0);
+    if (speed < 1.f) {
+        slide.steps = 0;
+    }
+    else if (keep >= 1.f) {
+        slide.steps = noStop;
+    }
+    else if (keep <= 0.f) {
+        slide.steps = 1;
+    }
+    else {
+        // The logarithm's estimate, nudged to the exact step
+        double m = std::floor(std::log(static_cast<double>(speed)) / -std::log(static_cast<double>(keep))) + 1.0;
+        while (m > 1.0 && speed * std::pow(keep, static_cast<float>(m - 1.0)) < 1.f) m -= 1.0;
+        while (speed * std::pow(keep, static_cast<float>(m)) >= 1.f) m += 1.0;
+        slide.steps = static_cast<uint32_t>(std::min(m, static_cast<double>(noStop - 1)));
+    }
+
+    const bool stops = slide.steps != noStop && static_cast<uint64_t>(step) + slide.steps <= horizonSteps;
+    r.rests = stops;
+    const uint32_t end = stops ? step + slide.steps : horizonSteps;
+    r.rest = slideAt(slide, end - step);
+    r.restTime = static_cast<float>(end) * settings.dt;
+}
+
+// --- Sampling ---
+sf::Vector2f BallisticBatch::flightAt(const BallisticFlight& f, uint32_t k) const {
+    // Same terms as advanceBallistic
+    const float a = 0.5f * settings.gravity * settings.dt * settings.dt;
+    const float b = f.velocity.y * settings.dt + a;
+    const float n = static_cast<float>(k);
+    return { f.position.x + n * (f.velocity.x * settings.dt), f.position.y + n * (b + a * n) };
+}
+
+sf::Vector2f BallisticBatch::slideAt(const Slide& s, uint32_t k) const {
+    const float keep = std::clamp(1.f - settings.groundFriction, 0.f, 1.f);
+    const uint32_t m = std::min(k, s.steps);
+    const float n = static_cast<float>(m);
+    const float travelled = keep >= 1.f ? n : (1.f - std::pow(keep, n)) / (1.f - keep);
+    return { s.position.x + s.vx * settings.dt * travelled, s.position.y };
+}
+
+sf::Vector2f BallisticBatch::positionAt(size_t launch, uint32_t step) const {
+    const Slide& slide = slides[launch];
+    if (slide.active && step >= slide.step) return slideAt(slide, std::min(step, horizonSteps) - slide.step);
+
+    const size_t count = getFlightCount(launch);
+    for (size_t k = 0; k < count; ++k) {
+        const BallisticFlight& f = getFlight(launch, k);
+        if (step < f.startStep + f.steps) return flightAt(f, step - f.startStep);
+    }
+    return count ? getFlight(launch, count - 1).end : launches[launch].position;
+}
+
+void BallisticBatch::samplePath(size_t launch, uint32_t stride, std::vector<sf::Vector2f>& points) const {
+    stride = std::max<uint32_t>(stride, 1);
+    points.push_back(launches[launch].position);
+    for (size_t k = 0; k < getFlightCount(launch); ++k) {
+        const BallisticFlight& f = getFlight(launch, k);
+        for (uint32_t n = stride; n < f.steps; n += stride) points.push_back(flightAt(f, n));
+        points.push_back(f.end);
+    }
+    // Sliding is a straight run along the ground
+    if (slides[launch].active) points.push_back(results[launch].rest);
+}
@@ -0,0 +1,112 @@
+#pragma once
+#include "World.hpp"
+#include <cstdint>
+#include <vector>
+
+// A body's state when its prediction starts
+struct BallisticLaunch {
+    sf::Vector2f position{};
+    sf::Vector2f velocity{};
+    float restitution = 0.5f;
+    float bottom = 0.f;        // from the position down to the bottom of the bounds (BodyStore::localMaxY)
+};
+
+struct BallisticSettings {
+    float dt = 1.f / 60.f;
+    float gravity = World::defaultGravity;
+    float groundY = 0.f;
+    float groundFriction = 0.f;
+    float horizon = 30.f;      // seconds predicted
+    uint32_t maxBounces = 16;  // flights per launch; the prediction stops after the last
+    bool keepFlights = true;   // false: results only, no getFlight/positionAt/samplePath
+
+    // The world's gravity, ground and friction at the stepper's dt
+    static BallisticSettings fromWorld(const World& world, float dt);
+};
+
+// One parabola of a path: from a launch or bounce to the next ground
+// contact, or to where the prediction stopped
+struct BallisticFlight {
+    sf::Vector2f position{};   // at the start
+    sf::Vector2f velocity{};   // at the start
+    sf::Vector2f end{};
+    uint32_t startStep = 0;
+    uint32_t steps = 0;
+    bool landed = false;       // 'end' is on the ground
+};
+
+struct BallisticResult {
+    bool landed = false;       // reached the ground within the horizon
+    sf::Vector2f landing{};    // the first ground contact
+    float landingTime = 0.f;
+    uint32_t bounces = 0;      // ground contacts before it starts sliding
+    bool rests = false;        // came to a stop within the horizon
+    sf::Vector2f rest{};       // where it stops, or where the prediction ends
+    float restTime = 0.f;
+};
+
+// ---------------------
+// Ground-only trajectory prediction for a batch of launches.
+//
+// Paths are the fixed-step integrator's, not the continuous parabola:
+// under semi-implicit Euler the position after n steps is a quadratic in
+// n, so each flight's landing step, point and bounce come out in closed
+// form (advanceBallistic) and every launch still in the air is advanced
+// one flight per pass, vectorised across the batch. Finished launches are
+// compacted out between passes. Once a body touches the ground on every
+// step it only slides, and friction's geometric decay gives its stop in
+// closed form too. Other bodies, contacts and sleeping are not modelled.
+// ---------------------
+class BallisticBatch {
+public:
+    void clear();
+    size_t add(const BallisticLaunch& launch);
+    // Body 'index' as it is now, with its restitution and bounds
+    size_t addBody(const World& world, size_t index);
+    size_t size() const { return launches.size(); }
+
+    void predict(const BallisticSettings& settings);
+
+    const BallisticResult& getResult(size_t launch) const { return results[launch]; }
+    size_t getFlightCount(size_t launch) const { return flightStart[launch + 1] - flightStart[launch]; }
+    const BallisticFlight& getFlight(size_t launch, size_t k) const { return flights[flightStart[launch] + k]; }
+
+    // Where the launch is after 'step' steps, held at its rest (or last
+    // predicted) position after the prediction ends
+    sf::Vector2f positionAt(size_t launch, uint32_t step) const;
+    // Every 'stride' steps from the launch to its rest, plus each contact
+    void samplePath(size_t launch, uint32_t stride, std::vector<sf::Vector2f>& points) const;
+
+private:
+    // Sliding from 'step' on; 'steps' until it stops, or noStop
+    struct Slide {
+        sf::Vector2f position{};
+        float vx = 0.f;
+        uint32_t step = 0;
+        uint32_t steps = 0;
+        bool active = false;
+    };
+
+    static constexpr uint32_t noStop = UINT32_MAX;
+
+    sf::Vector2f flightAt(const BallisticFlight& f, uint32_t k) const;
+    sf::Vector2f slideAt(const Slide& s, uint32_t k) const;
+    void startSlide(size_t launch, const sf::Vector2f& position, float vx, uint32_t step);
+
+private:
+    std::vector<BallisticLaunch> launches;
+    std::vector<BallisticResult> results;
+    std::vector<Slide> slides;
+    std::vector<BallisticFlight> flights;   // by launch: flightStart[i] .. flightStart[i + 1]
+    std::vector<uint32_t> flightStart;
+    BallisticSettings settings;
+    uint32_t horizonSteps = 0;
+
+    // Launches still in the air, one per lane, as kernel streams
+    AlignedVector<float> px, py, vx, vy, steps, landed, e, bottom;
+    std::vector<uint32_t> laneLaunch, laneStep;
+    AlignedVector<float> startX, startY, startVX, startVY;
+    std::vector<BallisticFlight> passFlights;
+    std::vector<uint32_t> passLaunch;
+    std::vector<uint32_t> flightCount;
+};
@@ -0,0 +1,164 @@
+#include "BatchRenderer.hpp"
+#include <algorithm>
+#include <cmath>
+
+BatchRenderer::BatchRenderer() {
+    useBuffers = sf::VertexBuffer::isAvailable();
+
+    // Same points as sf::CircleShape, starting at the top
+    const float pi = 3.14159265f;
+    for (size_t k = 0; k < circlePoints; ++k) {
+        const float angle = static_cast<float>(k) * 2.f * pi / static_cast<float>(circlePoints) - pi / 2.f;
+        circleDir[k] = { std::cos(angle), std::sin(angle) };
+    }
+    circleOutlineScale = 1.f / std::cos(pi / static_cast<float>(circlePoints));
+}
+
+// --- Bodies ---
+void BatchRenderer::beginBodies() {
+    bodyVertices.clear();
+}
+
+void BatchRenderer::addBody(const BodyStore& bodies, size_t i, const sf::Vector2f& position,
+                            const sf::Color& fill, const sf::Color& outline) {
+    const float t = BodyStore::outlineThickness;
+    const sf::Vector2f size = bodies.size[i];
+
+    sf::Vector2f inner[circlePoints];
+    sf::Vector2f outer[circlePoints];
+
+    switch (bodies.type[i]) {
+    case ObjectType::Circle: {
+        const float r = size.x;
+        const float ro = r + t * circleOutlineScale;
+        for (size_t k = 0; k < circlePoints; ++k) {
+            inner[k] = position + circleDir[k] * r;
+            outer[k] = position + circleDir[k] * ro;
+        }
+        appendPolygon(inner, outer, circlePoints, fill, outline);
+        break;
+    }
+    case ObjectType::Rectangle: {
+        const sf::Vector2f& p = position;
+        inner[0] = p;                                outer[0] = p + sf::Vector2f(-t, -t);
+        inner[1] = p + sf::Vector2f(size.x, 0.f);    outer[1] = p + sf::Vector2f(size.x + t, -t);
+        inner[2] = p + size;                         outer[2] = p + size + sf::Vector2f(t, t);
+        inner[3] = p + sf::Vector2f(0.f, size.y);    outer[3] = p + sf::Vector2f(-t, size.y + t);
+        appendPolygon(inner, outer, 4, fill, outline);
+        break;
+    }
+    case ObjectType::Triangle: {
+        inner[0] = position + sf::Vector2f(0.f, size.y);
+        inner[1] = position + sf::Vector2f(size.x / 2.f, 0.f);
+        inner[2] = position + size;
+
+        // Corner offsets as sf::Shape computes them: the sum of the two
+        // outward edge normals, stretched so each edge moves out by t
+        const sf::Vector2f centre = (inner[0] + inner[1] + inner[2]) / 3.f;
+        sf::Vector2f normal[3];
+        for (size_t k = 0; k < 3; ++k) {
+            const sf::Vector2f e = inner[(k + 1) % 3] - inner[k];
+            const float len = std::sqrt(e.x * e.x + e.y * e.y);
+            sf::Vector2f n = len > 0.f ? sf::Vector2f(e.y / len, -e.x / len) : sf::Vector2f();
+            const sf::Vector2f toEdge = inner[k] - centre;
+            if (n.x * toEdge.x + n.y * toEdge.y < 0.f) n = -n;
+            normal[k] = n;
+        }
+        for (size_t k = 0; k < 3; ++k) {
+            const sf::Vector2f& n1 = normal[(k + 2) % 3];
+            const sf::Vector2f& n2 = normal[k];
+            const float factor = 1.f + (n1.x * n2.x + n1.y * n2.y);
+            outer[k] = inner[k] + (n1 + n2) * (factor > 1e-6f ? t / factor : 0.f);
+        }
+        appendPolygon(inner, outer, 3, fill, outline);
+        break;
+    }
+    case ObjectType::None:
+    default:
+        break;
+    }
+}
+
+// Fan-triangulated fill followed by the outline ring between the two loops
+void BatchRenderer::appendPolygon(const sf::Vector2f* inner, const sf::Vector2f* outer, size_t n,
+                                  const sf::Color& fill, const sf::Color& outline) {
+    for (size_t k = 1; k + 1 < n; ++k) {
+        bodyVertices.emplace_back(inner[0], fill);
+        bodyVertices.emplace_back(inner[k], fill);
+        bodyVertices.emplace_back(inner[k + 1], fill);
+    }
+    for (size_t k = 0; k < n; ++k) {
+        const size_t next = (k + 1) % n;
+        bodyVertices.emplace_back(inner[k], outline);
+        bodyVertices.emplace_back(outer[k], outline);
+        bodyVertices.emplace_back(outer[next], outline);
+        bodyVertices.emplace_back(inner[k], outline);
+        bodyVertices.emplace_back(outer[next], outline);
+        bodyVertices.emplace_back(inner[next], outline);
+    }
+}
+
+void BatchRenderer::drawBodies(sf::RenderTarget& target) {
+    if (bodyVertices.empty()) return;
+    if (useBuffers) upload(bodyBuffer, bodyCapacity, bodyVertices);
+    submit(target, bodyBuffer, bodyVertices, sf::Triangles);
+}
+
+// --- Grid ---
+void BatchRenderer::drawGrid(sf::RenderTarget& target, const sf::FloatRect& viewRect, float spacing, const sf::Color& color) {
+    if (spacing <= 0.f) return;
+
+    const bool covered = gridArea.left <= viewRect.left && gridArea.top <= viewRect.top &&
+        viewRect.left + viewRect.width <= gridArea.left + gridArea.width &&
+        viewRect.top + viewRect.height <= gridArea.top + gridArea.height;
+
+    if (!gridValid || !covered || spacing != gridSpacing || color != gridColor) {
+        // Cover half a view more on every side so small pans and zooms reuse it
+        const float L = std::floor((viewRect.left - viewRect.width * 0.5f) / spacing) * spacing;
+        const float T = std::floor((viewRect.top - viewRect.height * 0.5f) / spacing) * spacing;
+        const float R = std::ceil((viewRect.left + viewRect.width * 1.5f) / spacing) * spacing;
+        const float B = std::ceil((viewRect.top + viewRect.height * 1.5f) / spacing) * spacing;
+
+        gridVertices.clear();
+        const int columns = static_cast<int>(std::lround((R - L) / spacing));
+        const int rows = static_cast<int>(std::lround((B - T) / spacing));
+        for (int c = 0; c <= columns; ++c) {
+            const float x = L + static_cast<float>(c) * spacing;
+            gridVertices.emplace_back(sf::Vector2f(x, T), color);
+            gridVertices.emplace_back(sf::Vector2f(x, B), color);
+        }
+        for (int r = 0; r <= rows; ++r) {
+            const float y = T + static_cast<float>(r) * spacing;
+            gridVertices.emplace_back(sf::Vector2f(L, y), color);
+            gridVertices.emplace_back(sf::Vector2f(R, y), color);
+        }
+
+        gridArea = { L, T, R - L, B - T };
+        gridSpacing = spacing;
+        gridColor = color;
+        gridValid = true;
+        if (useBuffers) upload(gridBuffer, gridCapacity, gridVertices);
+    }
+
+    submit(target, gridBuffer, gridVertices, sf::Lines);
+}
+
+// --- Submission ---
+void BatchRenderer::upload(sf::VertexBuffer& buffer, size_t& capacity, const std::vector<sf::Vertex>& vertices) {
+    if (vertices.size() > capacity) {
+        capacity = std::max(vertices.size(), capacity * 2);
+        if (!buffer.create(capacity)) {
+            useBuffers = false;
+            return;
+        }
+    }
+    if (!buffer.update(vertices.data(), vertices.size(), 0)) useBuffers = false;
+}
+
+void BatchRenderer::submit(sf::RenderTarget& target, const sf::VertexBuffer& buffer,
+                           const std::vector<sf::Vertex>& vertices, sf::PrimitiveType type) {
+    if (vertices.empty()) return;
+    if (useBuffers) target.draw(buffer, 0, vertices.size());
+    else target.draw(vertices.data(), vertices.size(), type);
+    ++drawCalls;
+}
@@ -0,0 +1,64 @@
+#pragma once
+#include <SFML/Graphics.hpp>
+#include "BodyStore.hpp"
+#include <vector>
+
+// ---------------------
+// Batched drawing of bodies and the background grid.
+//
+// Bodies are tessellated into one triangle list per frame (fill, then
+// outline, body by body so overlaps stack like individual shape draws)
+// and submitted with a single draw call. The grid is a line list built
+// for an area larger than the view and reused until the view leaves that
+// area or the spacing changes. Geometry goes through sf::VertexBuffer
+// when the driver supports it and plain vertex arrays otherwise.
+// ---------------------
+class BatchRenderer {
+public:
+    BatchRenderer();
+
+    // --- Bodies ---
+    void beginBodies();
+    // Body i of 'bodies' drawn at 'position' (same anchor as Body::position)
+    void addBody(const BodyStore& bodies, size_t i, const sf::Vector2f& position,
+                 const sf::Color& fill, const sf::Color& outline);
+    void drawBodies(sf::RenderTarget& target);
+
+    // --- Grid ---
+    void drawGrid(sf::RenderTarget& target, const sf::FloatRect& viewRect, float spacing, const sf::Color& color);
+
+    // Draw calls issued since the last resetStats()
+    unsigned getDrawCalls() const { return drawCalls; }
+    void resetStats() { drawCalls = 0; }
+
+    // Points used for circles, as sf::CircleShape's default
+    static constexpr size_t circlePoints = 30;
+
+private:
+    void appendPolygon(const sf::Vector2f* inner, const sf::Vector2f* outer, size_t n,
+                       const sf::Color& fill, const sf::Color& outline);
+    void upload(sf::VertexBuffer& buffer, size_t& capacity, const std::vector<sf::Vertex>& vertices);
+    void submit(sf::RenderTarget& target, const sf::VertexBuffer& buffer,
+                const std::vector<sf::Vertex>& vertices, sf::PrimitiveType type);
+
+private:
+    bool useBuffers = false;
+    unsigned drawCalls = 0;
+
+    // Unit circle directions and the outline offset that keeps each edge
+    // of the ring exactly one outline thickness out
+    sf::Vector2f circleDir[circlePoints];
+    float circleOutlineScale = 1.f;
+
+    std::vector<sf::Vertex> bodyVertices;
+    sf::VertexBuffer bodyBuffer{ sf::Triangles, sf::VertexBuffer::Stream };
+    size_t bodyCapacity = 0;
+
+    std::vector<sf::Vertex> gridVertices;
+    sf::VertexBuffer gridBuffer{ sf::Lines, sf::VertexBuffer::Static };
+    size_t gridCapacity = 0;
+    sf::FloatRect gridArea{};
+    float gridSpacing = 0.f;
+    sf::Color gridColor;
+    bool gridValid = false;
+};
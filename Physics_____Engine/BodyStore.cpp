@@ -0,0 +1,214 @@
+#include "BodyStore.hpp"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+namespace {
+    // Vertices are wound so that (e.y, -e.x) of each edge points outwards
+    void setPolygon(CollisionShape& s, const sf::Vector2f* v, int n) {
+        s.count = n;
+        for (int k = 0; k < n; ++k) {
+            s.vertices[k] = v[k];
+            const sf::Vector2f e = v[(k + 1) % n] - v[k];
+            const float len = std::sqrt(e.x * e.x + e.y * e.y);
+            s.normals[k] = len > 0.f ? sf::Vector2f(e.y / len, -e.x / len) : sf::Vector2f();
+        }
+    }
+}
+
+void BodyStore::reserve(size_t n) {
+    forEachArray([n](auto& a) { a.reserve(n); });
+}
+
+void BodyStore::clear() {
+    forEachArray([](auto& a) { a.clear(); });
+    rebuildSlots();
+    ++layoutRevision;
+}
+
+size_t BodyStore::push(const Body& body) {
+    forEachArray([](auto& a) { a.emplace_back(); });
+
+    const size_t i = count() - 1;
+    handle[i] = allocateHandle(static_cast<uint32_t>(i));
+    set(i, body);
+    return i;
+}
+
+size_t BodyStore::append(const BodyColumns& c) {
+    const size_t first = count();
+    const size_t n = c.count;
+    forEachArray([first, n](auto& a) { a.resize(first + n); });
+
+    std::copy(c.posX, c.posX + n, posX.begin() + first);
+    std::copy(c.posY, c.posY + n, posY.begin() + first);
+    std::copy(c.posX, c.posX + n, prevX.begin() + first);
+    std::copy(c.posY, c.posY + n, prevY.begin() + first);
+    std::copy(c.velX, c.velX + n, velX.begin() + first);
+    std::copy(c.velY, c.velY + n, velY.begin() + first);
+    std::copy(c.elasticity, c.elasticity + n, restitution.begin() + first);
+    std::fill(awake.begin() + first, awake.end(), uint8_t(1));
+
+    for (size_t k = 0; k < n; ++k) {
+        const size_t i = first + k;
+        handle[i] = allocateHandle(static_cast<uint32_t>(i));
+        invMass[i] = c.mass[k] > 0.f ? 1.f / c.mass[k] : 0.f;
+        const ObjectType t = c.type[k] <= static_cast<uint8_t>(ObjectType::Triangle) ? static_cast<ObjectType>(c.type[k]) : ObjectType::None;
+        setGeometry(i, t, { c.sizeX[k], c.sizeY[k] });
+    }
+    return first;
+}
+
+void BodyStore::erase(size_t i) {
+    if (i >= count()) return;
+    const size_t last = count() - 1;
+    ++layoutRevision;
+    slotIndex[handle[i].slot] = freeSlot;
+    freeSlots.push_back(handle[i].slot);
+
+    if (i != last) {
+        forEachArray([i, last](auto& a) { a[i] = a[last]; });
+        slotIndex[handle[i].slot] = static_cast<uint32_t>(i);
+    }
+    forEachArray([](auto& a) { a.pop_back(); });
+}
+
+// --- Handles ---
+BodyHandle BodyStore::allocateHandle(uint32_t index) {
+    uint32_t slot;
+    if (!freeSlots.empty()) {
+        slot = freeSlots.back();
+        freeSlots.pop_back();
+    }
+    else {
+        slot = static_cast<uint32_t>(slotIndex.size());
+        slotIndex.push_back(freeSlot);
+        nextGeneration.push_back(0);
+    }
+    slotIndex[slot] = index;
+    return { slot, nextGeneration[slot]++ };
+}
+
+// Derives the slot map from the bodies' handles (after clear() or a
+// restore); free slots are reused lowest first
+void BodyStore::rebuildSlots() {
+    size_t slots = slotIndex.size();
+    for (const BodyHandle& h : handle) slots = std::max<size_t>(slots, size_t(h.slot) + 1);
+    slotIndex.assign(slots, freeSlot);
+    nextGeneration.resize(slots, 0);
+
+    for (size_t i = 0; i < handle.size(); ++i) {
+        const BodyHandle h = handle[i];
+        slotIndex[h.slot] = static_cast<uint32_t>(i);
+        nextGeneration[h.slot] = std::max(nextGeneration[h.slot], h.generation + 1);
+    }
+    freeSlots.clear();
+    for (size_t s = slots; s-- > 0;) {
+        if (slotIndex[s] == freeSlot) freeSlots.push_back(static_cast<uint32_t>(s));
+    }
+}
+
+size_t BodyStore::rawSize() const {
+    size_t bytes = 0;
+    forEachStateArray([&bytes](const auto& a) { bytes += a.size() * sizeof(a[0]); });
+    return bytes;
+}
+
+void BodyStore::saveRaw(uint8_t* out) const {
+    forEachStateArray([&out](const auto& a) {
+        const size_t bytes = a.size() * sizeof(a[0]);
+        if (bytes) std::memcpy(out, a.data(), bytes);
+        out += bytes;
+    });
+}
+
+bool BodyStore::loadRaw(const uint8_t* in, size_t n) {
+    bool changed = n != count();
+    forEachStateArray([&](auto& a) {
+        const size_t bytes = n * sizeof(a[0]);
+        const void* array = &a;
+        const bool identity = array == &type || array == &size || array == &handle;
+        if (identity && !changed) changed = bytes && std::memcmp(a.data(), in, bytes) != 0;
+        a.resize(n);
+        if (bytes) std::memcpy(a.data(), in, bytes);
+        in += bytes;
+    });
+
+    localShape.resize(n);
+    if (changed) {
+        ++layoutRevision;
+        for (size_t i = 0; i < n; ++i) setGeometry(i, type[i], size[i]);
+        rebuildSlots();
+    }
+    return changed;
+}
+
+Body BodyStore::get(size_t i) const {
+    Body body;
+    body.type = type[i];
+    body.position = { posX[i], posY[i] };
+    body.size = size[i];
+    body.velocity = { velX[i], velY[i] };
+    body.elasticity = restitution[i];
+    body.mass = invMass[i] > 0.f ? 1.f / invMass[i] : 0.f;
+    body.fast = fast[i] != 0;
+    return body;
+}
+
+void BodyStore::set(size_t i, const Body& body) {
+    posX[i] = prevX[i] = body.position.x;
+    posY[i] = prevY[i] = body.position.y;
+    velX[i] = body.velocity.x;
+    velY[i] = body.velocity.y;
+    invMass[i] = body.mass > 0.f ? 1.f / body.mass : 0.f;
+    restitution[i] = body.elasticity;
+    awake[i] = 1;
+    fast[i] = body.fast ? 1 : 0;
+    sleepTimer[i] = 0.f;
+    ++layoutRevision;
+    setGeometry(i, body.type, body.size);
+}
+
+void BodyStore::setGeometry(size_t i, ObjectType t, const sf::Vector2f& s) {
+    type[i] = t;
+    size[i] = s;
+    ++layoutRevision;
+
+    const float o = outlineThickness;
+    CollisionShape& shape = localShape[i];
+    shape = CollisionShape();
+    switch (t) {
+    case ObjectType::Circle:
+        localMinX[i] = localMinY[i] = -s.x - o;
+        localMaxX[i] = localMaxY[i] = s.x + o;
+        shape.count = 1;
+        shape.radius = s.x + o;
+        break;
+    case ObjectType::Rectangle: {
+        localMinX[i] = -o;
+        localMinY[i] = -o;
+        localMaxX[i] = s.x + o;
+        localMaxY[i] = s.y + o;
+        const sf::Vector2f v[4] = { {}, { s.x, 0.f }, s, { 0.f, s.y } };
+        setPolygon(shape, v, 4);
+        shape.radius = o;
+        break;
+    }
+    case ObjectType::Triangle: {
+        localMinX[i] = -o;
+        localMinY[i] = -o;
+        localMaxX[i] = s.x + o;
+        localMaxY[i] = s.y + o;
+        const sf::Vector2f v[3] = { { 0.f, s.y }, { s.x / 2.f, 0.f }, s };
+        setPolygon(shape, v, 3);
+        shape.radius = o;
+        break;
+    }
+    case ObjectType::None:
+    default:
+        localMinX[i] = localMinY[i] = localMaxX[i] = localMaxY[i] = 0.f;
+        shape.count = 1;
+        break;
+    }
+    refreshBounds(i);
+}
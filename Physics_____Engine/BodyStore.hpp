@@ -0,0 +1,225 @@
+#pragma once
+#include <SFML/System/Vector2.hpp>
+#include <SFML/Graphics/Rect.hpp>
+#include <cstddef>
+#include <cstdint>
+#include <new>
+#include <vector>
+
+enum class ObjectType { None, Circle, Rectangle, Triangle };
+
+// ---------------------
+// Plain description of one body, used to add, read back and edit bodies.
+// ---------------------
+struct Body {
+    ObjectType type = ObjectType::None;
+    // Same anchor as the SFML shape: centre for circles, top-left otherwise
+    sf::Vector2f position{};
+    // Radius (x) for circles, width/height for rectangles and triangles
+    sf::Vector2f size{};
+    sf::Vector2f velocity{};
+    float elasticity = 0.5f;
+    float mass = 1.f;
+    // Swept against the other bodies every step so it cannot tunnel
+    // through them (see World::setContinuousThreshold). Not kept in scene
+    // files.
+    bool fast = false;
+};
+
+// ---------------------
+// Column view of many bodies (one array per field), for bulk loading
+// straight from a mapped scene file. Types use the ObjectType values.
+// ---------------------
+struct BodyColumns {
+    size_t count = 0;
+    const uint8_t* type = nullptr;
+    const float* posX = nullptr;
+    const float* posY = nullptr;
+    const float* sizeX = nullptr;
+    const float* sizeY = nullptr;
+    const float* velX = nullptr;
+    const float* velY = nullptr;
+    const float* mass = nullptr;
+    const float* elasticity = nullptr;
+};
+
+// ---------------------
+// Stable reference to a body. A body's index changes when another body is
+// removed (the last one moves into the gap); its handle does not. Once the
+// body is gone the handle stays invalid for good: every slot counts how
+// often it was handed out, and a handle only matches the generation it
+// was made with.
+// ---------------------
+struct BodyHandle {
+    uint32_t slot = UINT32_MAX;
+    uint32_t generation = 0;
+
+    bool operator==(const BodyHandle&) const = default;
+};
+
+// ---------------------
+// Convex core (a point for circles) grown by a radius; see Collision.hpp.
+// BodyStore keeps one per body relative to its position, and the world
+// shape is that translated.
+// ---------------------
+struct CollisionShape {
+    sf::Vector2f vertices[4];
+    sf::Vector2f normals[4];    // outward normal of edge i -> i+1
+    int count = 0;              // 1 for circles
+    float radius = 0.f;
+};
+
+// ---------------------
+// Allocator that hands out cache-line aligned blocks so every hot array
+// starts on a 64-byte boundary (and is safe for aligned SIMD loads).
+// ---------------------
+template <typename T, size_t Align = 64>
+struct AlignedAllocator {
+    using value_type = T;
+
+    template <typename U> struct rebind { using other = AlignedAllocator<U, Align>; };
+
+    AlignedAllocator() = default;
+    template <typename U> AlignedAllocator(const AlignedAllocator<U, Align>&) {}
+
+    T* allocate(size_t n) {
+        return static_cast<T*>(::operator new(n * sizeof(T), std::align_val_t(Align)));
+    }
+    void deallocate(T* p, size_t) {
+        ::operator delete(p, std::align_val_t(Align));
+    }
+
+    template <typename U> bool operator==(const AlignedAllocator<U, Align>&) const { return true; }
+    template <typename U> bool operator!=(const AlignedAllocator<U, Align>&) const { return false; }
+};
+
+template <typename T>
+using AlignedVector = std::vector<T, AlignedAllocator<T>>;
+
+// ---------------------
+// Structure-of-arrays body storage. Index i in every array is body i.
+// The arrays are dense: removing a body moves the last one into its
+// index, so removal is O(1) and loops never skip holes. A slot map
+// (slotIndex) takes each body's handle to its current index.
+//
+// Hot:  position, velocity, inverse mass, restitution, world bounds and
+//       the position before the last step (for render interpolation)
+// Warm: shape type and the bounds and collision shape relative to the
+//       position, sleep state, continuous collision flag
+//
+// The relative bounds and shape only change when a body is created or
+// resized (setGeometry), so moving a body is a few adds: refreshBounds()
+// for the bounds and a translation for the shape. The world bounds are
+// kept current by whatever moves the body (the integrator, the solver,
+// set()), so every reader (broadphase, tree, picking, culling) uses them
+// as they are.
+// ---------------------
+struct BodyStore {
+    // Hot
+    AlignedVector<float> posX, posY;
+    AlignedVector<float> prevX, prevY;
+    AlignedVector<float> velX, velY;
+    AlignedVector<float> invMass;
+    AlignedVector<float> restitution;
+    AlignedVector<float> minX, minY, maxX, maxY;
+
+    // Warm
+    std::vector<ObjectType> type;
+    std::vector<sf::Vector2f> size;
+    AlignedVector<float> localMinX, localMinY, localMaxX, localMaxY;
+    std::vector<CollisionShape> localShape;
+    std::vector<uint8_t> awake;          // 1 = simulated, 0 = asleep
+    std::vector<uint8_t> fast;           // 1 = continuous collision
+    AlignedVector<float> sleepTimer;     // seconds spent below the sleep speed
+    std::vector<BodyHandle> handle;
+
+    static constexpr size_t noBody = SIZE_MAX;
+
+    // Drawn outline; bounds include it, like sf::Shape::getGlobalBounds
+    static constexpr float outlineThickness = 3.f;
+
+    size_t count() const { return posX.size(); }
+
+    void reserve(size_t n);
+    void clear();
+    size_t push(const Body& body);
+    // Appends every body of 'columns' with one copy per array; returns the
+    // index of the first
+    size_t append(const BodyColumns& columns);
+    // The last body moves into index i
+    void erase(size_t i);
+
+    // Current index of the body, or noBody if it was removed
+    size_t indexOf(BodyHandle h) const {
+        if (h.slot >= slotIndex.size()) return noBody;
+        const uint32_t i = slotIndex[h.slot];
+        return i != freeSlot && handle[i].generation == h.generation ? i : noBody;
+    }
+
+    // Every state array copied out back to back, one memcpy each
+    // (snapshots); the local shapes are derived, so loadRaw rebuilds them
+    // if the sizes changed. rawSize() is the byte count saveRaw() writes.
+    size_t rawSize() const;
+    void saveRaw(uint8_t* out) const;
+    // Replaces the contents with n bodies written by saveRaw(). Returns
+    // true if the bodies changed (count, handles, types or sizes), not
+    // just their state. Restored bodies get their handles back.
+    bool loadRaw(const uint8_t* in, size_t n);
+
+    Body get(size_t i) const;
+    void set(size_t i, const Body& body);
+
+    // Re-derives the world bounds of body i from its position
+    void refreshBounds(size_t i) {
+        minX[i] = posX[i] + localMinX[i];
+        minY[i] = posY[i] + localMinY[i];
+        maxX[i] = posX[i] + localMaxX[i];
+        maxY[i] = posY[i] + localMaxY[i];
+    }
+
+    // Middle of the bounds; where joints attach
+    sf::Vector2f centre(size_t i) const {
+        return { (minX[i] + maxX[i]) * 0.5f, (minY[i] + maxY[i]) * 0.5f };
+    }
+
+    sf::FloatRect bounds(size_t i) const {
+        return { minX[i], minY[i], maxX[i] - minX[i], maxY[i] - minY[i] };
+    }
+
+    // Changes whenever a body is added, removed or set, or its shape
+    // changes (anything besides its motion), so readers that cache the
+    // layout (recordings) notice a swap that keeps the count
+    uint64_t getLayoutRevision() const { return layoutRevision; }
+
+private:
+    void setGeometry(size_t i, ObjectType t, const sf::Vector2f& s);
+    BodyHandle allocateHandle(uint32_t index);
+    void rebuildSlots();
+
+    static constexpr uint32_t freeSlot = UINT32_MAX;
+
+    // By slot: the index of its body (or freeSlot), and the generation
+    // the next body put there gets. Generations only ever grow, across
+    // clear() and snapshot restores too, so no handle is issued twice.
+    std::vector<uint32_t> slotIndex;
+    std::vector<uint32_t> nextGeneration;
+    std::vector<uint32_t> freeSlots;
+    uint64_t layoutRevision = 0;
+
+    template <typename F> void forEachArray(F f) { visitStateArrays(*this, f); f(localShape); }
+    template <typename F> void forEachStateArray(F f) { visitStateArrays(*this, f); }
+    template <typename F> void forEachStateArray(F f) const { visitStateArrays(*this, f); }
+
+    template <typename Store, typename F>
+    static void visitStateArrays(Store& s, F& f) {
+        for (auto* a : { &s.posX, &s.posY, &s.prevX, &s.prevY, &s.velX, &s.velY, &s.invMass, &s.restitution,
+                         &s.minX, &s.minY, &s.maxX, &s.maxY, &s.localMinX, &s.localMinY, &s.localMaxX, &s.localMaxY,
+                         &s.sleepTimer })
+            f(*a);
+        f(s.awake);
+        f(s.fast);
+        f(s.type);
+        f(s.size);
+        f(s.handle);
+    }
+};
@@ -0,0 +1,106 @@
+#include "Broadphase.hpp"
+#include <algorithm>
+#include <cmath>
+
+int32_t Broadphase::cellOf(float v) const {
+    return static_cast<int32_t>(std::floor(v * invCellSize));
+}
+
+uint32_t Broadphase::bucketOf(int32_t cx, int32_t cy) const {
+    const uint32_t h = static_cast<uint32_t>(cx) * 73856093u ^ static_cast<uint32_t>(cy) * 19349663u;
+    return h & bucketMask;
+}
+
+void Broadphase::findPairs(const BodyStore& bodies, std::vector<Pair>& pairs) {
+    pairs.clear();
+    const size_t n = bodies.count();
+    if (n < 2) return;
+
+    const float* minX = bodies.minX.data();
+    const float* minY = bodies.minY.data();
+    const float* maxX = bodies.maxX.data();
+    const float* maxY = bodies.maxY.data();
+    const uint8_t* awake = bodies.awake.data();
+
+    // Cell size: fixed, or twice the mean body extent
+    activeCellSize = cellSize;
+    if (activeCellSize <= 0.f) {
+        double extent = 0.0;
+        for (size_t i = 0; i < n; ++i)
+            extent += std::max(maxX[i] - minX[i], maxY[i] - minY[i]);
+        activeCellSize = std::max(1.f, static_cast<float>(2.0 * extent / static_cast<double>(n)));
+    }
+    invCellSize = 1.f / activeCellSize;
+
+    // Bin the awake bodies into the cells their bounds cover
+    entries.clear();
+    size_t awakeCount = 0;
+    for (size_t i = 0; i < n; ++i) {
+        if (!awake[i]) continue;
+        ++awakeCount;
+        const int32_t x0 = cellOf(minX[i]), x1 = cellOf(maxX[i]);
+        const int32_t y0 = cellOf(minY[i]), y1 = cellOf(maxY[i]);
+        for (int32_t cy = y0; cy <= y1; ++cy)
+            for (int32_t cx = x0; cx <= x1; ++cx)
+                entries.push_back({ cx, cy, static_cast<uint32_t>(i) });
+    }
+    if (entries.empty()) return;
+
+    uint32_t buckets = 1;
+    while (buckets < (entries.size() + (n - awakeCount)) * 2) buckets <<= 1;
+    bucketMask = buckets - 1;
+
+    // Sleepers only need binning where an awake body could reach them
+    if (awakeCount < n) {
+        awakeBucket.assign(buckets, 0);
+        for (const Entry& e : entries) awakeBucket[bucketOf(e.cx, e.cy)] = 1;
+
+        for (size_t i = 0; i < n; ++i) {
+            if (awake[i]) continue;
+            const int32_t x0 = cellOf(minX[i]), x1 = cellOf(maxX[i]);
+            const int32_t y0 = cellOf(minY[i]), y1 = cellOf(maxY[i]);
+            for (int32_t cy = y0; cy <= y1; ++cy)
+                for (int32_t cx = x0; cx <= x1; ++cx)
+                    if (awakeBucket[bucketOf(cx, cy)])
+                        entries.push_back({ cx, cy, static_cast<uint32_t>(i) });
+        }
+    }
+
+    // Counting sort of the entries into hash buckets
+
+    bucketStart.assign(buckets + 1, 0);
+    for (const Entry& e : entries) ++bucketStart[bucketOf(e.cx, e.cy) + 1];
+    for (uint32_t b = 0; b < buckets; ++b) bucketStart[b + 1] += bucketStart[b];
+
+    // Scatter using bucketStart as the write cursor, then shift it back
+    sorted.resize(entries.size());
+    for (const Entry& e : entries) sorted[bucketStart[bucketOf(e.cx, e.cy)]++] = e;
+    for (uint32_t b = buckets; b > 0; --b) bucketStart[b] = bucketStart[b - 1];
+    bucketStart[0] = 0;
+
+    // Test bodies that share a cell
+    for (uint32_t b = 0; b < buckets; ++b) {
+        const uint32_t begin = bucketStart[b], end = bucketStart[b + 1];
+        for (uint32_t p = begin; p < end; ++p) {
+            const Entry& ep = sorted[p];
+            for (uint32_t q = p + 1; q < end; ++q) {
+                const Entry& eq = sorted[q];
+                if (ep.cx != eq.cx || ep.cy != eq.cy) continue;
+
+                const uint32_t i = ep.body, j = eq.body;
+                if (!awake[i] && !awake[j]) continue;
+
+                const float ox = std::max(minX[i], minX[j]);
+                const float oy = std::max(minY[i], minY[j]);
+                if (!(ox < std::min(maxX[i], maxX[j]) && oy < std::min(maxY[i], maxY[j]))) continue;
+
+                // Report only from the cell owning the overlap's top-left corner
+                if (cellOf(ox) != ep.cx || cellOf(oy) != ep.cy) continue;
+
+                pairs.push_back(i < j ? Pair{ i, j } : Pair{ j, i });
+            }
+        }
+    }
+
+    std::sort(pairs.begin(), pairs.end());
+}
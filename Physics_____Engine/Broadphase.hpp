@@ -0,0 +1,46 @@
+#pragma once
+#include "BodyStore.hpp"
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+// ---------------------
+// Uniform spatial-hash broadphase. Every body is binned into each grid
+// cell its bounds touch; only bodies sharing a cell are tested, and a pair
+// is reported once, from the cell holding the top-left corner of the
+// overlap. Rebuilt from the cached bounds every step.
+// ---------------------
+class Broadphase {
+public:
+    using Pair = std::pair<uint32_t, uint32_t>;
+
+    // 0 picks a cell size from the average body size on every rebuild
+    void setCellSize(float size) { cellSize = size; }
+    float getCellSize() const { return cellSize; }
+    float getEffectiveCellSize() const { return activeCellSize; }
+
+    // Fills 'pairs' with overlapping (i < j) index pairs, sorted. Pairs of
+    // two sleeping bodies are skipped, and sleepers are only binned into
+    // cells an awake body touches, so a resting pile costs little.
+    void findPairs(const BodyStore& bodies, std::vector<Pair>& pairs);
+
+private:
+    struct Entry {
+        int32_t cx, cy;
+        uint32_t body;
+    };
+
+    int32_t cellOf(float v) const;
+    uint32_t bucketOf(int32_t cx, int32_t cy) const;
+
+private:
+    float cellSize = 0.f;
+    float activeCellSize = 64.f;
+    float invCellSize = 1.f / 64.f;
+
+    uint32_t bucketMask = 0;
+    std::vector<Entry> entries;
+    std::vector<Entry> sorted;
+    std::vector<uint32_t> bucketStart;
+    std::vector<uint8_t> awakeBucket;
+};
@@ -0,0 +1,322 @@
+#include "Collision.hpp"
+#include <algorithm>
+#include <cmath>
+
+namespace {
+
+float dot(const sf::Vector2f& a, const sf::Vector2f& b) { return a.x * b.x + a.y * b.y; }
+
+sf::Vector2f normalize(const sf::Vector2f& v) {
+    const float len = std::sqrt(dot(v, v));
+    return len > 0.f ? v / len : sf::Vector2f();
+}
+
+// --- Circle vs circle ---
+bool circleCircle(const CollisionShape& a, const CollisionShape& b, Manifold& m) {
+    const sf::Vector2f d = b.vertices[0] - a.vertices[0];
+    const float r = a.radius + b.radius;
+    const float dist2 = dot(d, d);
+    if (dist2 > r * r) return false;
+
+    const float dist = std::sqrt(dist2);
+    m.normal = dist > 0.f ? d / dist : sf::Vector2f(0.f, 1.f);
+    const sf::Vector2f onA = a.vertices[0] + m.normal * a.radius;
+    const sf::Vector2f onB = b.vertices[0] - m.normal * b.radius;
+    m.points[0].point = 0.5f * (onA + onB);
+    m.points[0].penetration = r - dist;
+    m.points[0].id = 0;
+    m.pointCount = 1;
+    return true;
+}
+
+// --- Polygon vs circle (normal from the polygon to the circle) ---
+bool polygonCircle(const CollisionShape& poly, const CollisionShape& circle, Manifold& m) {
+    const sf::Vector2f c = circle.vertices[0];
+    const float radius = poly.radius + circle.radius;
+
+    // Face of least penetration
+    int face = 0;
+    float separation = -1e30f;
+    for (int k = 0; k < poly.count; ++k) {
+        const float s = dot(poly.normals[k], c - poly.vertices[k]);
+        if (s > radius) return false;
+        if (s > separation) {
+            separation = s;
+            face = k;
+        }
+    }
+
+    const sf::Vector2f v1 = poly.vertices[face];
+    const sf::Vector2f v2 = poly.vertices[(face + 1) % poly.count];
+
+    sf::Vector2f normal;
+    sf::Vector2f onPoly;
+    uint32_t id;
+    float dist;
+    if (separation < 1e-6f) {
+        // Centre inside the polygon
+        normal = poly.normals[face];
+        dist = separation;
+        onPoly = c - normal * separation;
+        id = static_cast<uint32_t>(face);
+    }
+    else if (dot(c - v1, v2 - v1) <= 0.f) {
+        const sf::Vector2f d = c - v1;
+        dist = std::sqrt(dot(d, d));
+        if (dist > radius) return false;
+        normal = dist > 0.f ? d / dist : poly.normals[face];
+        onPoly = v1;
+        id = 0x100u | static_cast<uint32_t>(face);
+    }
+    else if (dot(c - v2, v1 - v2) <= 0.f) {
+        const sf::Vector2f d = c - v2;
+        dist = std::sqrt(dot(d, d));
+        if (dist > radius) return false;
+        normal = dist > 0.f ? d / dist : poly.normals[face];
+        onPoly = v2;
+        id = 0x100u | static_cast<uint32_t>((face + 1) % poly.count);
+    }
+    else {
+        normal = poly.normals[face];
+        dist = separation;
+        onPoly = c - normal * separation;
+        id = static_cast<uint32_t>(face);
+    }
+
+    const sf::Vector2f onA = onPoly + normal * poly.radius;
+    const sf::Vector2f onB = c - normal * circle.radius;
+    m.normal = normal;
+    m.points[0].point = 0.5f * (onA + onB);
+    m.points[0].penetration = radius - dist;
+    m.points[0].id = id;
+    m.pointCount = 1;
+    return true;
+}
+
+// --- Polygon vs polygon ---
+
+// Largest separation of b from any face of a, and that face
+float maxSeparation(const CollisionShape& a, const CollisionShape& b, int& face) {
+    float best = -1e30f;
+    face = 0;
+    for (int k = 0; k < a.count; ++k) {
+        float s = 1e30f;
+        for (int j = 0; j < b.count; ++j)
+            s = std::min(s, dot(a.normals[k], b.vertices[j] - a.vertices[k]));
+        if (s > best) {
+            best = s;
+            face = k;
+        }
+    }
+    return best;
+}
+
+struct ClipVertex {
+    sf::Vector2f v;
+    uint32_t id;
+};
+
+// Keeps the part of the segment on the negative side of dot(normal, x) = offset
+int clipSegment(ClipVertex out[2], const ClipVertex in[2], const sf::Vector2f& normal, float offset, uint32_t clipId) {
+    int n = 0;
+    const float d0 = dot(normal, in[0].v) - offset;
+    const float d1 = dot(normal, in[1].v) - offset;
+    if (d0 <= 0.f) out[n++] = in[0];
+    if (d1 <= 0.f) out[n++] = in[1];
+    if (d0 * d1 < 0.f) {
+        const float t = d0 / (d0 - d1);
+        out[n].v = in[0].v + t * (in[1].v - in[0].v);
+        out[n].id = clipId;
+        ++n;
+    }
+    return n;
+}
+
+bool polygonPolygon(const CollisionShape& a, const CollisionShape& b, Manifold& m) {
+    const float totalRadius = a.radius + b.radius;
+
+    int faceA, faceB;
+    const float sepA = maxSeparation(a, b, faceA);
+    if (sepA > totalRadius) return false;
+    const float sepB = maxSeparation(b, a, faceB);
+    if (sepB > totalRadius) return false;
+
+    // Prefer a as the reference unless b is clearly better, so the choice
+    // does not flicker between steps
+    const bool flip = sepB > sepA + 0.05f;
+    const CollisionShape& ref = flip ? b : a;
+    const CollisionShape& inc = flip ? a : b;
+    const int refFace = flip ? faceB : faceA;
+
+    const sf::Vector2f normal = ref.normals[refFace];
+
+    // Incident face: the one most anti-parallel to the reference normal
+    int incFace = 0;
+    float minDot = 1e30f;
+    for (int k = 0; k < inc.count; ++k) {
+        const float d = dot(normal, inc.normals[k]);
+        if (d < minDot) {
+            minDot = d;
+            incFace = k;
+        }
+    }
+
+    const uint32_t base = (flip ? 0x10000u : 0u) | static_cast<uint32_t>(refFace) << 8;
+    ClipVertex incident[2] = {
+        { inc.vertices[incFace], base | static_cast<uint32_t>(incFace) },
+        { inc.vertices[(incFace + 1) % inc.count], base | static_cast<uint32_t>((incFace + 1) % inc.count) }
+    };
+
+    const sf::Vector2f v1 = ref.vertices[refFace];
+    const sf::Vector2f v2 = ref.vertices[(refFace + 1) % ref.count];
+    const sf::Vector2f tangent = normalize(v2 - v1);
+
+    // Clip to the side planes of the reference face
+    ClipVertex clip1[2], clip2[2];
+    if (clipSegment(clip1, incident, -tangent, -dot(tangent, v1) + totalRadius, base | 0x80u) < 2) return false;
+    if (clipSegment(clip2, clip1, tangent, dot(tangent, v2) + totalRadius, base | 0x81u) < 2) return false;
+
+    m.normal = flip ? -normal : normal;
+    m.pointCount = 0;
+    const float frontOffset = dot(normal, v1);
+    for (const ClipVertex& cv : clip2) {
+        const float s = dot(normal, cv.v) - frontOffset;
+        if (s > totalRadius) continue;
+
+        const sf::Vector2f onRef = cv.v + (ref.radius - s) * normal;
+        const sf::Vector2f onInc = cv.v - inc.radius * normal;
+        ContactPoint& p = m.points[m.pointCount++];
+        p.point = 0.5f * (onRef + onInc);
+        p.penetration = totalRadius - s;
+        p.id = cv.id;
+    }
+    return m.pointCount > 0;
+}
+
+// --- Distance ---
+// Closest point to p on segment ab
+sf::Vector2f closestOnSegment(const sf::Vector2f& p, const sf::Vector2f& a, const sf::Vector2f& b) {
+    const sf::Vector2f ab = b - a;
+    const float len2 = dot(ab, ab);
+    const float t = len2 > 0.f ? std::clamp(dot(p - a, ab) / len2, 0.f, 1.f) : 0.f;
+    return a + ab * t;
+}
+
+bool coreContains(const CollisionShape& s, const sf::Vector2f& p) {
+    if (s.count < 3) return false;
+    for (int k = 0; k < s.count; ++k)
+        if (dot(p - s.vertices[k], s.normals[k]) > 0.f) return false;
+    return true;
+}
+
+// Closest pair of points between the cores, checked vertex against edge
+// both ways; with at most four edges each that is cheaper than GJK.
+// Returns the squared distance, or -1 if the cores overlap.
+float coreDistance2(const CollisionShape& a, const CollisionShape& b, sf::Vector2f& onA, sf::Vector2f& onB) {
+    if (coreContains(a, b.vertices[0]) || coreContains(b, a.vertices[0])) return -1.f;
+
+    float best = -1.f;
+    auto consider = [&](const sf::Vector2f& p, const sf::Vector2f& q) {
+        const sf::Vector2f d = q - p;
+        const float d2 = dot(d, d);
+        if (best < 0.f || d2 < best) {
+            best = d2;
+            onA = p;
+            onB = q;
+        }
+    };
+    for (int i = 0; i < a.count; ++i) {
+        const sf::Vector2f& p = a.vertices[i];
+        for (int k = 0; k < b.count; ++k) consider(p, closestOnSegment(p, b.vertices[k], b.vertices[(k + 1) % b.count]));
+    }
+    for (int i = 0; i < b.count; ++i) {
+        const sf::Vector2f& q = b.vertices[i];
+        for (int k = 0; k < a.count; ++k) consider(closestOnSegment(q, a.vertices[k], a.vertices[(k + 1) % a.count]), q);
+    }
+
+    // Two polygons can cross without either holding a vertex of the
+    // other; the edges intersect then
+    if (a.count > 1 && b.count > 1) {
+        bool separated = false;
+        for (int pass = 0; pass < 2 && !separated; ++pass) {
+            const CollisionShape& s = pass ? b : a;
+            const CollisionShape& o = pass ? a : b;
+            for (int k = 0; k < s.count && !separated; ++k) {
+                float minProj = dot(o.vertices[0] - s.vertices[k], s.normals[k]);
+                for (int v = 1; v < o.count; ++v) minProj = std::min(minProj, dot(o.vertices[v] - s.vertices[k], s.normals[k]));
+                separated = minProj > 0.f;
+            }
+        }
+        if (!separated) return -1.f;
+    }
+    return best;
+}
+
+} // namespace
+
+CollisionShape makeCollisionShape(const BodyStore& bodies, size_t i) {
+    CollisionShape s = bodies.localShape[i];
+    translateShape(s, { bodies.posX[i], bodies.posY[i] });
+    return s;
+}
+
+bool collideShapes(const CollisionShape& a, const CollisionShape& b, Manifold& manifold) {
+    manifold.pointCount = 0;
+    if (a.count == 1 && b.count == 1) return circleCircle(a, b, manifold);
+    if (b.count == 1) return polygonCircle(a, b, manifold);
+    if (a.count == 1) {
+        if (!polygonCircle(b, a, manifold)) return false;
+        manifold.normal = -manifold.normal;
+        return true;
+    }
+    return polygonPolygon(a, b, manifold);
+}
+
+void translateShape(CollisionShape& s, const sf::Vector2f& offset) {
+    for (int k = 0; k < s.count; ++k) s.vertices[k] += offset;
+}
+
+float shapeDistance(const CollisionShape& a, const CollisionShape& b, sf::Vector2f& normal, sf::Vector2f& point) {
+    sf::Vector2f onA, onB;
+    const float d2 = coreDistance2(a, b, onA, onB);
+    if (d2 <= 0.f) {
+        normal = sf::Vector2f();
+        point = onA;
+        return -(a.radius + b.radius);
+    }
+    const float d = std::sqrt(d2);
+    normal = (onB - onA) / d;
+    const float gap = d - a.radius - b.radius;
+    point = onA + normal * (a.radius + 0.5f * gap);
+    return gap;
+}
+
+// --- Time of impact ---
+float timeOfImpact(const CollisionShape& a, const sf::Vector2f& da, const CollisionShape& b, const sf::Vector2f& db,
+                   float slop, sf::Vector2f& normal, sf::Vector2f& point) {
+    // In b's frame only a moves
+    const sf::Vector2f d = da - db;
+    const float length = std::sqrt(dot(d, d));
+    if (length <= 0.f) return -1.f;
+
+    const int maxIterations = 20;
+    const float target = 0.5f * slop;
+    CollisionShape moved = a;
+    float t = 0.f;
+    for (int iteration = 0; iteration < maxIterations; ++iteration) {
+        const float gap = shapeDistance(moved, b, normal, point);
+        if (gap <= slop) return iteration == 0 ? -1.f : t;
+
+        // Closing speed along the normal, per whole step
+        const float closing = dot(d, normal);
+        if (closing <= 1e-6f * length) return -1.f;
+        t += (gap - target) / closing;
+        if (t > 1.f) return -1.f;
+
+        moved = a;
+        translateShape(moved, d * t);
+    }
+    // Only a grazing pass converges this slowly; it never gets closer
+    // than about the slop, so count it as a miss
+    return -1.f;
+}
@@ -0,0 +1,59 @@
+#pragma once
+#include "BodyStore.hpp"
+#include <cstdint>
+
+// ---------------------
+// Exact narrow phase for the three body shapes.
+//
+// Every shape is a convex core grown by a radius: circles are a point
+// with radius r + outline, rectangles and triangles are their polygon
+// with the outline thickness as radius. That matches what is drawn, so
+// bodies touch where their outlines touch. Bodies do not rotate, so the
+// shapes are plain translations of their local geometry.
+// ---------------------
+
+struct ContactPoint {
+    sf::Vector2f point{};       // midway between the two surfaces
+    float penetration = 0.f;    // > 0 when overlapping
+    uint32_t id = 0;            // feature key, stable while the contact persists
+
+    // Accumulated by the solver, carried over between steps by id
+    float normalImpulse = 0.f;
+};
+
+struct Manifold {
+    sf::Vector2f normal{};      // from body a towards body b
+    ContactPoint points[2];
+    int pointCount = 0;
+};
+
+// World-space collision shape of body i: its cached local shape moved to
+// its position
+CollisionShape makeCollisionShape(const BodyStore& bodies, size_t i);
+
+// Fills 'manifold' (normal from a to b) and returns true if the shapes
+// touch. Handles circle-circle, circle-polygon and polygon-polygon (SAT
+// with reference-face clipping, up to two contact points).
+bool collideShapes(const CollisionShape& a, const CollisionShape& b, Manifold& manifold);
+
+// Distance between the surfaces of two separate shapes, with the normal
+// (a towards b) and the point midway between the surfaces. Returns a
+// value <= 0 if the shapes touch; it is only exact while the cores are
+// apart.
+float shapeDistance(const CollisionShape& a, const CollisionShape& b, sf::Vector2f& normal, sf::Vector2f& point);
+
+// Translates the vertices (normals are unchanged by translation)
+void translateShape(CollisionShape& s, const sf::Vector2f& offset);
+
+// ---------------------
+// Time of impact by conservative advancement. Shape a moves by da and b
+// by db over the step, both linearly. Without rotation, the distance
+// between them along the relative motion is convex in time, so advancing
+// by distance / closing speed never steps past the first contact and
+// converges in a few iterations. Returns the fraction of the step at
+// which the surfaces first come within 'slop' (with the normal and
+// contact point there), or -1 if they do not, separate, or already touch
+// at the start (the discrete solver handles those).
+// ---------------------
+float timeOfImpact(const CollisionShape& a, const sf::Vector2f& da, const CollisionShape& b, const sf::Vector2f& db,
+                   float slop, sf::Vector2f& normal, sf::Vector2f& point);
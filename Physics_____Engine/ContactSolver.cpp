@@ -0,0 +1,203 @@
+#include "ContactSolver.hpp"
+#include <cmath>
+
+void ContactSolver::begin(size_t bodyCount, size_t pairCount, float ground) {
+    groundY = ground;
+    states.resize(pairCount);
+    bodyList.resize(pairCount * 2);
+    listed.resize(bodyCount, 0);
+    biasX.resize(bodyCount, 0.f);
+    biasY.resize(bodyCount, 0.f);
+    groundImpulse.resize(bodyCount, 0.f);
+    groundPush.resize(bodyCount);
+    groundBiasImpulse.resize(bodyCount);
+}
+
+void ContactSolver::onBodyRemoved(size_t index, size_t last) {
+    if (index >= groundImpulse.size()) return;
+    groundImpulse[index] = last < groundImpulse.size() ? groundImpulse[last] : 0.f;
+    groundImpulse.resize(std::min(groundImpulse.size(), last));
+}
+
+void ContactSolver::clear() {
+    groundImpulse.clear();
+}
+
+void ContactSolver::solve(BodyStore& bodies, const Broadphase::Pair* pairs, Manifold* manifolds, const uint32_t* order,
+                          size_t first, size_t last, float dt, float* impactImpulse) {
+    if (first >= last || dt <= 0.f) return;
+
+    uint32_t* list = bodyList.data() + first * 2;
+    size_t bodyCount = 0;
+    for (size_t p = first; p < last; ++p) {
+        for (const uint32_t body : { pairs[order[p]].first, pairs[order[p]].second }) {
+            if (listed[body]) continue;
+            listed[body] = 1;
+            list[bodyCount++] = body;
+        }
+    }
+
+    for (size_t p = first; p < last; ++p) {
+        const uint32_t k = order[p];
+        prepare(bodies, pairs[k], manifolds[k], states[k], dt, impactImpulse ? impactImpulse + k : nullptr);
+    }
+    for (size_t b = 0; b < bodyCount; ++b) prepareGround(bodies, list[b], dt);
+
+    for (size_t p = first; p < last; ++p) {
+        const uint32_t k = order[p];
+        if (states[k].normalMass > 0.f) warmStart(bodies, pairs[k], manifolds[k], states[k]);
+    }
+    for (size_t b = 0; b < bodyCount; ++b) warmStartGround(bodies, list[b]);
+
+    for (int it = 0; it < velocityIterations; ++it) {
+        for (size_t p = first; p < last; ++p) {
+            const uint32_t k = order[p];
+            if (states[k].normalMass > 0.f) solveVelocity(bodies, pairs[k], manifolds[k], states[k]);
+        }
+        for (size_t b = 0; b < bodyCount; ++b) solveGroundVelocity(bodies, list[b]);
+    }
+
+    if (correction == Correction::SplitImpulse) {
+        for (int it = 0; it < positionIterations; ++it) {
+            for (size_t p = first; p < last; ++p) {
+                const uint32_t k = order[p];
+                if (states[k].normalMass > 0.f) solvePosition(pairs[k], manifolds[k], states[k]);
+            }
+            for (size_t b = 0; b < bodyCount; ++b) solveGroundPosition(bodies, list[b]);
+        }
+    }
+
+    for (size_t b = 0; b < bodyCount; ++b) {
+        applyPseudoVelocity(bodies, list[b], dt);
+        listed[list[b]] = 0;
+    }
+}
+
+// --- Phases ---
+void ContactSolver::prepare(BodyStore& bodies, const Broadphase::Pair& pair, const Manifold& m, PairState& s,
+                            float dt, float* impact) {
+    const uint32_t a = pair.first, b = pair.second;
+    if (impact) *impact = 0.f;
+
+    // Sleepers act as immovable
+    s.invA = bodies.awake[a] ? bodies.invMass[a] : 0.f;
+    s.invB = bodies.awake[b] ? bodies.invMass[b] : 0.f;
+    const float invMassSum = s.invA + s.invB;
+    s.normalMass = (m.pointCount > 0 && invMassSum > 0.f) ? 1.f / invMassSum : 0.f;
+    if (s.normalMass == 0.f) return;
+
+    const sf::Vector2f n = m.normal;
+    const float vn = (bodies.velX[b] - bodies.velX[a]) * n.x + (bodies.velY[b] - bodies.velY[a]) * n.y;
+    const float e = std::min(bodies.restitution[a], bodies.restitution[b]);
+    if (impact && vn < 0.f) *impact = -(1.f + e) * vn * s.normalMass;
+
+    // Bodies do not rotate, so every point shares the same effective mass
+    const float bounce = vn < -restitutionThreshold ? -e * vn : 0.f;
+    for (int p = 0; p < m.pointCount; ++p) {
+        PointState& ps = s.points[p];
+        const float push = baumgarte / dt * std::max(m.points[p].penetration - slop, 0.f);
+        ps.velocityBias = correction == Correction::Baumgarte ? std::max(bounce, push) : bounce;
+        ps.positionBias = push;
+        ps.biasImpulse = 0.f;
+    }
+}
+
+void ContactSolver::warmStart(BodyStore& bodies, const Broadphase::Pair& pair, const Manifold& m, const PairState& s) {
+    float total = 0.f;
+    for (int p = 0; p < m.pointCount; ++p) total += m.points[p].normalImpulse;
+    if (total == 0.f) return;
+
+    const uint32_t a = pair.first, b = pair.second;
+    bodies.velX[a] -= s.invA * total * m.normal.x;
+    bodies.velY[a] -= s.invA * total * m.normal.y;
+    bodies.velX[b] += s.invB * total * m.normal.x;
+    bodies.velY[b] += s.invB * total * m.normal.y;
+}
+
+void ContactSolver::solveVelocity(BodyStore& bodies, const Broadphase::Pair& pair, Manifold& m, const PairState& s) {
+    const uint32_t a = pair.first, b = pair.second;
+    const sf::Vector2f n = m.normal;
+
+    for (int p = 0; p < m.pointCount; ++p) {
+        ContactPoint& cp = m.points[p];
+        const float vn = (bodies.velX[b] - bodies.velX[a]) * n.x + (bodies.velY[b] - bodies.velY[a]) * n.y;
+
+        // Clamp the accumulated impulse, not the increment, so later
+        // iterations can take back what earlier ones overshot
+        const float old = cp.normalImpulse;
+        cp.normalImpulse = std::max(old - s.normalMass * (vn - s.points[p].velocityBias), 0.f);
+        const float j = cp.normalImpulse - old;
+
+        bodies.velX[a] -= s.invA * j * n.x;
+        bodies.velY[a] -= s.invA * j * n.y;
+        bodies.velX[b] += s.invB * j * n.x;
+        bodies.velY[b] += s.invB * j * n.y;
+    }
+}
+
+void ContactSolver::solvePosition(const Broadphase::Pair& pair, const Manifold& m, PairState& s) {
+    const uint32_t a = pair.first, b = pair.second;
+    const sf::Vector2f n = m.normal;
+
+    for (int p = 0; p < m.pointCount; ++p) {
+        PointState& ps = s.points[p];
+        const float vn = (biasX[b] - biasX[a]) * n.x + (biasY[b] - biasY[a]) * n.y;
+
+        const float old = ps.biasImpulse;
+        ps.biasImpulse = std::max(old - s.normalMass * (vn - ps.positionBias), 0.f);
+        const float j = ps.biasImpulse - old;
+
+        biasX[a] -= s.invA * j * n.x;
+        biasY[a] -= s.invA * j * n.y;
+        biasX[b] += s.invB * j * n.x;
+        biasY[b] += s.invB * j * n.y;
+    }
+}
+
+// --- Ground ---
+// The ground pushes up (-y) on bodies whose bottom reached it
+void ContactSolver::prepareGround(const BodyStore& bodies, uint32_t body, float dt) {
+    groundBiasImpulse[body] = 0.f;
+    const float penetration = bodies.maxY[body] - groundY;
+    if (bodies.awake[body] && bodies.invMass[body] > 0.f && penetration >= -slop) {
+        groundPush[body] = baumgarte / dt * std::max(penetration - slop, 0.f);
+    }
+    else {
+        groundPush[body] = -1.f;
+        groundImpulse[body] = 0.f;
+    }
+}
+
+// Most of a stack's weight ends on the bottom body's ground contact, so
+// that is the impulse that most needs carrying over
+void ContactSolver::warmStartGround(BodyStore& bodies, uint32_t body) {
+    if (groundPush[body] >= 0.f) bodies.velY[body] -= bodies.invMass[body] * groundImpulse[body];
+}
+
+void ContactSolver::solveGroundVelocity(BodyStore& bodies, uint32_t body) {
+    if (groundPush[body] < 0.f) return;
+
+    const float bias = correction == Correction::Baumgarte ? groundPush[body] : 0.f;
+    const float invMass = bodies.invMass[body];
+    const float old = groundImpulse[body];
+    groundImpulse[body] = std::max(old + (bodies.velY[body] + bias) / invMass, 0.f);
+    bodies.velY[body] -= invMass * (groundImpulse[body] - old);
+}
+
+void ContactSolver::solveGroundPosition(const BodyStore& bodies, uint32_t body) {
+    if (groundPush[body] < 0.f) return;
+
+    const float invMass = bodies.invMass[body];
+    const float old = groundBiasImpulse[body];
+    groundBiasImpulse[body] = std::max(old + (biasY[body] + groundPush[body]) / invMass, 0.f);
+    biasY[body] -= invMass * (groundBiasImpulse[body] - old);
+}
+
+void ContactSolver::applyPseudoVelocity(BodyStore& bodies, uint32_t body, float dt) {
+    if (biasX[body] == 0.f && biasY[body] == 0.f) return;
+    bodies.posX[body] += biasX[body] * dt;
+    bodies.posY[body] += biasY[body] * dt;
+    biasX[body] = 0.f;
+    biasY[body] = 0.f;
+    bodies.refreshBounds(body);
+}
@@ -0,0 +1,105 @@
+#pragma once
+#include "Broadphase.hpp"
+#include "Collision.hpp"
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+
+// ---------------------
+// Sequential-impulse contact solver.
+//
+// Runs after every manifold of the step has been generated, so no pair
+// is tested against positions an earlier pair already moved. Each contact
+// point is a non-penetration constraint along the manifold normal whose
+// accumulated impulse is clamped to >= 0; there are no tangent (friction)
+// rows, so contacts between bodies are frictionless. The impulses a
+// point carried at the end of the last step are applied first (warm
+// starting), so a resting stack starts out almost solved and needs few
+// iterations.
+//
+// The ground is a constraint too: the integrator already stops bodies at
+// groundY, but a stack resting on it can only be held up if the solver
+// knows the bottom body cannot move down.
+//
+// Overlap is removed either with split impulses (the default: a separate
+// pseudo-velocity that moves the bodies apart but is thrown away after
+// the step, so correction adds no kinetic energy) or with Baumgarte
+// stabilisation (the correction is a bias on the real velocity: cheaper,
+// but bodies can pop apart).
+// ---------------------
+class ContactSolver {
+public:
+    enum class Correction { SplitImpulse, Baumgarte };
+
+    // More iterations converge stacks and piles further at a linear cost
+    void setVelocityIterations(int n) { velocityIterations = std::max(1, n); }
+    int getVelocityIterations() const { return velocityIterations; }
+    // Split-impulse passes; unused with Baumgarte
+    void setPositionIterations(int n) { positionIterations = std::max(0, n); }
+    int getPositionIterations() const { return positionIterations; }
+    void setCorrection(Correction c) { correction = c; }
+    Correction getCorrection() const { return correction; }
+
+    // Sizes the scratch for this step; call before any solve()
+    void begin(size_t bodyCount, size_t pairCount, float groundY);
+    // Ground impulses are kept per body between steps; the last body
+    // ('last') moved into the removed one's index
+    void onBodyRemoved(size_t index, size_t last);
+    void clear();
+    // Warm-start state (snapshots)
+    std::vector<float>& getGroundImpulses() { return groundImpulse; }
+    const std::vector<float>& getGroundImpulses() const { return groundImpulse; }
+
+    // Solves pairs[order[first .. last)] against each other in that order
+    // and writes the impulse that stopped each pair's approach to
+    // impactImpulse[pair] (if given). Calls on disjoint sets of bodies
+    // (islands) and disjoint ranges of 'order' can run concurrently.
+    void solve(BodyStore& bodies, const Broadphase::Pair* pairs, Manifold* manifolds, const uint32_t* order,
+               size_t first, size_t last, float dt, float* impactImpulse);
+
+    // Overlap (px) left alone so resting contacts stay touching, the
+    // fraction of the rest removed per step, and the approach speed
+    // (px/s) below which contacts do not bounce
+    static constexpr float slop = 0.5f;
+    static constexpr float baumgarte = 0.2f;
+    static constexpr float restitutionThreshold = 30.f;
+
+private:
+    struct PointState {
+        float velocityBias = 0.f;
+        float positionBias = 0.f;
+        float biasImpulse = 0.f;
+    };
+    struct PairState {
+        float normalMass = 0.f;   // 0 if neither body can move
+        float invA = 0.f, invB = 0.f;
+        PointState points[2];
+    };
+
+    void prepare(BodyStore& bodies, const Broadphase::Pair& pair, const Manifold& m, PairState& s, float dt, float* impact);
+    void warmStart(BodyStore& bodies, const Broadphase::Pair& pair, const Manifold& m, const PairState& s);
+    void solveVelocity(BodyStore& bodies, const Broadphase::Pair& pair, Manifold& m, const PairState& s);
+    void solvePosition(const Broadphase::Pair& pair, const Manifold& m, PairState& s);
+    void prepareGround(const BodyStore& bodies, uint32_t body, float dt);
+    void warmStartGround(BodyStore& bodies, uint32_t body);
+    void solveGroundVelocity(BodyStore& bodies, uint32_t body);
+    void solveGroundPosition(const BodyStore& bodies, uint32_t body);
+    void applyPseudoVelocity(BodyStore& bodies, uint32_t body, float dt);
+
+private:
+    int velocityIterations = 8;
+    int positionIterations = 3;
+    Correction correction = Correction::SplitImpulse;
+
+    std::vector<PairState> states;
+    // Bodies of the pairs order[first .. last) go to bodyList[2 * first ..],
+    // so concurrent calls never share a slot; 'listed' is 0 outside solve()
+    std::vector<uint32_t> bodyList;
+    std::vector<uint8_t> listed;
+    // Split-impulse pseudo-velocity per body, zero outside solve()
+    std::vector<float> biasX, biasY;
+
+    // Ground contact per body; groundPush < 0 if the body is clear of it
+    float groundY = 0.f;
+    std::vector<float> groundPush, groundImpulse, groundBiasImpulse;
+};
@@ -0,0 +1,54 @@
+#pragma once
+#include <algorithm>
+
+// ---------------------
+// Accumulator-driven fixed-step scheduler. Frame time goes in, a whole
+// number of fixed steps comes out, and the leftover fraction is used to
+// interpolate rendering between the last two simulated states.
+//
+// At most maxSubSteps steps run per frame; time beyond that is dropped
+// (spiral-of-death guard), so a hitch slows the simulation down instead
+// of making every following frame slower still.
+// ---------------------
+class FixedStepper {
+public:
+    explicit FixedStepper(float stepRate = 120.f, int maxSubSteps = 8) {
+        setStepRate(stepRate);
+        setMaxSubSteps(maxSubSteps);
+    }
+
+    void setStepRate(float hz) { stepDt = 1.f / std::clamp(hz, 1.f, 10000.f); accumulator = 0.f; }
+    float getStepRate() const { return 1.f / stepDt; }
+    float getStepDt() const { return stepDt; }
+
+    void setMaxSubSteps(int n) { maxSubSteps = std::max(1, n); }
+    int getMaxSubSteps() const { return maxSubSteps; }
+
+    // Adds one frame's worth of time and returns how many steps to run
+    int advance(float frameDt) {
+        accumulator += std::max(0.f, frameDt);
+
+        int steps = static_cast<int>(accumulator / stepDt);
+        if (steps > maxSubSteps) {
+            droppedTime += accumulator - maxSubSteps * stepDt;
+            steps = maxSubSteps;
+            accumulator = maxSubSteps * stepDt;
+        }
+        accumulator -= steps * stepDt;
+        return steps;
+    }
+
+    // Fraction of a step between the previous and current state, in [0, 1)
+    float getAlpha() const { return std::clamp(accumulator / stepDt, 0.f, 1.f); }
+
+    // Wall time thrown away by the spiral-of-death guard
+    float getDroppedTime() const { return droppedTime; }
+
+    void reset() { accumulator = 0.f; droppedTime = 0.f; }
+
+private:
+    float stepDt = 1.f / 120.f;
+    int maxSubSteps = 8;
+    float accumulator = 0.f;
+    float droppedTime = 0.f;
+};
@@ -0,0 +1,52 @@
+#include "Islands.hpp"
+#include <numeric>
+#include <utility>
+
+uint32_t IslandBuilder::find(uint32_t x) {
+    while (parent[x] != x) {
+        parent[x] = parent[parent[x]];
+        x = parent[x];
+    }
+    return x;
+}
+
+void IslandBuilder::unite(uint32_t a, uint32_t b) {
+    a = find(a);
+    b = find(b);
+    if (a == b) return;
+    if (rank[a] < rank[b]) std::swap(a, b);
+    parent[b] = a;
+    if (rank[a] == rank[b]) ++rank[a];
+}
+
+void IslandBuilder::build(size_t bodyCount, const std::vector<Broadphase::Pair>& pairs) {
+    parent.resize(bodyCount);
+    std::iota(parent.begin(), parent.end(), 0u);
+    rank.assign(bodyCount, 0);
+
+    for (const auto& [a, b] : pairs) unite(a, b);
+
+    // Number islands in order of their first pair
+    bodyIsland.assign(bodyCount, noIsland);
+    pairIsland.resize(pairs.size());
+    uint32_t islands = 0;
+    for (size_t p = 0; p < pairs.size(); ++p) {
+        const uint32_t root = find(pairs[p].first);
+        if (bodyIsland[root] == noIsland) bodyIsland[root] = islands++;
+        pairIsland[p] = bodyIsland[root];
+    }
+    for (size_t i = 0; i < bodyCount; ++i) {
+        const uint32_t root = find(static_cast<uint32_t>(i));
+        bodyIsland[i] = bodyIsland[root];
+    }
+
+    // Stable counting sort of the pairs by island
+    islandStart.assign(islands + 1, 0);
+    for (uint32_t k : pairIsland) ++islandStart[k + 1];
+    for (uint32_t k = 0; k < islands; ++k) islandStart[k + 1] += islandStart[k];
+
+    pairOrder.resize(pairs.size());
+    cursor.assign(islandStart.begin(), islandStart.end() - 1);
+    for (size_t p = 0; p < pairs.size(); ++p)
+        pairOrder[cursor[pairIsland[p]]++] = static_cast<uint32_t>(p);
+}
@@ -0,0 +1,41 @@
+#pragma once
+#include "Broadphase.hpp"
+#include <cstdint>
+#include <vector>
+
+// ---------------------
+// Contact islands: groups of bodies connected through the pair list,
+// found with union-find. Islands share no bodies, so each can be solved
+// on its own thread with the same result as a serial solve.
+// ---------------------
+class IslandBuilder {
+public:
+    // Groups 'pairs' (sorted, as Broadphase returns them) by island.
+    // Within an island the pairs keep their original order, and islands
+    // are numbered by their first pair, so the output does not depend on
+    // anything but the input.
+    void build(size_t bodyCount, const std::vector<Broadphase::Pair>& pairs);
+
+    size_t getIslandCount() const { return islandStart.empty() ? 0 : islandStart.size() - 1; }
+
+    // Pairs of island k are pairs[pairOrder[islandStart[k] .. islandStart[k + 1])]
+    const std::vector<uint32_t>& getPairOrder() const { return pairOrder; }
+    const std::vector<uint32_t>& getIslandStart() const { return islandStart; }
+
+    // Island of a body after build(), or noIsland if it touches nothing
+    static constexpr uint32_t noIsland = 0xffffffffu;
+    uint32_t getBodyIsland(size_t body) const { return bodyIsland[body]; }
+
+private:
+    uint32_t find(uint32_t x);
+    void unite(uint32_t a, uint32_t b);
+
+private:
+    std::vector<uint32_t> parent;
+    std::vector<uint32_t> rank;
+    std::vector<uint32_t> bodyIsland;
+    std::vector<uint32_t> pairIsland;
+    std::vector<uint32_t> pairOrder;
+    std::vector<uint32_t> islandStart;
+    std::vector<uint32_t> cursor;
+};
@@ -0,0 +1,576 @@
+#include "Joints.hpp"
+#include "Profiler.hpp"
+#include <algorithm>
+#include <bit>
+#include <cfloat>
+#include <cmath>
+#include <cstring>
+
+namespace {
+    constexpr float twoPi = 6.28318531f;
+    constexpr uint32_t none = UINT32_MAX;
+    // Batches this big are split across the pool
+    constexpr size_t parallelRows = 4096;
+    constexpr size_t chunkRows = 1024;
+
+    uint64_t pairKey(size_t i, size_t j) {
+        if (i > j) std::swap(i, j);
+        return (static_cast<uint64_t>(i) << 32) | static_cast<uint64_t>(j);
+    }
+
+    // Where the body's centre was when the step started
+    sf::Vector2f startCentre(const BodyStore& b, size_t i) {
+        return { b.prevX[i] + (b.localMinX[i] + b.localMaxX[i]) * 0.5f,
+                 b.prevY[i] + (b.localMinY[i] + b.localMaxY[i]) * 0.5f };
+    }
+
+    bool chainable(JointType type) {
+        return type == JointType::Distance || type == JointType::Rope;
+    }
+
+    // Direction of a row and how far its joint is off, given the second
+    // end minus the first
+    float rowError(const JointDef& d, const sf::Vector2f& offset, uint8_t axis, const sf::Vector2f& delta,
+                   float& nx, float& ny) {
+        if (d.type == JointType::Pin) {
+            nx = axis ? 0.f : 1.f;
+            ny = axis ? 1.f : 0.f;
+            return axis ? delta.y - offset.y : delta.x - offset.x;
+        }
+        const float len = std::hypot(delta.x, delta.y);
+        nx = len > 1e-4f ? delta.x / len : 0.f;
+        ny = len > 1e-4f ? delta.y / len : 1.f;
+        return len - d.length;
+    }
+
+    void applyImpulse(const JointRowStreams& s, size_t r, float j) {
+        const uint32_t a = s.a[r], b = s.b[r];
+        const float jx = j * s.nx[r], jy = j * s.ny[r];
+        if (a) { s.vx[a] -= s.invMass[a] * jx; s.vy[a] -= s.invMass[a] * jy; }
+        if (b) { s.vx[b] += s.invMass[b] * jx; s.vy[b] += s.invMass[b] * jy; }
+    }
+
+    // Rows [first, last) in chain order: each row's b is the next row's a,
+    // so the rows' effective mass matrix is tridiagonal and one forward
+    // elimination and back substitution (Thomas algorithm) solves the
+    // whole chain. Uncoupled rows are left out of the block and are then
+    // updated one by one along the chain ('reverse': from the far end).
+    // 'c' and 'd' are scratch, by row.
+    float solveChain(const JointRowStreams& s, const uint8_t* coupled, float* c, float* d, size_t first, size_t last,
+                     bool reverse) {
+        float offPrev = 0.f;    // coupling of the row before with this one
+        for (size_t r = first; r < last; ++r) {
+            const uint32_t a = s.a[r], b = s.b[r];
+            float diag = 1.f, rhs = 0.f;
+            if (coupled[r]) {
+                const float cdot = (s.vx[b] - s.vx[a]) * s.nx[r] + (s.vy[b] - s.vy[a]) * s.ny[r];
+                diag = s.invMass[a] + s.invMass[b] + s.gamma[r];
+                rhs = -(cdot + s.bias[r] + s.gamma[r] * s.impulse[r]);
+            }
+            const bool linked = r + 1 < last && coupled[r] && coupled[r + 1];
+            const float off = linked ? -s.invMass[b] * (s.nx[r] * s.nx[r + 1] + s.ny[r] * s.ny[r + 1]) : 0.f;
+
+            const float denom = r > first ? diag - offPrev * c[r - 1] : diag;
+            const float inv = std::abs(denom) > 1e-12f ? 1.f / denom : 0.f;
+            c[r] = off * inv;
+            d[r] = (rhs - (r > first ? offPrev * d[r - 1] : 0.f)) * inv;
+            offPrev = off;
+        }
+        for (size_t r = last - 1; r-- > first;) d[r] -= c[r] * d[r + 1];
+
+        float change = 0.f;
+        for (size_t r = first; r < last; ++r) {
+            if (!coupled[r]) continue;
+            const float old = s.impulse[r];
+            const float acc = std::clamp(old + d[r], s.lower[r], s.upper[r]);
+            const float j = acc - old;
+            s.impulse[r] = acc;
+            applyImpulse(s, r, j);
+            change = std::max(change, std::abs(j) * (s.invMass[s.a[r]] + s.invMass[s.b[r]]));
+        }
+        for (size_t k = first; k < last; ++k) {
+            const size_t r = reverse ? first + last - 1 - k : k;
+            if (!coupled[r]) change = std::max(change, solveJointRows(s, r, r + 1));
+        }
+        return change;
+    }
+}
+
+bool parseJointType(const std::string& name, JointType& type) {
+    for (JointType t : { JointType::Distance, JointType::Spring, JointType::Rope, JointType::Pin }) {
+        if (name == jointTypeName(t)) {
+            type = t;
+            return true;
+        }
+    }
+    return false;
+}
+
+const char* jointTypeName(JointType type) {
+    switch (type) {
+    case JointType::Spring: return "spring";
+    case JointType::Rope: return "rope";
+    case JointType::Pin: return "pin";
+    case JointType::Distance:
+    default: return "distance";
+    }
+}
+
+size_t JointSolver::add(const JointDef& def, const BodyStore& bodies) {
+    const size_t a = bodies.indexOf(def.a);
+    const size_t b = def.toWorld() ? BodyStore::noBody : bodies.indexOf(def.b);
+    if (a == BodyStore::noBody || (!def.toWorld() && (b == BodyStore::noBody || a == b))) return noJoint;
+
+    Joint joint;
+    joint.def = def;
+    const sf::Vector2f pa = bodies.centre(a);
+    const sf::Vector2f pb = def.toWorld() ? def.anchor : bodies.centre(b);
+    if (def.type == JointType::Pin) {
+        if (!def.toWorld()) joint.offset = pb - pa;
+    }
+    else if (joint.def.length <= 0.f) {
+        joint.def.length = std::hypot(pb.x - pa.x, pb.y - pa.y);
+    }
+    joints.push_back(joint);
+    dirty = true;
+    return joints.size() - 1;
+}
+
+void JointSolver::remove(size_t index) {
+    if (index >= joints.size()) return;
+    joints[index] = joints.back();
+    joints.pop_back();
+    dirty = true;
+}
+
+void JointSolver::clear() {
+    joints.clear();
+    dirty = true;
+}
+
+// --- Colouring ---
+// Joints whose bodies are gone are dropped and the rest become rows. Runs
+// of rods and ropes through bodies with no other joint become chains;
+// every other row is given the lowest colour neither of its bodies has
+// yet, and every chain the lowest colour neither of its end bodies has.
+// Each solver body keeps a mask of the colours it is in; the world is in
+// none, so any number of rows may share it.
+void JointSolver::rebuild(const BodyStore& bodies) {
+    PROFILE_ZONE("Joint colouring");
+    for (size_t k = 0; k < joints.size();) {
+        const JointDef& d = joints[k].def;
+        const bool gone = bodies.indexOf(d.a) == BodyStore::noBody
+                          || (!d.toWorld() && bodies.indexOf(d.b) == BodyStore::noBody);
+        if (gone) remove(k);
+        else ++k;
+    }
+    dirty = false;
+
+    solverBody.assign(1, none);
+    storeToSolver.assign(bodies.count(), 0);
+    const auto solverIndex = [&](size_t i) {
+        if (storeToSolver[i] == 0) {
+            storeToSolver[i] = static_cast<uint32_t>(solverBody.size());
+            solverBody.push_back(static_cast<uint32_t>(i));
+        }
+        return storeToSolver[i];
+    };
+
+    // Rows in joint order
+    std::vector<uint32_t> jointRow, aRow, bRow;
+    std::vector<uint8_t> axisRow;
+    joinedPairs.clear();
+    for (size_t k = 0; k < joints.size(); ++k) {
+        const JointDef& d = joints[k].def;
+        const size_t ia = bodies.indexOf(d.a);
+        const size_t ib = d.toWorld() ? BodyStore::noBody : bodies.indexOf(d.b);
+        const uint32_t a = solverIndex(ia);
+        const uint32_t b = ib == BodyStore::noBody ? 0 : solverIndex(ib);
+        if (b) joinedPairs.push_back(pairKey(ia, ib));
+
+        const uint8_t rows = d.type == JointType::Pin ? 2 : 1;
+        for (uint8_t axis = 0; axis < rows; ++axis) {
+            jointRow.push_back(static_cast<uint32_t>(k));
+            axisRow.push_back(axis);
+            aRow.push_back(a);
+            bRow.push_back(b);
+        }
+    }
+    std::sort(joinedPairs.begin(), joinedPairs.end());
+    const size_t n = jointRow.size();
+    const size_t bodyCount = solverBody.size();
+
+    // --- Chains ---
+    // A link is a body with exactly two rows, both rods or ropes
+    std::vector<uint32_t> degree(bodyCount, 0), link(2 * bodyCount, none);
+    for (size_t r = 0; r < n; ++r) {
+        for (uint32_t s : { aRow[r], bRow[r] }) {
+            if (s && degree[s] < 2) link[2 * s + degree[s]] = static_cast<uint32_t>(r);
+            if (s) ++degree[s];
+        }
+    }
+    const auto rowChainable = [&](uint32_t r) { return chainable(joints[jointRow[r]].def.type); };
+    const auto isLink = [&](uint32_t s) {
+        return s && degree[s] == 2 && rowChainable(link[2 * s]) && rowChainable(link[2 * s + 1]);
+    };
+    const auto across = [&](uint32_t r, uint32_t s) { return aRow[r] == s ? bRow[r] : aRow[r]; };
+    const auto onward = [&](uint32_t s, uint32_t r) { return link[2 * s] == r ? link[2 * s + 1] : link[2 * s]; };
+
+    std::vector<uint8_t> seen(n, 0);
+    std::vector<uint32_t> chainRows, chainFirst(1, 0), chainEnds, path, pathA;
+    for (uint32_t r = 0; r < n; ++r) {
+        if (seen[r] || !rowChainable(r)) continue;
+
+        // Back up to one end of the run, then walk it to the other
+        uint32_t first = r, end = aRow[r];
+        bool ring = false;
+        while (isLink(end)) {
+            const uint32_t prev = onward(end, first);
+            if (prev == r) {
+                ring = true;
+                break;
+            }
+            end = across(prev, end);
+            first = prev;
+        }
+        path.clear();
+        pathA.clear();
+        uint32_t row = first, s = end;
+        for (;;) {
+            path.push_back(row);
+            pathA.push_back(s);
+            seen[row] = 1;
+            s = across(row, s);
+            if (!isLink(s)) break;
+            row = onward(s, row);
+            if (row == first) break;
+        }
+
+        // Rings and runs from a body back to itself are not tridiagonal
+        if (ring || path.size() < minChainRows || (s == end && s != 0)) continue;
+        for (size_t k = 0; k < path.size(); ++k) {
+            if (aRow[path[k]] != pathA[k]) std::swap(aRow[path[k]], bRow[path[k]]);
+        }
+        chainRows.insert(chainRows.end(), path.begin(), path.end());
+        chainFirst.push_back(static_cast<uint32_t>(chainRows.size()));
+        chainEnds.push_back(end);
+        chainEnds.push_back(s);
+    }
+    const size_t chainCount = chainEnds.size() / 2;
+    std::vector<uint8_t> inChain(n, 0);
+    for (uint32_t r : chainRows) inChain[r] = 1;
+
+    // --- Colours ---
+    const uint64_t regular = (1ull << (maxColours - 1)) - 1;
+    const auto pickColour = [&](std::vector<uint64_t>& used, uint32_t a, uint32_t b) {
+        const uint64_t free = ~(used[a] | used[b]) & regular;
+        if (!free) return maxColours - 1;
+        const uint32_t colour = static_cast<uint32_t>(std::countr_zero(free));
+        if (a) used[a] |= 1ull << colour;
+        if (b) used[b] |= 1ull << colour;
+        return colour;
+    };
+    std::vector<uint64_t> used(bodyCount, 0);
+    std::vector<uint32_t> colourRow(n, none), colourChain(chainCount);
+    for (size_t r = 0; r < n; ++r) {
+        if (!inChain[r]) colourRow[r] = pickColour(used, aRow[r], bRow[r]);
+    }
+    used.assign(bodyCount, 0);
+    for (size_t c = 0; c < chainCount; ++c) colourChain[c] = pickColour(used, chainEnds[2 * c], chainEnds[2 * c + 1]);
+
+    // Counting sorts by colour; the overflow colour goes last and serial
+    const auto sortByColour = [](const std::vector<uint32_t>& colourOf, std::vector<Colour>& out, uint32_t* start) {
+        std::fill(start, start + maxColours + 1, 0u);
+        for (uint32_t c : colourOf) {
+            if (c != none) ++start[c + 1];
+        }
+        out.clear();
+        for (uint32_t c = 0; c < maxColours; ++c) {
+            if (start[c + 1]) out.push_back({ start[c], start[c] + start[c + 1], c == maxColours - 1 });
+            start[c + 1] += start[c];
+        }
+    };
+    uint32_t start[maxColours + 1];
+    uint32_t chainStart[maxColours + 1];
+    sortByColour(colourRow, colours, start);
+    sortByColour(colourChain, chainColours, chainStart);
+
+    rowJoint.resize(n);
+    rowAxis.resize(n);
+    rowA.resize(n);
+    rowB.resize(n);
+    rowCoupled.assign(n, 0);
+    for (auto* stream : { &nx, &ny, &mass, &bias, &gamma, &lower, &upper, &impulse }) stream->resize(n);
+    chainC.resize(n);
+    chainD.resize(n);
+    const auto place = [&](size_t to, uint32_t from) {
+        rowJoint[to] = jointRow[from];
+        rowAxis[to] = axisRow[from];
+        rowA[to] = aRow[from];
+        rowB[to] = bRow[from];
+    };
+    for (uint32_t r = 0; r < n; ++r) {
+        if (!inChain[r]) place(start[colourRow[r]]++, r);
+    }
+
+    // Chains follow the coloured rows, in chain colour order
+    std::vector<uint32_t> slotChain(chainCount);
+    for (uint32_t c = 0; c < chainCount; ++c) slotChain[chainStart[colourChain[c]]++] = c;
+    chains.resize(chainCount);
+    uint32_t to = static_cast<uint32_t>(n - chainRows.size());
+    for (size_t slot = 0; slot < chainCount; ++slot) {
+        const uint32_t c = slotChain[slot];
+        chains[slot].first = to;
+        for (uint32_t k = chainFirst[c]; k < chainFirst[c + 1]; ++k) place(to++, chainRows[k]);
+        chains[slot].last = to;
+    }
+}
+
+// --- Waking ---
+// A sleeper is woken by a joined body that is moving (its sleep timer is
+// still at 0), so a chain that comes to rest can fall asleep piece by
+// piece without the pieces waking each other again. Passes alternate
+// direction until nothing changes, so a whole chain wakes in one go.
+size_t JointSolver::wakeJoined(BodyStore& bodies) {
+    if (dirty) rebuild(bodies);
+    if (joinedPairs.empty()) return 0;
+
+    size_t woken = 0;
+    bool changed = true;
+    for (bool reverse = false; changed; reverse = !reverse) {
+        changed = false;
+        for (size_t k = 0; k < joinedPairs.size(); ++k) {
+            const uint64_t key = joinedPairs[reverse ? joinedPairs.size() - 1 - k : k];
+            const size_t i = static_cast<size_t>(key >> 32), j = static_cast<size_t>(key & 0xffffffffu);
+            if (bodies.awake[i] == bodies.awake[j]) continue;
+            const size_t mover = bodies.awake[i] ? i : j;
+            const size_t sleeper = bodies.awake[i] ? j : i;
+            if (bodies.sleepTimer[mover] != 0.f) continue;
+            bodies.awake[sleeper] = 1;
+            bodies.sleepTimer[sleeper] = 0.f;
+            ++woken;
+            changed = true;
+        }
+    }
+    return woken;
+}
+
+void JointSolver::filterPairs(std::vector<Broadphase::Pair>& pairs) const {
+    if (joinedPairs.empty()) return;
+    pairs.erase(std::remove_if(pairs.begin(), pairs.end(), [&](const Broadphase::Pair& p) {
+        return std::binary_search(joinedPairs.begin(), joinedPairs.end(), pairKey(p.first, p.second));
+    }), pairs.end());
+}
+
+// --- Solve ---
+// Velocity rows see the centres where the step started and the
+// velocities the integrator left; what they change in a velocity is
+// applied to this step's move as well, so a joint holds as if it had been
+// solved before the bodies moved.
+void JointSolver::prepareVelocity(const BodyStore& bodies, float dt) {
+    const size_t count = solverBody.size();
+    vx.resize(count);
+    vy.resize(count);
+    invMass.resize(count);
+    vx[0] = vy[0] = invMass[0] = 0.f;
+    for (size_t s = 1; s < count; ++s) {
+        const uint32_t i = solverBody[s];
+        vx[s] = bodies.velX[i];
+        vy[s] = bodies.velY[i];
+        invMass[s] = bodies.awake[i] ? bodies.invMass[i] : 0.f;
+    }
+
+    const float invDt = 1.f / dt;
+    for (size_t r = 0; r < rowJoint.size(); ++r) {
+        const Joint& joint = joints[rowJoint[r]];
+        const JointDef& d = joint.def;
+        const uint32_t a = rowA[r], b = rowB[r];
+        const sf::Vector2f pa = a ? startCentre(bodies, solverBody[a]) : d.anchor;
+        const sf::Vector2f pb = b ? startCentre(bodies, solverBody[b]) : d.anchor;
+        const float c = rowError(d, joint.offset, rowAxis[r], pb - pa, nx[r], ny[r]);
+        const float invSum = invMass[a] + invMass[b];
+
+        lower[r] = -FLT_MAX;
+        upper[r] = FLT_MAX;
+        gamma[r] = 0.f;
+        bias[r] = 0.f;
+        mass[r] = invSum > 0.f ? 1.f / invSum : 0.f;
+        rowCoupled[r] = mass[r] > 0.f;
+
+        if (d.type == JointType::Rope) {
+            // Only pulls; while slack it only stops the ends passing the limit
+            upper[r] = 0.f;
+            if (c < 0.f) bias[r] = c * invDt;
+            rowCoupled[r] = rowCoupled[r] && c >= -ropeSlop;
+        }
+        else if (d.type == JointType::Spring && invSum > 0.f) {
+            const float omega = twoPi * std::max(d.frequency, 0.f);
+            const float k = mass[r] * omega * omega;
+            const float damp = 2.f * mass[r] * std::max(d.damping, 0.f) * omega;
+            const float soft = damp + dt * k;
+            if (soft > 0.f) {
+                gamma[r] = 1.f / (dt * soft);
+                bias[r] = k * c / soft;
+                mass[r] = 1.f / (invSum + gamma[r]);
+            }
+            else {
+                mass[r] = 0.f;
+            }
+        }
+
+        // Warm start; rows whose bodies cannot move start from nothing
+        impulse[r] = mass[r] > 0.f ? joint.impulse[rowAxis[r]] : 0.f;
+        const float jx = impulse[r] * nx[r], jy = impulse[r] * ny[r];
+        vx[a] -= invMass[a] * jx;
+        vy[a] -= invMass[a] * jy;
+        vx[b] += invMass[b] * jx;
+        vy[b] += invMass[b] * jy;
+    }
+}
+
+// The position pass works on pseudo-velocities that start at zero and
+// only move the bodies, against the centres the last pass left. Its rows
+// are never coupled: chains are swept link by link instead, because after
+// a fast swing the exact block can overshoot where links turned far.
+void JointSolver::preparePosition(const BodyStore& bodies, float dt) {
+    std::fill(vx.begin(), vx.end(), 0.f);
+    std::fill(vy.begin(), vy.end(), 0.f);
+    std::fill(rowCoupled.begin(), rowCoupled.end(), 0);
+
+    const float invDt = 1.f / dt;
+    for (size_t r = 0; r < rowJoint.size(); ++r) {
+        const Joint& joint = joints[rowJoint[r]];
+        const JointDef& d = joint.def;
+        const uint32_t a = rowA[r], b = rowB[r];
+        const sf::Vector2f pa = a ? bodies.centre(solverBody[a]) : d.anchor;
+        const sf::Vector2f pb = b ? bodies.centre(solverBody[b]) : d.anchor;
+        const float c = rowError(d, joint.offset, rowAxis[r], pb - pa, nx[r], ny[r]);
+        const float invSum = invMass[a] + invMass[b];
+
+        const bool corrects = invSum > 0.f && d.type != JointType::Spring && (d.type != JointType::Rope || c > 0.f);
+        mass[r] = corrects ? 1.f / invSum : 0.f;
+        bias[r] = positionCorrection * invDt * c;
+        gamma[r] = 0.f;
+        impulse[r] = 0.f;
+    }
+}
+
+float JointSolver::solveColour(const JointRowStreams& streams, const Colour& c, ThreadPool* pool) {
+    if (c.serial) {
+        float change = 0.f;
+        for (uint32_t r = c.first; r < c.last; ++r) change = std::max(change, solveJointRows(streams, r, r + 1));
+        return change;
+    }
+
+    const size_t rows = c.last - c.first;
+    if (!pool || pool->getThreadCount() < 2 || rows < parallelRows) return solveJointRows(streams, c.first, c.last);
+
+    const size_t chunks = (rows + chunkRows - 1) / chunkRows;
+    taskChange.assign(chunks, 0.f);
+    pool->parallelFor(chunks, [&](size_t t) {
+        const size_t first = c.first + t * chunkRows;
+        taskChange[t] = solveJointRows(streams, first, std::min<size_t>(first + chunkRows, c.last));
+    });
+    return *std::max_element(taskChange.begin(), taskChange.end());
+}
+
+// Chains of one colour share no body, so whole chains go to the pool,
+// roughly chunkRows rows per task
+float JointSolver::solveChains(const JointRowStreams& streams, const Colour& c, bool reverse, ThreadPool* pool) {
+    const auto solveRange = [&](uint32_t first, uint32_t last) {
+        float change = 0.f;
+        for (uint32_t k = first; k < last; ++k) {
+            change = std::max(change, solveChain(streams, rowCoupled.data(), chainC.data(), chainD.data(),
+                                                 chains[k].first, chains[k].last, reverse));
+        }
+        return change;
+    };
+
+    const size_t rows = chains[c.last - 1].last - chains[c.first].first;
+    if (c.serial || !pool || pool->getThreadCount() < 2 || rows < parallelRows) return solveRange(c.first, c.last);
+
+    taskStart.assign(1, c.first);
+    size_t taskRows = 0;
+    for (uint32_t k = c.first; k < c.last; ++k) {
+        taskRows += chains[k].last - chains[k].first;
+        if (taskRows >= chunkRows) {
+            taskStart.push_back(k + 1);
+            taskRows = 0;
+        }
+    }
+    if (taskStart.back() != c.last) taskStart.push_back(c.last);
+
+    taskChange.assign(taskStart.size() - 1, 0.f);
+    pool->parallelFor(taskChange.size(), [&](size_t t) {
+        taskChange[t] = solveRange(taskStart[t], taskStart[t + 1]);
+    });
+    return *std::max_element(taskChange.begin(), taskChange.end());
+}
+
+// One pass over every batch; returns the largest velocity change
+float JointSolver::sweep(const JointRowStreams& streams, bool reverse, ThreadPool* pool) {
+    const size_t batches = colours.size() + chainColours.size();
+    float change = 0.f;
+    for (size_t k = 0; k < batches; ++k) {
+        const size_t i = reverse ? batches - 1 - k : k;
+        change = std::max(change, i < colours.size() ? solveColour(streams, colours[i], pool)
+                                                      : solveChains(streams, chainColours[i - colours.size()], reverse, pool));
+    }
+    return change;
+}
+
+void JointSolver::solve(BodyStore& bodies, float dt, ThreadPool* pool) {
+    iterationsUsed = 0;
+    if (dirty) rebuild(bodies);
+    if (rowJoint.empty() || !(dt > 0.f)) return;
+    PROFILE_ZONE("Joints");
+
+    prepareVelocity(bodies, dt);
+    const JointRowStreams streams{ vx.data(), vy.data(), invMass.data(), rowA.data(), rowB.data(), nx.data(), ny.data(),
+                                   mass.data(), bias.data(), gamma.data(), lower.data(), upper.data(), impulse.data() };
+    while (iterationsUsed < velocityIterations) {
+        const float change = sweep(streams, (iterationsUsed & 1) != 0, pool);
+        ++iterationsUsed;
+        if (change < tolerance) break;
+    }
+
+    for (size_t r = 0; r < rowJoint.size(); ++r) joints[rowJoint[r]].impulse[rowAxis[r]] = impulse[r];
+    for (size_t s = 1; s < solverBody.size(); ++s) {
+        const uint32_t i = solverBody[s];
+        const float dvx = vx[s] - bodies.velX[i];
+        const float dvy = vy[s] - bodies.velY[i];
+        if (dvx == 0.f && dvy == 0.f) continue;
+        bodies.velX[i] = vx[s];
+        bodies.velY[i] = vy[s];
+        bodies.posX[i] += dvx * dt;
+        bodies.posY[i] += dvy * dt;
+        bodies.refreshBounds(i);
+    }
+
+    // Each position pass starts again from where the last one left the
+    // bodies, so a joint that turned far in the step is still pulled
+    // straight back along its current direction
+    for (int pass = 0; pass < positionIterations; ++pass) {
+        preparePosition(bodies, dt);
+        const float change = sweep(streams, (pass & 1) != 0, pool);
+        for (size_t s = 1; s < solverBody.size(); ++s) {
+            if (vx[s] == 0.f && vy[s] == 0.f) continue;
+            const uint32_t i = solverBody[s];
+            bodies.posX[i] += vx[s] * dt;
+            bodies.posY[i] += vy[s] * dt;
+            bodies.refreshBounds(i);
+        }
+        if (change < tolerance) break;
+    }
+}
+
+// --- Snapshots ---
+void JointSolver::saveRaw(uint8_t* out) const {
+    if (!joints.empty()) std::memcpy(out, joints.data(), rawSize());
+}
+
+void JointSolver::loadRaw(const uint8_t* in, size_t count) {
+    joints.resize(count);
+    if (count) std::memcpy(static_cast<void*>(joints.data()), in, rawSize());
+    dirty = true;
+}
@@ -0,0 +1,190 @@
+#pragma once
+#include "BodyStore.hpp"
+#include "Broadphase.hpp"
+#include "ThreadPool.hpp"
+#include "SimdKernels.hpp"
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Distance: a rigid rod, the centres stay 'length' apart
+// Spring:   pulls the centres towards 'length' apart, softly
+// Rope:     the centres can come closer than 'length' but not go further
+// Pin:      holds b where it was relative to a when the pin was made, or
+//           a's centre on the anchor when b is the world
+enum class JointType : uint32_t { Distance, Spring, Rope, Pin };
+
+// Names as in scene files: distance, spring, rope, pin
+bool parseJointType(const std::string& name, JointType& type);
+const char* jointTypeName(JointType type);
+
+// ---------------------
+// Plain description of one joint, used to add and read back joints.
+// Joints act on the body centres: bodies do not rotate, so any other
+// attachment point would move with the centre anyway.
+// ---------------------
+struct JointDef {
+    JointType type = JointType::Distance;
+    BodyHandle a;
+    BodyHandle b;                  // left invalid: a is tied to 'anchor' in the world
+    sf::Vector2f anchor{};
+    float length = 0.f;            // rest length or rope limit, 0 = the distance when added
+    float frequency = 2.f;         // springs: oscillations per second
+    float damping = 0.5f;          // springs: damping ratio, 1 = critical
+
+    bool toWorld() const { return b.slot == UINT32_MAX; }
+};
+
+// A rope of small circles, each tied to the next by a rope joint, from
+// body a to body b (or to 'anchor'). The segments are laid out on the
+// straight line between the ends; 'slack' > 1 leaves the rope longer
+// than that line.
+struct RopeDef {
+    BodyHandle a;
+    BodyHandle b;
+    sf::Vector2f anchor{};
+    size_t segments = 10;
+    float radius = 3.f;
+    float mass = 0.2f;             // per segment
+    float slack = 1.f;
+};
+
+// ---------------------
+// Joint solver: sequential impulses over graph-coloured batches.
+//
+// Every joint is one velocity row along the line between the centres
+// (pins are two, one per axis). The rows are coloured greedily so that no
+// two rows of one colour touch the same body; a colour is then a batch
+// whose rows can all be solved at once, in SIMD lanes (solveJointRows)
+// and across the pool's threads, without write conflicts. Colours are
+// solved one after another, so the whole pass is still Gauss-Seidel and
+// the result does not depend on the thread count or SIMD width. The
+// colouring only changes when joints are added or removed, or body
+// indices move (a body removed, a snapshot restored).
+//
+// Gauss-Seidel needs on the order of n^2 passes to carry a pull along a
+// chain of n links, so chains (runs of rods and ropes through bodies that
+// have no other joint) are not coloured row by row. Each is solved
+// exactly as one block instead: its rows form a tridiagonal system, which
+// is O(n). Chains are coloured by their end bodies like rows, so they too
+// are solved in parallel, and a long rope holds within the iteration
+// budget. Rows and chains start from the impulses they ended the last
+// step with (warm starting), and the sweep order reverses every pass.
+//
+// Like the contacts, the velocity rows carry no position bias: drift is
+// removed afterwards by separate pseudo-velocity passes that move the
+// bodies but leave their velocities alone, so correction adds no energy.
+// Each position pass measures the joints again where the last one left
+// them and sweeps chains link by link, which stays stable after a chain
+// has been whipped round. Springs are soft rows (stiffness and damping
+// from frequency and ratio) and are only solved in the velocity pass.
+// ---------------------
+class JointSolver {
+public:
+    // The body handles are resolved now; 'length' 0 is filled in.
+    // Returns noJoint if a body is missing or both ends are the same.
+    size_t add(const JointDef& joint, const BodyStore& bodies);
+    // The last joint moves into 'index'
+    void remove(size_t index);
+    void clear();
+    size_t size() const { return joints.size(); }
+    const JointDef& get(size_t index) const { return joints[index].def; }
+
+    // Body indices changed; joints whose bodies are gone are dropped on
+    // the next solve
+    void markDirty() { dirty = true; }
+
+    // Passes per step; a pass whose largest velocity change is below the
+    // tolerance (px/s) ends its solve early
+    void setVelocityIterations(int n) { velocityIterations = std::max(1, n); }
+    int getVelocityIterations() const { return velocityIterations; }
+    void setPositionIterations(int n) { positionIterations = std::max(0, n); }
+    int getPositionIterations() const { return positionIterations; }
+    void setTolerance(float t) { tolerance = std::max(0.f, t); }
+    float getTolerance() const { return tolerance; }
+
+    // Wakes the sleepers joined to a moving body; returns how many
+    size_t wakeJoined(BodyStore& bodies);
+    // Drops candidate pairs of bodies joined to each other, so jointed
+    // bodies never collide
+    void filterPairs(std::vector<Broadphase::Pair>& pairs) const;
+
+    // Solves every joint against the velocities the integrator left. A
+    // null pool (or a small batch) solves on the calling thread.
+    void solve(BodyStore& bodies, float dt, ThreadPool* pool);
+
+    // Last solve
+    size_t getRowCount() const { return rowJoint.size(); }
+    size_t getColourCount() const { return colours.size() + chainColours.size(); }
+    size_t getChainCount() const { return chains.size(); }
+    int getIterationsUsed() const { return iterationsUsed; }
+
+    // Snapshots: every joint with its accumulated impulses
+    size_t rawSize() const { return joints.size() * sizeof(Joint); }
+    void saveRaw(uint8_t* out) const;
+    void loadRaw(const uint8_t* in, size_t count);
+
+    // Beyond this many colours, rows share the last batch and are solved
+    // one at a time
+    static constexpr uint32_t maxColours = 64;
+    // Shorter runs are plain rows
+    static constexpr size_t minChainRows = 4;
+    // Fraction of the drift removed per step by the position pass
+    static constexpr float positionCorrection = 0.8f;
+    // A rope this close to its limit (px) counts as taut in a chain
+    static constexpr float ropeSlop = 0.5f;
+    static constexpr size_t noJoint = SIZE_MAX;
+
+private:
+    struct Joint {
+        JointDef def;
+        sf::Vector2f offset{};     // pins: b's centre minus a's when made
+        float impulse[2] = {};
+    };
+    // A run of rows (or of chains) that share no body; serial ones may
+    struct Colour {
+        uint32_t first = 0, last = 0;
+        bool serial = false;
+    };
+    // Rows [first, last), each joined to the next through one body
+    struct Chain {
+        uint32_t first = 0, last = 0;
+    };
+
+    void rebuild(const BodyStore& bodies);
+    void prepareVelocity(const BodyStore& bodies, float dt);
+    void preparePosition(const BodyStore& bodies, float dt);
+    float sweep(const JointRowStreams& streams, bool reverse, ThreadPool* pool);
+    float solveColour(const JointRowStreams& streams, const Colour& c, ThreadPool* pool);
+    float solveChains(const JointRowStreams& streams, const Colour& c, bool reverse, ThreadPool* pool);
+
+private:
+    std::vector<Joint> joints;
+    int velocityIterations = 10;
+    int positionIterations = 4;
+    float tolerance = 0.05f;
+    bool dirty = true;
+
+    // Solver bodies: 0 is the world, then every body some joint touches
+    std::vector<uint32_t> solverBody;     // solver body -> store index
+    std::vector<uint32_t> storeToSolver;  // store index -> solver body, 0 if none
+    AlignedVector<float> vx, vy, invMass;
+
+    // Rows: the coloured ones in colour order, then the chains'. A chain
+    // row's a is the body it shares with the row before it.
+    std::vector<uint32_t> rowJoint;
+    std::vector<uint8_t> rowAxis;         // pins: 0 = x, 1 = y
+    std::vector<uint32_t> rowA, rowB;
+    std::vector<uint8_t> rowCoupled;      // chains: solved in the block
+    AlignedVector<float> nx, ny, mass, bias, gamma, lower, upper, impulse;
+    std::vector<Colour> colours;
+    std::vector<Chain> chains;
+    std::vector<Colour> chainColours;     // ranges of 'chains'
+    std::vector<float> chainC, chainD;    // elimination scratch, by row
+    std::vector<uint32_t> taskStart;
+    std::vector<float> taskChange;
+
+    // Joined body pairs (store indices, smaller first), sorted
+    std::vector<uint64_t> joinedPairs;
+    int iterationsUsed = 0;
+};
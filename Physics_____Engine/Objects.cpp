@@ -1,11 +1,17 @@
 ﻿#include "Objects.hpp"
+#include "Scene.hpp"
 #include <cmath>
+#include <cstdio>
+#include <fstream>
 #include <algorithm>
 
-static const float gravity = 9.81f * 50.f;
-
 Objects::Objects(tgui::Gui& guiRef, sf::RenderWindow& winRef)
     : gui(guiRef), window(winRef) {
+    world.setThreadPool(&pool);
+    world.setImpactThreshold(impactThreshold);
+    world.setMaxImpacts(maxBurstsPerFrame);
+    world.setContinuousThreshold(continuousThreshold);
+    rewind.configure(rewindSeconds, rewindInterval, rewindMaxBytes);
 }
 
 void Objects::handleBoxClick() {
@@ -49,17 +55,32 @@ void Objects::handleMousePress(const sf::Vector2f& pos, const sf::FloatRect& can
     const float groundY = canvasRect.top + canvasRect.height - groundHeight;
 
     if (editMode) {
+        if (editTriggerMode) {
+            if (selectedLine) selectedLine->setSelected(false);
+            selectedLine = pickTriggerLine(pos);
+            if (selectedLine) selectedLine->setSelected(true);
+            return;
+        }
+
         if (pos.y >= groundY && canvasRect.contains(pos)) {
             openFrictionPopup();
             return;
         }
 
-        for (size_t i = 0; i < objects.size(); ++i) {
-            if (objects[i].shape && objects[i].shape->getGlobalBounds().contains(pos)) {
-                openVelocityPopup(i);
-                return;
-            }
-        }
+        int picked = pickObject(pos);
+        if (picked >= 0) openVelocityPopup(static_cast<size_t>(picked));
+        return;
+    }
+
+    if (jointPlacement) {
+        if (canvasRect.contains(pos)) placeJoint(pos);
+        return;
+    }
+
+    if (gatePlacement) {
+        if (!canvasRect.contains(pos)) return;
+        drawingGate = true;
+        gateStart = gateEnd = pos;
         return;
     }
 
@@ -111,14 +132,14 @@ void Objects::handleMousePress(const sf::Vector2f& pos, const sf::FloatRect& can
     default:
         break;
     }
-
-    tempObject.velocity = { 0.f, 0.f };
-    tempObject.elasticity = 0.5f;
-    tempObject.mass = 1.f;
 }
 
 // --- Drag & Release ---
 void Objects::handleMouseDrag(const sf::Vector2f& pos) {
+    if (drawingGate) {
+        gateEnd = pos;
+        return;
+    }
     if (!creatingObject || !tempObject.shape) return;
 
     const float left = currentCanvasRect.left;
@@ -174,115 +195,229 @@ void Objects::handleMouseDrag(const sf::Vector2f& pos) {
 }
 
 void Objects::handleMouseRelease() {
+    if (drawingGate) {
+        drawingGate = false;
+        // A click without a drag does not make a gate
+        const sf::Vector2f d = gateEnd - gateStart;
+        if (d.x * d.x + d.y * d.y >= minGateLength * minGateLength) addTriggerLine(gateStart, gateEnd);
+        return;
+    }
     if (creatingObject && tempObject.shape) {
+        const size_t index = world.addBody(makeBody(pendingType, *tempObject.shape));
         objects.push_back(std::move(tempObject));
-        openVelocityPopup(objects.size() - 1);
+        newestBody = world.getHandle(index);
+        openVelocityPopup(index);
     }
     creatingObject = false;
     pendingType = ObjectType::None;
 }
 
-// --- Draw ---
-void Objects::draw(sf::RenderWindow& window) {
-    for (auto& obj : objects) {
-        if (obj.shape) window.draw(*obj.shape);
-    }
-
-    if (creatingObject && tempObject.shape) window.draw(*tempObject.shape);
-
-    // Path tracing for the most recently selected object
-    if (pathTracingEnabled && tracedObjectIndex >= 0 && tracedObjectIndex < static_cast<int>(objects.size())) {
-        auto& obj = objects[tracedObjectIndex];
-        if (obj.shape) trajectoryCurve.append(sf::Vertex(obj.shape->getPosition(), sf::Color::Red));
-        window.draw(trajectoryCurve);
-    }
+// --- Body <-> Shape ---
+Body Objects::makeBody(ObjectType type, const sf::Shape& shape) {
+    Body body;
+    body.type = type;
+    body.position = shape.getPosition();
 
-    if (rangeLineEnabled && rangeObjectIndex >= 0 && rangeObjectIndex < static_cast<int>(objects.size())) {
-        auto& obj = objects[rangeObjectIndex];
-        sf::Vector2f pos = obj.shape->getPosition();
+    if (auto* circle = dynamic_cast<const sf::CircleShape*>(&shape))
+        body.size = { circle->getRadius(), circle->getRadius() };
+    else if (auto* rect = dynamic_cast<const sf::RectangleShape*>(&shape))
+        body.size = rect->getSize();
+    else if (auto* tri = dynamic_cast<const sf::ConvexShape*>(&shape))
+        body.size = { tri->getPoint(2).x - tri->getPoint(0).x, tri->getPoint(0).y - tri->getPoint(1).y };
 
-        if (auto* circle = dynamic_cast<sf::CircleShape*>(obj.shape.get()))
-            pos.x += circle->getRadius();
-        else if (auto* rect = dynamic_cast<sf::RectangleShape*>(obj.shape.get()))
-            pos.x += rect->getSize().x / 2.f;
-        else if (auto* tri = dynamic_cast<sf::ConvexShape*>(obj.shape.get()))
-            pos.x += (tri->getPoint(2).x - tri->getPoint(0).x) / 2.f;
+    return body;
+}
 
-        rangeLine.clear();
-        rangeLine.append(sf::Vertex(rangeStartPos, sf::Color::Red));
-        rangeLine.append(sf::Vertex({ pos.x, rangeLineY }, sf::Color::Red));
-        window.draw(rangeLine);
+// Same look as a shape drawn by hand
+std::unique_ptr<sf::Shape> Objects::makeShape(const Body& body) {
+    std::unique_ptr<sf::Shape> shape;
+    switch (body.type) {
+    case ObjectType::Circle: {
+        auto circle = std::make_unique<sf::CircleShape>(body.size.x);
+        circle->setOrigin(body.size.x, body.size.x);
+        shape = std::move(circle);
+        break;
     }
+    case ObjectType::Triangle: {
+        auto tri = std::make_unique<sf::ConvexShape>(3);
+        tri->setPoint(0, { 0.f, body.size.y });
+        tri->setPoint(1, { body.size.x / 2.f, 0.f });
+        tri->setPoint(2, { body.size.x, body.size.y });
+        shape = std::move(tri);
+        break;
+    }
+    case ObjectType::Rectangle:
+    case ObjectType::None:
+    default:
+        shape = std::make_unique<sf::RectangleShape>(body.size);
+        break;
+    }
+    shape->setFillColor(sf::Color(10, 26, 47));
+    shape->setOutlineColor(sf::Color::Black);
+    shape->setOutlineThickness(3.f);
+    shape->setPosition(body.position);
+    return shape;
 }
-// --- Update ---
-void Objects::update(float dt, bool isRunning, const sf::FloatRect& canvasRect, float groundHeight) {
-    if (!isRunning) return;
-    const float groundY = canvasRect.top + canvasRect.height - groundHeight;
 
-    for (size_t i = 0; i < objects.size(); ++i) {
-        auto& obj = objects[i];
-        if (!obj.shape) continue;
-
-        obj.velocity.y += gravity * dt;
-        obj.shape->move(obj.velocity * dt);
-
-        sf::FloatRect b = obj.shape->getGlobalBounds();
-        if (b.top + b.height >= groundY) {
-            float dy = groundY - (b.top + b.height);
-            obj.shape->move(0.f, dy);
+// --- Picking ---
+int Objects::pickObject(const sf::Vector2f& pos) const {
+    std::vector<size_t> hits;
+    world.queryPoint(pos, hits);
+    if (hits.empty()) return -1;
+    return static_cast<int>(*std::min_element(hits.begin(), hits.end()));
+}
 
-            obj.velocity.y = -obj.velocity.y * obj.elasticity;
-            obj.velocity.x *= (1.f - groundFriction);
+TriggerLine* Objects::pickTriggerLine(const sf::Vector2f& pos) {
+    TriggerLine* best = nullptr;
+    const sf::FloatRect around(pos.x - 2.f, pos.y - 2.f, 4.f, 4.f);
+    triggers.queryRect(around, [&](uint32_t i) {
+        if (triggerLines[i].containsPoint(pos) && (!best || &triggerLines[i] < best))
+            best = &triggerLines[i];
+        return true;
+    });
+    return best;
+}
 
-            if (std::abs(obj.velocity.y) < 1.f) obj.velocity.y = 0.f;
-            if (std::abs(obj.velocity.x) < 1.f) obj.velocity.x = 0.f;
+// --- Draw ---
+void Objects::draw(sf::RenderWindow& window) {
+    // Only bodies inside the current view are synced and drawn
+    const sf::View& view = window.getView();
+    const sf::FloatRect viewRect(view.getCenter() - view.getSize() / 2.f, view.getSize());
+
+    visibleObjects.clear();
+    world.queryRect(viewRect, visibleObjects);
+    std::sort(visibleObjects.begin(), visibleObjects.end());
+
+    if (batchedRendering) {
+        const BodyStore& bodies = world.getStore();
+        renderer.beginBodies();
+        for (size_t i : visibleObjects) {
+            const auto& obj = objects[i];
+            if (!obj.shape) continue;
+            sf::Color fill = obj.shape->getFillColor();
+            if (obj.flashTimer > 0.f) {
+                const float f = obj.flashTimer / flashDuration;
+                fill.r = static_cast<sf::Uint8>(fill.r + (255 - fill.r) * f);
+                fill.g = static_cast<sf::Uint8>(fill.g + (255 - fill.g) * f);
+                fill.b = static_cast<sf::Uint8>(fill.b + (255 - fill.b) * f);
+            }
+            renderer.addBody(bodies, i, world.getInterpolatedPosition(i, stepper.getAlpha()),
+                             fill, obj.shape->getOutlineColor());
+        }
+        renderer.drawBodies(window);
+    }
+    else {
+        for (size_t i : visibleObjects) {
+            auto& obj = objects[i];
+            if (!obj.shape) continue;
+            // setPosition always invalidates the shape's transform; resting
+            // bodies keep theirs
+            const sf::Vector2f pos = world.getInterpolatedPosition(i, stepper.getAlpha());
+            if (obj.shape->getPosition() != pos) obj.shape->setPosition(pos);
+            window.draw(*obj.shape);
         }
+    }
 
-        for (size_t j = i + 1; j < objects.size(); ++j) {
-            auto& A = objects[i];
-            auto& B = objects[j];
-            if (!A.shape || !B.shape) continue;
+    drawJoints(window, viewRect);
+
+    triggers.queryRect(viewRect, [&](uint32_t i) {
+        TriggerLine& line = triggerLines[i];
+        line.lineShape.setFillColor(line.hitTimer > 0.f ? sf::Color::Green
+                                    : line.selected ? sf::Color::Yellow : sf::Color::Red);
+        window.draw(line.lineShape);
+        return true;
+    });
+    if (drawingGate) {
+        const sf::Vertex gate[] = { sf::Vertex(gateStart, sf::Color::Red), sf::Vertex(gateEnd, sf::Color::Red) };
+        window.draw(gate, 2, sf::Lines);
+    }
 
-            if (A.shape->getGlobalBounds().intersects(B.shape->getGlobalBounds())) {
-                sf::Vector2f posA = A.shape->getPosition();
-                sf::Vector2f posB = B.shape->getPosition();
+    if (creatingObject && tempObject.shape) window.draw(*tempObject.shape);
 
-                sf::Vector2f n = posB - posA;
-                float dist2 = n.x * n.x + n.y * n.y;
-                if (dist2 == 0.f) continue;
+    particles.draw(window);
+    trajectories.draw(window, world, stepper.getAlpha());
 
-                float dist = std::sqrt(dist2);
-                n /= dist;
+    // Finished range lines and the live one in a single line list
+    rangeLine.clear();
+    for (const RangeSegment& r : completedRangeLines) {
+        rangeLine.append(sf::Vertex(r.start, sf::Color::Red));
+        rangeLine.append(sf::Vertex(r.end, sf::Color::Red));
+    }
+    if (rangeLineEnabled && world.contains(rangeBody)) {
+        rangeLine.append(sf::Vertex(rangeStartPos, sf::Color::Red));
+        rangeLine.append(sf::Vertex(currentRangeEnd(), sf::Color::Red));
+    }
+    if (rangeLine.getVertexCount() > 0) window.draw(rangeLine);
 
-                sf::Vector2f rel = B.velocity - A.velocity;
-                float relVel = rel.x * n.x + rel.y * n.y;
+    if (velPopup) drawPrediction(window);
+}
 
-                if (relVel > 0.f) continue;
+sf::Vector2f Objects::currentRangeEnd() const {
+    // From the cached bounds: the right edge of circles, the middle of the rest
+    const BodyStore& b = world.getStore();
+    const size_t i = world.indexOf(rangeBody);
+    const float x = b.type[i] == ObjectType::Circle ? b.maxX[i] - BodyStore::outlineThickness
+                                                    : (b.minX[i] + b.maxX[i]) / 2.f;
+    return { x, rangeLineY };
+}
+// --- Update ---
+float Objects::update(float dt, bool isRunning, const sf::FloatRect& canvasRect, float groundHeight) {
+    triggerEvents.clear();
+    // Kept current while paused too, for the predicted path
+    world.setGroundY(canvasRect.top + canvasRect.height - groundHeight);
+    if (!isRunning || isReplaying()) return 0.f;
+
+    const int steps = stepper.advance(dt);
+    size_t bursts = 0;
+    for (int s = 0; s < steps; ++s) {
+        world.step(stepper.getStepDt());
+        triggers.detect(world, s * stepper.getStepDt(), stepper.getStepDt(), triggerEvents);
+        trajectories.record(world);
+        recorder.capture(world, ++stepCount);
+        rewindTime += stepper.getStepDt();
+        rewind.record(world, rewindTime);
+
+        for (const ImpactEvent& impact : world.getImpacts()) {
+            if (bursts == maxBurstsPerFrame) break;
+            triggerCollisionEffects(impact);
+            ++bursts;
+        }
+    }
 
-                float e = std::min(A.elasticity, B.elasticity);
-                float invMassSum = (1.f / A.mass) + (1.f / B.mass);
-                if (invMassSum <= 0.f) continue;
+    const float simulated = steps * stepper.getStepDt();
+    particles.update(simulated, world.getGravity());
+    for (auto& obj : objects)
+        obj.flashTimer = std::max(0.f, obj.flashTimer - simulated);
+    for (auto& line : triggerLines)
+        line.hitTimer = std::max(0.f, line.hitTimer - simulated);
+    for (const TriggerEvent& e : triggerEvents)
+        triggerLines[e.line].hitTimer = gateFlashDuration;
+    return simulated;
+}
 
-                float jVal = -(1.f + e) * relVel / invMassSum;
-                sf::Vector2f impulse = jVal * n;
+// --- Collision Effects ---
+// Sparks fly both ways along the contact tangent, faster and more of them
+// for harder hits
+void Objects::triggerCollisionEffects(const ImpactEvent& impact) {
+    const sf::Vector2f tangent(-impact.normal.y, impact.normal.x);
+    const size_t count = std::clamp<size_t>(static_cast<size_t>(impact.impulse / 100.f), 2, 8);
+    const float speed = std::min(impact.impulse * 0.5f, 400.f);
 
-                A.velocity -= (1.f / A.mass) * impulse;
-                B.velocity += (1.f / B.mass) * impulse;
+    particles.spawnBurst(impact.point, tangent, speed, count / 2);
+    particles.spawnBurst(impact.point, -tangent, speed, count - count / 2);
 
-                const float penetration = 1.f;
-                A.shape->move(-n * penetration * 0.5f);
-                B.shape->move(n * penetration * 0.5f);
-            }
-        }
-    }
+    if (impact.a < objects.size()) objects[impact.a].flashTimer = flashDuration;
+    if (impact.b < objects.size()) objects[impact.b].flashTimer = flashDuration;
 }
 
 // --- Velocity Popup ---
 void Objects::openVelocityPopup(size_t index) {
     if (velPopup && velPopup->isVisible()) return;
+    const BodyHandle body = world.getHandle(index);
+    velBody = body;
 
     velPopup = tgui::ChildWindow::create("Velocity / Angle / Elasticity / Mass");
-    velPopup->setSize({ 240.f, 300.f });
+    velPopup->setSize({ 240.f, 420.f });
     velPopup->setPosition({ 400.f, 250.f });
     velPopup->getRenderer()->setBackgroundColor(tgui::Color(18, 26, 38));
     velPopup->getRenderer()->setBorderColor(tgui::Color(74, 106, 148));
@@ -314,6 +449,17 @@ void Objects::openVelocityPopup(size_t index) {
     massBox->setText("1.0");
     velPopup->add(massBox);
 
+    fastBox = tgui::CheckBox::create("Fast (continuous collision)");
+    fastBox->setPosition({ 20.f, 300.f });
+    fastBox->setChecked(world.isFast(index));
+    velPopup->add(fastBox);
+
+    predictionLabel = tgui::Label::create("");
+    predictionLabel->setTextSize(13);
+    predictionLabel->getRenderer()->setTextColor(sf::Color(255, 220, 90));
+    predictionLabel->setPosition({ 20.f, 330.f });
+    velPopup->add(predictionLabel);
+
     auto applyBtn = tgui::Button::create("Apply");
     applyBtn->setSize({ 200.f, 30.f });
     applyBtn->setPosition({ 20.f, 180.f });
@@ -325,26 +471,132 @@ void Objects::openVelocityPopup(size_t index) {
     deleteBtn->getRenderer()->setTextColor(tgui::Color::Red);
     velPopup->add(deleteBtn);
 
-    applyBtn->onPress([this, index]() {
-        if (index >= objects.size()) return;
+    auto traceBtn = tgui::Button::create(trajectories.isTraced(body) ? "Stop Tracing" : "Trace Path");
+    traceBtn->setSize({ 200.f, 30.f });
+    traceBtn->setPosition({ 20.f, 260.f });
+    velPopup->add(traceBtn);
+
+    applyBtn->onPress([this, body]() {
+        const size_t index = world.indexOf(body);
+        if (index == BodyStore::noBody) return;
 
         float speed = speedBox->getText().toFloat();
         float angle = angleBox->getText().toFloat() * 3.14159265f / 180.f;
         float elasticity = std::clamp(elasticityBox->getText().toFloat(), 0.f, 1.f);
         float mass = std::max(0.01f, massBox->getText().toFloat());
 
-        objects[index].velocity.x = speed * std::cos(angle);
-        objects[index].velocity.y = -speed * std::sin(angle);
-        objects[index].elasticity = elasticity;
-        objects[index].mass = mass;
+        Body body = world.getBody(index);
+        body.velocity.x = speed * std::cos(angle);
+        body.velocity.y = -speed * std::sin(angle);
+        body.elasticity = elasticity;
+        body.mass = mass;
+        body.fast = fastBox->isChecked();
+        world.setBody(index, body);
 
         if (velPopup) velPopup->close();
         });
 
-    deleteBtn->onPress([this, index]() {
-        if (index < objects.size()) objects.erase(objects.begin() + static_cast<std::ptrdiff_t>(index));
+    deleteBtn->onPress([this, body]() {
+        if (rangeLineEnabled && rangeBody == body) toggleRangeLine();
+        removeObject(body);
         if (velPopup) velPopup->close();
         });
+
+    traceBtn->onPress([this, body]() {
+        if (!world.contains(body)) return;
+        if (trajectories.isTraced(body)) trajectories.untrace(body);
+        else trajectories.trace(body);
+        if (velPopup) velPopup->close();
+        });
+}
+
+// --- Removal ---
+// Traces, the range line and open popups hold handles, which simply stop
+// resolving; only the shapes mirror the world's indices and follow its
+// swap with the last body.
+bool Objects::removeObject(BodyHandle body) {
+    const size_t index = world.indexOf(body);
+    if (index == BodyStore::noBody) return false;
+    world.removeBody(index);
+    objects[index] = std::move(objects.back());
+    objects.pop_back();
+    return true;
+}
+
+size_t Objects::removeObjects(const std::vector<BodyHandle>& bodies) {
+    std::vector<size_t> removedAt;
+    const size_t removed = world.removeBodies(bodies, &removedAt);
+    for (size_t index : removedAt) {
+        objects[index] = std::move(objects.back());
+        objects.pop_back();
+    }
+    return removed;
+}
+
+// --- Predicted Path ---
+// Redone every frame from the popup's fields, so the arc follows the
+// values as they are typed (and the body, if the simulation is running).
+// Drawn for the body's centre; the prediction itself tracks its anchor.
+void Objects::drawPrediction(sf::RenderWindow& window) {
+    const size_t velIndex = world.indexOf(velBody);
+    if (velIndex == BodyStore::noBody) return;
+
+    const float speed = speedBox->getText().toFloat();
+    const float angle = angleBox->getText().toFloat() * 3.14159265f / 180.f;
+    const BodyStore& b = world.getStore();
+    BallisticLaunch launch;
+    launch.position = { b.posX[velIndex], b.posY[velIndex] };
+    launch.velocity = { speed * std::cos(angle), -speed * std::sin(angle) };
+    launch.restitution = std::clamp(elasticityBox->getText().toFloat(), 0.f, 1.f);
+    launch.bottom = b.localMaxY[velIndex];
+
+    BallisticSettings settings = BallisticSettings::fromWorld(world, stepper.getStepDt());
+    settings.horizon = predictionHorizon;
+    prediction.clear();
+    prediction.add(launch);
+    prediction.predict(settings);
+
+    const sf::Vector2f centre((b.localMinX[velIndex] + b.localMaxX[velIndex]) / 2.f,
+                              (b.localMinY[velIndex] + b.localMaxY[velIndex]) / 2.f);
+    const sf::Color color(255, 220, 90);
+    predictedPath.clear();
+    prediction.samplePath(0, 2, predictedPath);
+    predictedArc.clear();
+    for (const sf::Vector2f& p : predictedPath) predictedArc.append(sf::Vertex(p + centre, color));
+    window.draw(predictedArc);
+
+    // Landing and bounce points
+    sf::CircleShape marker(4.f);
+    marker.setOrigin(4.f, 4.f);
+    marker.setFillColor(sf::Color::Transparent);
+    marker.setOutlineColor(color);
+    marker.setOutlineThickness(2.f);
+    for (size_t k = 0; k < prediction.getFlightCount(0); ++k) {
+        const BallisticFlight& f = prediction.getFlight(0, k);
+        if (!f.landed) continue;
+        marker.setPosition(f.end + centre);
+        window.draw(marker);
+    }
+
+    const BallisticResult& r = prediction.getResult(0);
+    char text[128];
+    if (!r.landed) {
+        std::snprintf(text, sizeof(text), "No landing within %.0f s", predictionHorizon);
+    }
+    else if (r.rests) {
+        std::snprintf(text, sizeof(text), "Lands %.0f px away at %.2f s\n%u bounces, rests %.0f px away at %.2f s",
+                      r.landing.x - launch.position.x, r.landingTime, r.bounces, r.rest.x - launch.position.x, r.restTime);
+    }
+    else if (r.restTime < predictionHorizon - settings.dt) {
+        // Stopped at settings.maxBounces, not at the horizon
+        std::snprintf(text, sizeof(text), "Lands %.0f px away at %.2f s\n%u bounces, bounce limit reached at %.2f s",
+                      r.landing.x - launch.position.x, r.landingTime, r.bounces, r.restTime);
+    }
+    else {
+        std::snprintf(text, sizeof(text), "Lands %.0f px away at %.2f s\n%u bounces, still moving at %.0f s",
+                      r.landing.x - launch.position.x, r.landingTime, r.bounces, r.restTime);
+    }
+    predictionLabel->setText(text);
 }
 
 // --- Friction Popup ---
@@ -363,7 +615,7 @@ void Objects::openFrictionPopup() {
     frictionBox = tgui::EditBox::create();
     frictionBox->setSize({ 180.f, 30.f });
     frictionBox->setPosition({ 20.f, 20.f });
-    frictionBox->setText(std::to_string(groundFriction));
+    frictionBox->setText(std::to_string(world.getGroundFriction()));
     frictionPopup->add(frictionBox);
 
     auto applyBtn = tgui::Button::create("Apply");
@@ -372,7 +624,7 @@ void Objects::openFrictionPopup() {
     frictionPopup->add(applyBtn);
 
     applyBtn->onPress([this]() {
-        groundFriction = std::clamp(frictionBox->getText().toFloat(), 0.f, 1.f);
+        world.setGroundFriction(std::clamp(frictionBox->getText().toFloat(), 0.f, 1.f));
         if (frictionPopup) frictionPopup->close();
         });
 }
@@ -380,27 +632,288 @@ void Objects::openFrictionPopup() {
 // --- Path Tracing ---
 void Objects::enablePathTracing() {
     if (objects.empty()) return;
-    pathTracingEnabled = true;
-    tracedObjectIndex = static_cast<int>(objects.size()) - 1;
-    trajectoryCurve.clear();
+    const BodyHandle body = newestObject();
+    if (trajectories.isTraced(body)) trajectories.untrace(body);
+    else trajectories.trace(body);
+}
+
+// The body created last, or if that one is gone, the one at the end
+BodyHandle Objects::newestObject() const {
+    return world.contains(newestBody) ? newestBody : world.getHandle(world.size() - 1);
 }
 
 // --- Range Line ---
 void Objects::toggleRangeLine() {
     if (objects.empty()) return;
 
+    // Keep the finished line, overwriting the oldest once the ring is full
+    if (rangeLineEnabled && world.contains(rangeBody)) {
+        const RangeSegment done{ rangeStartPos, currentRangeEnd() };
+        if (completedRangeLines.size() < maxCompletedRangeLines) {
+            completedRangeLines.push_back(done);
+        }
+        else {
+            completedRangeLines[completedRangeHead] = done;
+            completedRangeHead = (completedRangeHead + 1) % maxCompletedRangeLines;
+        }
+    }
+
     rangeLineEnabled = !rangeLineEnabled;
     if (rangeLineEnabled) {
-        rangeObjectIndex = static_cast<int>(objects.size()) - 1;
-        rangeStartPos = objects[rangeObjectIndex].shape->getPosition();
+        rangeBody = newestObject();
+        rangeStartPos = world.getPosition(world.indexOf(rangeBody));
         rangeLineY = rangeStartPos.y;
         currentRangeX = rangeStartPos.x;
         rangeActive = true;
     }
     else {
-        rangeObjectIndex = -1;
+        rangeBody = BodyHandle();
         rangeActive = false;
     }
-    rangeLine.clear();
 }
 
+// --- Trigger Lines ---
+void Objects::addTriggerLine(const sf::Vector2f& start, const sf::Vector2f& end) {
+    // Growing the vector moves the lines, so drop the selection pointer
+    if (selectedLine) selectedLine->setSelected(false);
+    selectedLine = nullptr;
+
+    triggerLines.emplace_back(start, end);
+    triggers.add(start, end);
+}
+
+void Objects::setGatePlacement(bool on) {
+    gatePlacement = on;
+    drawingGate = false;
+    if (on) {
+        creatingObject = false;
+        pendingType = ObjectType::None;
+        setJointPlacement(false);
+    }
+}
+
+// --- Joints ---
+void Objects::setJointPlacement(bool on, JointType type) {
+    jointPlacement = on;
+    jointType = type;
+    jointBody = BodyHandle();
+    if (on) {
+        creatingObject = false;
+        pendingType = ObjectType::None;
+        gatePlacement = drawingGate = false;
+    }
+}
+
+void Objects::placeJoint(const sf::Vector2f& pos) {
+    const int picked = pickObject(pos);
+    if (!world.contains(jointBody)) {
+        jointBody = picked >= 0 ? world.getHandle(static_cast<size_t>(picked)) : BodyHandle();
+        return;
+    }
+
+    const BodyHandle first = jointBody;
+    jointBody = BodyHandle();
+    if (picked >= 0 && world.getHandle(static_cast<size_t>(picked)) == first) return;
+    const BodyHandle second = picked >= 0 ? world.getHandle(static_cast<size_t>(picked)) : BodyHandle();
+
+    if (jointType != JointType::Rope) {
+        JointDef joint;
+        joint.type = jointType;
+        joint.a = first;
+        joint.b = second;
+        joint.anchor = pos;
+        world.addJoint(joint);
+        return;
+    }
+
+    const sf::Vector2f from = world.getStore().centre(world.indexOf(first));
+    const sf::Vector2f to = picked >= 0 ? world.getStore().centre(static_cast<size_t>(picked)) : pos;
+    const float gap = std::hypot(to.x - from.x, to.y - from.y);
+    RopeDef rope;
+    rope.a = first;
+    rope.b = second;
+    rope.anchor = pos;
+    rope.segments = std::clamp<size_t>(static_cast<size_t>(gap / ropeSegmentLength), 2, maxRopeSegments);
+    const size_t segment = world.addRope(rope);
+    if (segment == BodyStore::noBody) return;
+    for (size_t i = segment; i < world.size(); ++i) {
+        objects.emplace_back();
+        objects.back().shape = makeShape(world.getBody(i));
+    }
+    newestBody = world.getHandle(world.size() - 1);
+}
+
+// Every joint in view as one line list, between the interpolated centres,
+// plus a cross on a body picked for a new joint
+void Objects::drawJoints(sf::RenderWindow& window, const sf::FloatRect& viewRect) {
+    const BodyStore& b = world.getStore();
+    const float alpha = stepper.getAlpha();
+    const auto centre = [&](size_t i) {
+        return world.getInterpolatedPosition(i, alpha)
+               + sf::Vector2f((b.localMinX[i] + b.localMaxX[i]) * 0.5f, (b.localMinY[i] + b.localMaxY[i]) * 0.5f);
+    };
+
+    jointLines.clear();
+    for (size_t k = 0; k < world.getJointCount(); ++k) {
+        const JointDef& j = world.getJoint(k);
+        const size_t ia = world.indexOf(j.a);
+        const size_t ib = j.toWorld() ? BodyStore::noBody : world.indexOf(j.b);
+        if (ia == BodyStore::noBody || (!j.toWorld() && ib == BodyStore::noBody)) continue;
+
+        const sf::Vector2f pa = centre(ia);
+        const sf::Vector2f pb = j.toWorld() ? j.anchor : centre(ib);
+        const sf::FloatRect extent(std::min(pa.x, pb.x), std::min(pa.y, pb.y), std::abs(pb.x - pa.x) + 1.f, std::abs(pb.y - pa.y) + 1.f);
+        if (!extent.intersects(viewRect)) continue;
+
+        sf::Color colour;
+        switch (j.type) {
+        case JointType::Spring: colour = sf::Color(90, 210, 120); break;
+        case JointType::Rope: colour = sf::Color(196, 150, 90); break;
+        case JointType::Pin: colour = sf::Color(230, 80, 80); break;
+        case JointType::Distance:
+        default: colour = sf::Color(220, 220, 235); break;
+        }
+        jointLines.append(sf::Vertex(pa, colour));
+        jointLines.append(sf::Vertex(pb, colour));
+    }
+
+    if (jointPlacement && world.contains(jointBody)) {
+        const sf::Vector2f p = centre(world.indexOf(jointBody));
+        const float r = 6.f;
+        for (const sf::Vector2f& d : { sf::Vector2f(r, r), sf::Vector2f(r, -r) }) {
+            jointLines.append(sf::Vertex(p - d, sf::Color::Yellow));
+            jointLines.append(sf::Vertex(p + d, sf::Color::Yellow));
+        }
+    }
+    if (jointLines.getVertexCount() > 0) window.draw(jointLines);
+}
+
+// --- Scene Files ---
+bool Objects::saveScene(const std::string& path, std::string& error) const {
+    return ::saveScene(path, world, triggers.getLines(), error);
+}
+
+bool Objects::loadScene(const std::string& path, std::string& error) {
+    // A missing file should not cost the current scene
+    if (!std::ifstream(path)) {
+        error = "cannot open " + path;
+        return false;
+    }
+
+    closeReplay();
+    resetSceneState();
+    rewind.clear();
+    world.clear();
+    std::vector<SceneLine> lines;
+    const bool ok = ::loadScene(path, world, &lines, error);
+
+    // A text file that fails halfway keeps what was read before the error,
+    // so the shapes mirror whatever the world ended up with
+    rebuildShapes();
+
+    if (selectedLine) selectedLine->setSelected(false);
+    selectedLine = nullptr;
+    triggerLines.clear();
+    triggers.clear();
+    for (const SceneLine& line : lines) addTriggerLine(line.start, line.end);
+    return ok;
+}
+
+void Objects::resetSceneState() {
+    if (velPopup) velPopup->close();
+    if (frictionPopup) frictionPopup->close();
+    creatingObject = false;
+    pendingType = ObjectType::None;
+    rangeLineEnabled = false;
+    rangeActive = false;
+    rangeBody = BodyHandle();
+    completedRangeLines.clear();
+    completedRangeHead = 0;
+    trajectories.clear();
+    particles.clear();
+    jointBody = BodyHandle();
+}
+
+void Objects::rebuildShapes() {
+    objects.clear();
+    objects.resize(world.size());
+    for (size_t i = 0; i < objects.size(); ++i) objects[i].shape = makeShape(world.getBody(i));
+}
+
+// --- Recording / Replay ---
+bool Objects::startRecording(const std::string& path, std::string& error) {
+    closeReplay();
+    recorder.setMaxBytes(maxRecordingBytes);
+    if (!recorder.start(path, stepper.getStepDt(), error)) return false;
+    recorder.capture(world, stepCount);
+    return true;
+}
+
+bool Objects::openReplay(const std::string& path, std::string& error) {
+    stopRecording();
+    if (!replay.open(path, error)) return false;
+    scrubReplay(0.f);
+    return true;
+}
+
+float Objects::getReplayDuration() const {
+    return static_cast<float>(replay.getLastStep() - replay.getFirstStep()) * replay.getStepDt();
+}
+
+float Objects::getReplayTime() const {
+    return static_cast<float>(replay.getStep() - replay.getFirstStep()) * replay.getStepDt();
+}
+
+void Objects::scrubReplay(float seconds) {
+    if (!isReplaying()) return;
+    const float steps = std::max(0.f, seconds) / std::max(replay.getStepDt(), 1e-6f);
+    if (!replay.seek(replay.getFirstStep() + static_cast<uint64_t>(steps + 0.5f))) return;
+
+    // Bodies were added, removed or reshaped while recording: rebuild the
+    // scene from the frame, otherwise only move what is there
+    const BodyColumns frame = replay.getColumns();
+    const BodyStore& bodies = world.getStore();
+    bool sameBodies = world.size() == frame.count;
+    for (size_t i = 0; sameBodies && i < frame.count; ++i) {
+        sameBodies = static_cast<uint8_t>(bodies.type[i]) == frame.type[i]
+                     && bodies.size[i].x == frame.sizeX[i] && bodies.size[i].y == frame.sizeY[i];
+    }
+
+    if (sameBodies) {
+        replay.apply(world);
+    }
+    else {
+        resetSceneState();
+        world.clear();
+        world.addBodies(frame);
+        rebuildShapes();
+    }
+    stepCount = replay.getStep();
+    rewind.clear();
+}
+
+// --- Snapshots / Rewind ---
+void Objects::restoreSnapshot(const WorldSnapshot& snapshot) {
+    closeReplay();
+    if (world.restoreSnapshot(snapshot)) {
+        resetSceneState();
+        rebuildShapes();
+    }
+    rewind.clear();
+    rewindTime = 0.f;
+}
+
+bool Objects::stepBack(float& seconds) {
+    if (isReplaying()) return false;
+    float time = rewindTime;
+    bool bodiesChanged = false;
+    if (!rewind.stepBack(world, time, &bodiesChanged)) return false;
+
+    if (bodiesChanged) {
+        resetSceneState();
+        rebuildShapes();
+    }
+    seconds = std::max(0.f, seconds - (rewindTime - time));
+    rewindTime = time;
+    return true;
+}
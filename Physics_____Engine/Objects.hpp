@@ -1,6 +1,15 @@
 ﻿#pragma once
 #include <SFML/Graphics.hpp>
 #include <TGUI/TGUI.hpp>
+#include "World.hpp"
+#include "FixedStep.hpp"
+#include "BatchRenderer.hpp"
+#include "TrajectoryRecorder.hpp"
+#include "ParticleSystem.hpp"
+#include "Recording.hpp"
+#include "Rewind.hpp"
+#include "Triggers.hpp"
+#include "Ballistics.hpp"
 #include <memory>
 #include <vector>
 #include <algorithm>
@@ -8,28 +17,16 @@
 #include <cmath>
 
 // ---------------------
-// ---------------------
-struct Particle {
-    sf::CircleShape shape;
-    sf::Vector2f velocity;
-    float lifetime = 0.f;
-};
-
-
-enum class ObjectType { None, Circle, Rectangle, Triangle };
-
-
+// Cold per-body data: the SFML shape drawn for a World body plus effect
+// state. The hot simulation state lives in the World's BodyStore;
+// objects[i] always mirrors world body i.
 // ---------------------
 struct PhysicsObject {
     std::unique_ptr<sf::Shape> shape;
-    sf::Vector2f velocity{};
-    float elasticity = 0.5f;
-    float mass = 1.f;
 
     // Animation / Effects
     float flashTimer = 0.f;
     float squashScale = 1.f;
-    std::vector<Particle> particles;
 };
 
 // ---------------------
@@ -39,6 +36,7 @@ struct TriggerLine {
     sf::Vector2f start;
     sf::Vector2f end;
     bool selected = false;
+    float hitTimer = 0.f;   // flashes after a body crosses it
 
     TriggerLine() = default;
     TriggerLine(const sf::Vector2f& s, const sf::Vector2f& e)
@@ -54,6 +52,11 @@ struct TriggerLine {
     bool containsPoint(const sf::Vector2f& point) const {
         return lineShape.getGlobalBounds().contains(point);
     }
+
+    void setSelected(bool s) {
+        selected = s;
+        lineShape.setFillColor(s ? sf::Color::Yellow : sf::Color::Red);
+    }
 };
 
 // ---------------------
@@ -72,21 +75,122 @@ public:
     void handleMouseDrag(const sf::Vector2f& pos);
     void handleMouseRelease();
 
-    // Update & Draw
+    // Update & Draw. update() runs as many fixed steps as the frame time
+    // allows and returns the simulated time; draw() interpolates between
+    // the last two steps.
     void draw(sf::RenderWindow& window);
-    void update(float dt, bool isRunning, const sf::FloatRect& canvasRect, float groundHeight = 60.f);
+    float update(float dt, bool isRunning, const sf::FloatRect& canvasRect, float groundHeight = 60.f);
 
-    const std::vector<PhysicsObject>& getObjects() const { return objects; }
+    FixedStepper& getStepper() { return stepper; }
 
-    // Path tracing
+    // Batched drawing (one call for all bodies) or one draw per shape,
+    // kept for frame-time comparison
+    void setBatchedRendering(bool enabled) { batchedRendering = enabled; }
+    bool isBatchedRendering() const { return batchedRendering; }
+    BatchRenderer& getRenderer() { return renderer; }
+
+    World& getWorld() { return world; }
+    const World& getWorld() const { return world; }
+
+    // Path tracing: toggles a trace on the most recently created body.
+    // Any number of bodies (up to the recorder's track limit) can be
+    // traced at once; the velocity popup toggles individual bodies.
     void enablePathTracing();
+    TrajectoryRecorder& getTrajectories() { return trajectories; }
 
-    // Range line toggle
+    // Range line toggle. Finished lines are kept, oldest dropped first.
     void toggleRangeLine();
+    static constexpr size_t maxCompletedRangeLines = 16;
+
+    // Removes bodies with their shapes, each in O(1); handles already
+    // gone are skipped. Returns false / the count actually removed.
+    bool removeObject(BodyHandle body);
+    size_t removeObjects(const std::vector<BodyHandle>& bodies);
+
+    // Collision effects: impacts above the threshold spray particles from
+    // one shared pool and flash both bodies. At most maxBurstsPerFrame
+    // impacts are turned into effects per frame, so a busy pile costs a
+    // bounded slice of the frame.
+    ParticleSystem& getParticles() { return particles; }
+    static constexpr float impactThreshold = 150.f;
+    static constexpr size_t maxBurstsPerFrame = 128;
+    static constexpr float flashDuration = 0.12f;
+
+    // Bodies moving further than their own smallest extent in one step are
+    // swept for continuous collision, flagged or not (see World)
+    static constexpr float continuousThreshold = 1.f;
+
+    // While the velocity popup is open, the path its current speed, angle
+    // and elasticity would give the body (ground only, see BallisticBatch)
+    // is drawn over the scene, with its landing and bounce points, up to
+    // predictionHorizon seconds ahead.
+    static constexpr float predictionHorizon = 10.f;
 
-    // Trigger lines
+    // Trigger lines (timing gates). Every step, bodies that cross a line
+    // produce an event stamped with the time they touched it; the events
+    // of the last update() are kept until the next one, their times
+    // counted from the start of that update() (the caller owns the clock).
+    // While gate placement is on, a left drag draws a new line instead of
+    // a body.
     void addTriggerLine(const sf::Vector2f& start, const sf::Vector2f& end);
+    const TriggerSet& getTriggers() const { return triggers; }
+    const std::vector<TriggerEvent>& getTriggerEvents() const { return triggerEvents; }
+    void setGatePlacement(bool on);
+    bool isPlacingGates() const { return gatePlacement; }
     bool editTriggerMode = false;
+    static constexpr float gateFlashDuration = 0.25f;
+    static constexpr float minGateLength = 4.f;
+
+    // Joint placement: while on, a left click picks a body and a second
+    // click joins it to the body under the cursor, or to that point of the
+    // world if there is none (a click on the picked body lets it go).
+    // Ropes are laid as a chain of small bodies, one per ropeSegmentLength
+    // of the gap, at most maxRopeSegments. Gate placement turns this off.
+    void setJointPlacement(bool on, JointType type = JointType::Distance);
+    bool isPlacingJoints() const { return jointPlacement; }
+    JointType getJointPlacementType() const { return jointType; }
+    static constexpr float ropeSegmentLength = 12.f;
+    static constexpr size_t maxRopeSegments = 40;
+
+    // Scene files (text or .pscene, see Scene.hpp). Loading replaces all
+    // bodies and trigger lines; the ground keeps following the canvas.
+    bool saveScene(const std::string& path, std::string& error) const;
+    bool loadScene(const std::string& path, std::string& error);
+
+    // Recording: every fixed step is streamed to 'path' while running.
+    // Recordings stop on their own at maxRecordingBytes.
+    bool startRecording(const std::string& path, std::string& error);
+    void stopRecording() { recorder.stop(); }
+    bool isRecording() const { return recorder.isRecording(); }
+    const RecordingWriter& getRecorder() const { return recorder; }
+    static constexpr uint64_t maxRecordingBytes = uint64_t(2) << 30;
+
+    // Replay: shows the recorded state at any time without simulating.
+    // update() does not step while a replay is open; closing it leaves
+    // the scene at the shown frame, so the run can go on from there.
+    bool openReplay(const std::string& path, std::string& error);
+    void closeReplay() { replay.close(); }
+    bool isReplaying() const { return replay.isOpen(); }
+    float getReplayDuration() const;
+    float getReplayTime() const;
+    void scrubReplay(float seconds);
+
+    // Snapshots of the whole simulation (Reset). Restoring rebuilds the
+    // shapes only if bodies were added, removed or reshaped since, and
+    // clears the rewind history.
+    void saveSnapshot(WorldSnapshot& snapshot) const { world.saveSnapshot(snapshot); }
+    void restoreSnapshot(const WorldSnapshot& snapshot);
+
+    // Rewind: the last rewindSeconds of the run, one snapshot per
+    // rewindInterval of simulated time. stepBack() goes to the snapshot
+    // before the current time and moves 'seconds' back by as much. The
+    // history never holds more than rewindMaxBytes; big scenes get fewer,
+    // further apart snapshots instead (see RewindBuffer).
+    bool stepBack(float& seconds);
+    const RewindBuffer& getRewind() const { return rewind; }
+    static constexpr float rewindSeconds = 10.f;
+    static constexpr float rewindInterval = 0.1f;
+    static constexpr size_t rewindMaxBytes = size_t(256) << 20;
 
 private:
     static float clampf(float v, float lo, float hi) { return std::max(lo, std::min(v, hi)); }
@@ -94,19 +198,45 @@ private:
     // Popups
     void openVelocityPopup(size_t index);
     void openFrictionPopup();
+    void drawPrediction(sf::RenderWindow& window);
+
+    // Body <-> shape mirroring
+    static Body makeBody(ObjectType type, const sf::Shape& shape);
+    static std::unique_ptr<sf::Shape> makeShape(const Body& body);
 
-    // Collision handling
-    void resolveCollision(PhysicsObject& A, PhysicsObject& B);
+    // Picking (lowest index wins, like the old front-to-back scan)
+    int pickObject(const sf::Vector2f& pos) const;
+    TriggerLine* pickTriggerLine(const sf::Vector2f& pos);
+
+    sf::Vector2f currentRangeEnd() const;
+    BodyHandle newestObject() const;
 
     // Trigger effects
-    void triggerCollisionEffects(PhysicsObject& obj, const sf::Vector2f& impactDir, float impactStrength);
+    void triggerCollisionEffects(const ImpactEvent& impact);
+
+    // Joints
+    void placeJoint(const sf::Vector2f& pos);
+    void drawJoints(sf::RenderWindow& window, const sf::FloatRect& viewRect);
+
+    // Drops per-scene UI state (popups, range lines, traces, effects)
+    // before the bodies are replaced wholesale
+    void resetSceneState();
+    // Recreates every shape from its world body
+    void rebuildShapes();
 
 private:
     tgui::Gui& gui;
     sf::RenderWindow& window;
 
-    std::vector<PhysicsObject> objects;
+    ThreadPool pool;
+    World world;
+    FixedStepper stepper;
+    std::vector<PhysicsObject> objects;     // objects[i] draws world body i
+    BodyHandle newestBody;
     PhysicsObject tempObject;
+    std::vector<size_t> visibleObjects;
+    BatchRenderer renderer;
+    bool batchedRendering = true;
 
     bool creatingObject = false;
     ObjectType pendingType = ObjectType::None;
@@ -121,29 +251,58 @@ private:
     tgui::EditBox::Ptr angleBox;
     tgui::EditBox::Ptr elasticityBox;
     tgui::EditBox::Ptr massBox;
+    tgui::CheckBox::Ptr fastBox;
+    tgui::Label::Ptr predictionLabel;
+    BodyHandle velBody;
+    BallisticBatch prediction;
+    std::vector<sf::Vector2f> predictedPath;
+    sf::VertexArray predictedArc{ sf::LineStrip };
 
     // Friction popup
     tgui::ChildWindow::Ptr frictionPopup = nullptr;
     tgui::EditBox::Ptr frictionBox;
-    float groundFriction = 0.f;
 
     // Path tracing
-    bool pathTracingEnabled = false;
-    int tracedObjectIndex = -1;
-    sf::VertexArray trajectoryCurve{ sf::LinesStrip };
+    TrajectoryRecorder trajectories;
+
+    // Collision effects
+    ParticleSystem particles;
+
+    // Recording / replay; stepCount numbers the fixed steps taken
+    RecordingWriter recorder;
+    RecordingReader replay;
+    uint64_t stepCount = 0;
+
+    // Rewind history; rewindTime is the simulated time it is keyed on
+    RewindBuffer rewind;
+    float rewindTime = 0.f;
 
     // Range line
     bool rangeLineEnabled = false;
-    int rangeObjectIndex = -1;
+    BodyHandle rangeBody;
     sf::VertexArray rangeLine{ sf::Lines };
     bool rangeActive = false;
     sf::Vector2f rangeStartPos{};
     float currentRangeX = 0.f;
     float maxRangeX = 0.f;
     float rangeLineY = 0.f;
-    std::vector<sf::VertexArray> completedRangeLines;
+    struct RangeSegment { sf::Vector2f start, end; };
+    std::vector<RangeSegment> completedRangeLines;   // ring, see completedRangeHead
+    size_t completedRangeHead = 0;
 
-    // Trigger lines
+    // Trigger lines: triggerLines[i] draws line i of 'triggers'
     std::vector<TriggerLine> triggerLines;
+    TriggerSet triggers;
+    std::vector<TriggerEvent> triggerEvents;
     TriggerLine* selectedLine = nullptr;
+    bool gatePlacement = false;
+    bool drawingGate = false;
+    sf::Vector2f gateStart{};
+    sf::Vector2f gateEnd{};
+
+    // Joint placement; jointBody is the first pick, if any
+    bool jointPlacement = false;
+    JointType jointType = JointType::Distance;
+    BodyHandle jointBody;
+    sf::VertexArray jointLines{ sf::Lines };
 };
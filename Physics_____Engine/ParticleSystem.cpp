@@ -0,0 +1,96 @@
+#include "ParticleSystem.hpp"
+#include "SimdKernels.hpp"
+#include <algorithm>
+#include <cmath>
+
+ParticleSystem::ParticleSystem(size_t capacity) {
+    setCapacity(capacity);
+}
+
+void ParticleSystem::setCapacity(size_t n) {
+    capacity = n;
+    alive = 0;
+    for (auto* a : { &posX, &posY, &velX, &velY, &life }) a->assign(capacity, 0.f);
+
+    vertices.clear();
+    vertices.reserve(capacity * 6);
+    useBuffer = sf::VertexBuffer::isAvailable() && buffer.create(vertices.capacity());
+}
+
+// xorshift32: cheap, allocation-free and repeatable between runs
+float ParticleSystem::random01() {
+    rng ^= rng << 13;
+    rng ^= rng >> 17;
+    rng ^= rng << 5;
+    return static_cast<float>(rng >> 8) * (1.f / 16777216.f);
+}
+
+// --- Spawning ---
+size_t ParticleSystem::spawnBurst(const sf::Vector2f& point, const sf::Vector2f& direction, float speed, size_t count) {
+    count = std::min(count, capacity - alive);
+
+    const float baseAngle = std::atan2(direction.y, direction.x);
+    const float spread = 1.2f;   // radians either side of the direction
+    for (size_t k = 0; k < count; ++k) {
+        const size_t i = alive++;
+        const float angle = baseAngle + (random01() * 2.f - 1.f) * spread;
+        const float v = speed * (0.4f + 0.6f * random01());
+        posX[i] = point.x;
+        posY[i] = point.y;
+        velX[i] = std::cos(angle) * v;
+        velY[i] = std::sin(angle) * v;
+        life[i] = lifetime * (0.5f + 0.5f * random01());
+    }
+    return count;
+}
+
+// --- Update ---
+void ParticleSystem::update(float dt, float gravity) {
+    if (alive == 0 || dt <= 0.f) return;
+
+    const ParticleStreams streams{ posX.data(), posY.data(), velX.data(), velY.data(), life.data() };
+    integrateParticles(streams, alive, { dt, gravity, 2.f });
+
+    // Swap-remove the expired so the live ones stay packed
+    for (size_t i = 0; i < alive;) {
+        if (life[i] > 0.f) {
+            ++i;
+            continue;
+        }
+        --alive;
+        posX[i] = posX[alive];
+        posY[i] = posY[alive];
+        velX[i] = velX[alive];
+        velY[i] = velY[alive];
+        life[i] = life[alive];
+    }
+}
+
+// --- Drawing ---
+void ParticleSystem::draw(sf::RenderTarget& target) {
+    if (alive == 0) return;
+
+    vertices.clear();
+    for (size_t i = 0; i < alive; ++i) {
+        // Shrink and fade out over the lifetime
+        const float t = std::clamp(life[i] / lifetime, 0.f, 1.f);
+        const float h = 0.5f * particleSize * (0.3f + 0.7f * t);
+        const sf::Color color(255, static_cast<sf::Uint8>(140 + 100 * t), 60, static_cast<sf::Uint8>(255 * t));
+
+        const sf::Vector2f a(posX[i] - h, posY[i] - h);
+        const sf::Vector2f b(posX[i] + h, posY[i] - h);
+        const sf::Vector2f c(posX[i] + h, posY[i] + h);
+        const sf::Vector2f d(posX[i] - h, posY[i] + h);
+        vertices.emplace_back(a, color);
+        vertices.emplace_back(b, color);
+        vertices.emplace_back(c, color);
+        vertices.emplace_back(a, color);
+        vertices.emplace_back(c, color);
+        vertices.emplace_back(d, color);
+    }
+
+    if (useBuffer && buffer.update(vertices.data(), vertices.size(), 0))
+        target.draw(buffer, 0, vertices.size());
+    else
+        target.draw(vertices.data(), vertices.size(), sf::Triangles);
+}
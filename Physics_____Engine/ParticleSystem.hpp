@@ -0,0 +1,51 @@
+#pragma once
+#include <SFML/Graphics.hpp>
+#include "BodyStore.hpp"
+#include <vector>
+
+// ---------------------
+// Fixed-capacity pool of short-lived effect particles.
+//
+// Particles are stored as structure-of-arrays with the live ones packed
+// at the front, so the update is one SIMD pass (integrateParticles) over
+// [0, alive) followed by a swap-remove of the expired. Spawning past the
+// capacity is simply refused. Every live particle is drawn as a quad in
+// one triangle list. All storage is allocated up front; nothing allocates
+// per frame.
+// ---------------------
+class ParticleSystem {
+public:
+    explicit ParticleSystem(size_t capacity = 8192);
+
+    // Reallocates for 'capacity' particles and drops the live ones
+    void setCapacity(size_t capacity);
+    size_t getCapacity() const { return capacity; }
+    size_t getAliveCount() const { return alive; }
+    void clear() { alive = 0; }
+
+    // Sprays up to 'count' particles from 'point' in a cone around
+    // 'direction', faster for stronger impacts. Returns how many fit.
+    size_t spawnBurst(const sf::Vector2f& point, const sf::Vector2f& direction, float speed, size_t count);
+
+    void update(float dt, float gravity);
+    void draw(sf::RenderTarget& target);
+
+    // Seconds a particle lives and the side of its quad at birth
+    static constexpr float lifetime = 0.6f;
+    static constexpr float particleSize = 3.f;
+
+private:
+    float random01();
+
+private:
+    AlignedVector<float> posX, posY;
+    AlignedVector<float> velX, velY;
+    AlignedVector<float> life;
+    size_t capacity = 0;
+    size_t alive = 0;
+    uint32_t rng = 0x9e3779b9u;
+
+    std::vector<sf::Vertex> vertices;
+    sf::VertexBuffer buffer{ sf::Triangles, sf::VertexBuffer::Stream };
+    bool useBuffer = false;
+};
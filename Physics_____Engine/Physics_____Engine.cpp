@@ -2,12 +2,30 @@
 #include <TGUI/TGUI.hpp>
 #include <cmath>
 #include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
 #include "UIUX.hpp"
 #include "Objects.hpp"
+#include "Profiler.hpp"
 
 static float lerp(float a, float b, float t) { return a + (b - a) * t; }
 
-int main()
+// Options:
+//   --step-rate <hz>      fixed simulation rate (default 120)
+//   --max-substeps <n>    steps allowed per rendered frame (default 8)
+//   --shapes              start with one draw call per shape (F3 toggles)
+//   --trace-tracks <n>    bodies that can be path traced at once (default 32)
+//   --trace-points <n>    points kept per traced path (default 1024)
+//   --scene <path>        load a scene (text or .pscene) at startup;
+//                         Ctrl+S saves to it (scene.pscene if none),
+//                         Ctrl+O loads it again
+//   --recording <path>    file the Record and Replay buttons use
+//                         (default recording.prec)
+//   --profile             start with the profiler overlay on (F4 toggles,
+//                         F5 writes the last few seconds to profile.json
+//                         as a Chrome trace)
+int main(int argc, char** argv)
 {
     sf::RenderWindow window(sf::VideoMode(1100, 700), "Physics Engine ", sf::Style::Close);
     window.setFramerateLimit(60);
@@ -24,7 +42,8 @@ int main()
     tgui::Button::Ptr box0Btn;
     tgui::Button::Ptr box1Btn;
     tgui::Button::Ptr box2Btn;
-    tgui::Button::Ptr stopTimeBtn;
+    tgui::Button::Ptr gateBtn;
+    tgui::Button::Ptr jointBtn;
     tgui::Label::Ptr timerLabel;
     tgui::Label::Ptr stoppedTimesLabel;
 
@@ -37,36 +56,82 @@ int main()
     timerLabel->setPosition({ 22.f, 222.f });
     gui.add(timerLabel);
 
-    // Stopped times label
+    // Gate crossing times label
     stoppedTimesLabel = tgui::Label::create("");
     stoppedTimesLabel->setTextSize(16);
     stoppedTimesLabel->getRenderer()->setTextColor(sf::Color::Yellow);
     stoppedTimesLabel->setPosition({ 22.f, 250.f });
     gui.add(stoppedTimesLabel);
 
+    // Render time label (CPU time from clear to display, averaged)
+    tgui::Label::Ptr frameTimeLabel = tgui::Label::create("");
+    frameTimeLabel->setTextSize(14);
+    frameTimeLabel->getRenderer()->setTextColor(sf::Color(180, 190, 210));
+    frameTimeLabel->setPosition({ 22.f, 660.f });
+    gui.add(frameTimeLabel);
+
+    // Profiler overlay: rolling per-zone times, top left of the canvas
+    tgui::Label::Ptr profilerLabel = tgui::Label::create("");
+    profilerLabel->setTextSize(13);
+    profilerLabel->getRenderer()->setTextColor(sf::Color(230, 235, 245));
+    profilerLabel->getRenderer()->setBackgroundColor(tgui::Color(10, 14, 22, 190));
+    profilerLabel->setPosition({ 252.f, 92.f });
+    profilerLabel->setVisible(false);
+    gui.add(profilerLabel);
+    Profiler::setThreadName("main");
+
     bool isRunning = false;
     float simulationTime = 0.f;
 
     Objects objects(gui, window);
 
-    // Store initial positions of objects
-    std::vector<sf::Vector2f> initialPositions;
+    size_t traceTracks = objects.getTrajectories().getMaxTracks();
+    size_t tracePoints = objects.getTrajectories().getPointsPerTrack();
+    std::string scenePath;
+    std::string recordingPath = "recording.prec";
+    for (int i = 1; i < argc; ++i) {
+        if (std::strcmp(argv[i], "--step-rate") == 0 && i + 1 < argc)
+            objects.getStepper().setStepRate(static_cast<float>(std::atof(argv[++i])));
+        else if (std::strcmp(argv[i], "--max-substeps") == 0 && i + 1 < argc)
+            objects.getStepper().setMaxSubSteps(std::atoi(argv[++i]));
+        else if (std::strcmp(argv[i], "--shapes") == 0)
+            objects.setBatchedRendering(false);
+        else if (std::strcmp(argv[i], "--trace-tracks") == 0 && i + 1 < argc)
+            traceTracks = static_cast<size_t>(std::max(1, std::atoi(argv[++i])));
+        else if (std::strcmp(argv[i], "--trace-points") == 0 && i + 1 < argc)
+            tracePoints = static_cast<size_t>(std::max(2, std::atoi(argv[++i])));
+        else if (std::strcmp(argv[i], "--scene") == 0 && i + 1 < argc)
+            scenePath = argv[++i];
+        else if (std::strcmp(argv[i], "--recording") == 0 && i + 1 < argc)
+            recordingPath = argv[++i];
+        else if (std::strcmp(argv[i], "--profile") == 0) {
+            Profiler::setEnabled(true);
+            profilerLabel->setVisible(true);
+        }
+    }
+    objects.getTrajectories().configure(traceTracks, tracePoints, objects.getTrajectories().getTolerance());
+
+    if (!scenePath.empty()) {
+        std::string error;
+        if (!objects.loadScene(scenePath, error))
+            std::fprintf(stderr, "scene: %s\n", error.c_str());
+    }
+
+    // Whole simulation state when Run was last pressed, for Reset
+    WorldSnapshot runStart;
 
     if (runPauseBtn)
         runPauseBtn->onPress([&]() {
-        if (!isRunning) {
-            initialPositions.clear();
-            for (const auto& obj : objects.getObjects()) {
-                initialPositions.push_back(obj.shape->getPosition());
-            }
-        }
+        // Running again leaves the replay at the frame shown
+        if (objects.isReplaying()) objects.closeReplay();
+        if (!isRunning) objects.saveSnapshot(runStart);
         isRunning = !isRunning;
         runPauseBtn->setText(isRunning ? "Pause" : "Run");
             });
 
-    // Max 5 stopped times
-    const int maxStops = 5;
-    std::vector<float> stoppedTimes;
+    // The last 5 gate crossings: (gate, simulated time)
+    const size_t maxStops = 5;
+    std::vector<std::pair<uint32_t, float>> stoppedTimes;
 
     if (resetBtn)
         resetBtn->onPress([&]() {
@@ -74,13 +139,8 @@ int main()
         timerLabel->setText("Time: 0.00s");
         stoppedTimes.clear();
         stoppedTimesLabel->setText("");
-        if (!initialPositions.empty()) {
-            auto& objs = const_cast<std::vector<PhysicsObject>&>(objects.getObjects());
-            for (size_t i = 0; i < objs.size() && i < initialPositions.size(); ++i) {
-                objs[i].shape->setPosition(initialPositions[i]);
-                objs[i].velocity = { 0.f, 0.f };
-            }
-        }
+        objects.getTrajectories().resetPaths();
+        if (!runStart.empty()) objects.restoreSnapshot(runStart);
             });
 
     if (box0Btn)
@@ -92,26 +152,118 @@ int main()
     if (box2Btn)
         box2Btn->onPress([&]() { objects.toggleRangeLine(); });
 
-    // Stop Clock button
-    stopTimeBtn = tgui::Button::create("Stop Clock");
-    stopTimeBtn->setSize({ 140.f, 44.f });
-    stopTimeBtn->setPosition({ 800.f, 18.f });
-    stopTimeBtn->getRenderer()->setBackgroundColor(tgui::Color(100, 102, 184));
-    stopTimeBtn->getRenderer()->setTextColor(sf::Color::White);
-    stopTimeBtn->getRenderer()->setRoundedBorderRadius(10);
-    gui.add(stopTimeBtn);
-
-    if (stopTimeBtn)
-        stopTimeBtn->onPress([&]() {
-        if (stoppedTimes.size() < maxStops) {
-            stoppedTimes.push_back(simulationTime);
-            std::string text = "Stopped Times:\n";
-            for (float t : stoppedTimes)
-                text += std::to_string(t).substr(0, 5) + "s\n";
-            stoppedTimesLabel->setText(text);
+    // Gates button: while on, a left drag on the canvas draws a timing
+    // gate. Bodies crossing a gate stop the clock for it (see the update).
+    gateBtn = tgui::Button::create("Gates: Off");
+    gateBtn->setSize({ 140.f, 44.f });
+    gateBtn->setPosition({ 800.f, 18.f });
+    gateBtn->getRenderer()->setBackgroundColor(tgui::Color(100, 102, 184));
+    gateBtn->getRenderer()->setTextColor(sf::Color::White);
+    gateBtn->getRenderer()->setRoundedBorderRadius(10);
+    gui.add(gateBtn);
+
+    // Joints button: cycles Off / Distance / Spring / Rope / Pin. While on,
+    // a left click picks a body and a second click joins it to another
+    // body, or to the world where the click lands.
+    jointBtn = tgui::Button::create("Joints: Off");
+    jointBtn->setSize({ 140.f, 44.f });
+    jointBtn->setPosition({ 950.f, 18.f });
+    jointBtn->getRenderer()->setBackgroundColor(tgui::Color(100, 102, 184));
+    jointBtn->getRenderer()->setTextColor(sf::Color::White);
+    jointBtn->getRenderer()->setRoundedBorderRadius(10);
+    gui.add(jointBtn);
+
+    if (gateBtn)
+        gateBtn->onPress([&]() {
+        objects.setGatePlacement(!objects.isPlacingGates());
+        gateBtn->setText(objects.isPlacingGates() ? "Gates: On" : "Gates: Off");
+        jointBtn->setText("Joints: Off");
+            });
+
+    if (jointBtn)
+        jointBtn->onPress([&]() {
+        static const JointType order[] = { JointType::Distance, JointType::Spring, JointType::Rope, JointType::Pin };
+        static const char* const names[] = { "Joints: Distance", "Joints: Spring", "Joints: Rope", "Joints: Pin" };
+        // Off is 4, after the last type
+        size_t next = 0;
+        if (objects.isPlacingJoints())
+            next = static_cast<size_t>(objects.getJointPlacementType()) + 1;
+        objects.setJointPlacement(next < 4, next < 4 ? order[next] : JointType::Distance);
+        jointBtn->setText(next < 4 ? names[next] : "Joints: Off");
+        gateBtn->setText("Gates: Off");
+            });
+
+    // Record / Replay buttons and the replay scrub bar
+    auto recordBtn = tgui::Button::create("Record");
+    recordBtn->setSize({ 100.f, 44.f });
+    recordBtn->setPosition({ 20.f, 600.f });
+    recordBtn->getRenderer()->setBackgroundColor(tgui::Color(100, 102, 184));
+    recordBtn->getRenderer()->setTextColor(sf::Color::White);
+    recordBtn->getRenderer()->setRoundedBorderRadius(10);
+    gui.add(recordBtn);
+
+    auto replayBtn = tgui::Button::create("Replay");
+    replayBtn->setSize({ 95.f, 44.f });
+    replayBtn->setPosition({ 120.f, 600.f });
+    replayBtn->getRenderer()->setBackgroundColor(tgui::Color(100, 102, 184));
+    replayBtn->getRenderer()->setTextColor(sf::Color::White);
+    replayBtn->getRenderer()->setRoundedBorderRadius(10);
+    gui.add(replayBtn);
+
+    auto replaySlider = tgui::Slider::create();
+    replaySlider->setSize({ 420.f, 14.f });
+    replaySlider->setPosition({ 420.f, 662.f });
+    replaySlider->setVisible(false);
+    gui.add(replaySlider);
+
+    auto replayLabel = tgui::Label::create("");
+    replayLabel->setTextSize(14);
+    replayLabel->getRenderer()->setTextColor(sf::Color::White);
+    replayLabel->setPosition({ 860.f, 656.f });
+    replayLabel->setVisible(false);
+    gui.add(replayLabel);
+
+    bool recordShown = false;
+    auto showReplayTime = [&]() {
+        replayLabel->setText(std::to_string(objects.getReplayTime()).substr(0, 5) + " / " +
+            std::to_string(objects.getReplayDuration()).substr(0, 5) + " s");
+        };
+
+    recordBtn->onPress([&]() {
+        if (objects.isRecording()) {
+            objects.stopRecording();
+            return;
+        }
+        std::string error;
+        if (!objects.startRecording(recordingPath, error))
+            std::fprintf(stderr, "recording: %s\n", error.c_str());
+            });
+
+    replayBtn->onPress([&]() {
+        if (objects.isReplaying()) {
+            objects.closeReplay();
+            return;
+        }
+        std::string error;
+        if (!objects.openReplay(recordingPath, error)) {
+            std::fprintf(stderr, "replay: %s\n", error.c_str());
+            return;
         }
+        isRunning = false;
+        runPauseBtn->setText("Run");
+        runStart.clear();
+        replaySlider->setMinimum(0.f);
+        replaySlider->setMaximum(objects.getReplayDuration());
+        replaySlider->setStep(objects.getStepper().getStepDt());
+        replaySlider->setValue(0.f);
+        showReplayTime();
             });
 
+    replaySlider->onValueChange([&](float seconds) {
+        objects.scrubReplay(seconds);
+        showReplayTime();
+        });
+
     const float canvasX = 240.f, canvasY = 80.f;
     const float canvasW = 820.f, canvasH = 560.f;
     const sf::FloatRect canvasFramePx(canvasX + 6.f, canvasY + 6.f, canvasW - 12.f, canvasH - 12.f);
@@ -168,20 +320,84 @@ int main()
         };
 
     sf::Clock clock;
+    sf::Clock renderClock;
+    float renderTimeSum = 0.f;
+    int renderFrames = 0;
+    float profilerRefresh = 0.f;
 
     while (window.isOpen())
     {
+        // Fold the last frame into the overlay before this one starts
         const float dt = clock.restart().asSeconds();
+        if (Profiler::isEnabled()) {
+            Profiler::endFrame();
+            profilerRefresh += dt;
+            if (profilerRefresh >= 0.25f) {
+                profilerRefresh = 0.f;
+                profilerLabel->setText(Profiler::formatStats() + "F4 hide, F5 save trace");
+            }
+        }
+        PROFILE_ZONE("Frame");
 
-        if (isRunning) simulationTime += dt;
         timerLabel->setText("Time: " + std::to_string(simulationTime).substr(0, 5) + "s");
 
+        // Recording and replay can also end from elsewhere (Run, size limit)
+        if (replaySlider->isVisible() != objects.isReplaying()) {
+            replaySlider->setVisible(objects.isReplaying());
+            replayLabel->setVisible(objects.isReplaying());
+            replayBtn->setText(objects.isReplaying() ? "Live" : "Replay");
+        }
+        const bool recording = objects.isRecording() && !objects.getRecorder().isFull();
+        if (recording != recordShown) {
+            recordShown = recording;
+            recordBtn->setText(recording ? "Stop Rec" : "Record");
+        }
+
         sf::Event event;
         while (window.pollEvent(event))
         {
+            PROFILE_ZONE("Events");
             if (event.type == sf::Event::Closed)
                 window.close();
 
+            if (event.type == sf::Event::KeyPressed && event.key.code == sf::Keyboard::F3) {
+                objects.setBatchedRendering(!objects.isBatchedRendering());
+                renderTimeSum = 0.f;
+                renderFrames = 0;
+            }
+
+            // Profiler overlay and trace
+            if (event.type == sf::Event::KeyPressed && event.key.code == sf::Keyboard::F4) {
+                Profiler::setEnabled(!Profiler::isEnabled());
+                profilerLabel->setVisible(Profiler::isEnabled());
+                profilerLabel->setText("");
+            }
+            if (event.type == sf::Event::KeyPressed && event.key.code == sf::Keyboard::F5) {
+                std::string error;
+                if (!Profiler::writeChromeTrace("profile.json", error))
+                    std::fprintf(stderr, "profiler: %s\n", error.c_str());
+            }
+
+            // Scene save / reload
+            if (event.type == sf::Event::KeyPressed && event.key.control &&
+                (event.key.code == sf::Keyboard::S || event.key.code == sf::Keyboard::O)) {
+                if (scenePath.empty()) scenePath = "scene.pscene";
+                std::string error;
+                if (event.key.code == sf::Keyboard::S) {
+                    if (!objects.saveScene(scenePath, error))
+                        std::fprintf(stderr, "scene: %s\n", error.c_str());
+                }
+                else {
+                    if (!objects.loadScene(scenePath, error))
+                        std::fprintf(stderr, "scene: %s\n", error.c_str());
+                    runStart.clear();
+                }
+            }
+
+            // Rewind: Ctrl+Z steps back through the last few seconds
+            if (event.type == sf::Event::KeyPressed && event.key.control && event.key.code == sf::Keyboard::Z)
+                objects.stepBack(simulationTime);
+
             if (event.type == sf::Event::MouseWheelScrolled)
             {
                 if (inCanvasFrame(event.mouseWheelScroll.x, event.mouseWheelScroll.y))
@@ -243,13 +459,18 @@ int main()
             gui.handleEvent(event);
         }
 
-        float s = std::clamp(dt * 7.5f, 0.f, 1.f);
-        currentZoom = lerp(currentZoom, targetZoom, s);
-        sf::Vector2f curC = worldView.getCenter();
-        curC.x = lerp(curC.x, targetCenter.x, s);
-        curC.y = lerp(curC.y, targetCenter.y, s);
-        worldView.setCenter(curC);
-        worldView.setSize(baseViewSize * currentZoom);
+        {
+            PROFILE_ZONE("Camera");
+            float s = std::clamp(dt * 7.5f, 0.f, 1.f);
+            currentZoom = lerp(currentZoom, targetZoom, s);
+            sf::Vector2f curC = worldView.getCenter();
+            curC.x = lerp(curC.x, targetCenter.x, s);
+            curC.y = lerp(curC.y, targetCenter.y, s);
+            worldView.setCenter(curC);
+            worldView.setSize(baseViewSize * currentZoom);
+        }
+
+        objects.getRenderer().resetStats();
 
         window.clear();
         window.draw(background);
@@ -278,9 +499,19 @@ int main()
         ground.setOutlineColor(sf::Color::Black);
         window.draw(ground);
 
-        // Grid drawing
-        if (gridSlider && gridSlider->getValue() > 0.5f)
+        // Grid drawing. The render readout times only this and the bodies,
+        // the two things F3 switches between batched and per-shape drawing.
+        renderClock.restart();
+        const bool gridVisible = gridSlider && gridSlider->getValue() > 0.5f;
+        if (gridVisible && objects.isBatchedRendering())
         {
+            PROFILE_ZONE("Grid");
+            const sf::FloatRect viewRect(vC - vS * 0.5f, vS);
+            objects.getRenderer().drawGrid(window, viewRect, computeGridWorld(60.f), sf::Color(18, 30, 44));
+        }
+        else if (gridVisible)
+        {
+            PROFILE_ZONE("Grid");
             const float step = computeGridWorld(60.f);
             const float L = vC.x - vS.x * 0.5f;
             const float R = vC.x + vS.x * 0.5f;
@@ -306,12 +537,52 @@ int main()
                 window.draw(line, 2, sf::Lines);
             }
         }
+        renderTimeSum += renderClock.getElapsedTime().asSeconds();
 
-        objects.update(dt, isRunning, groundCarrierRect, groundHeight);
-        objects.draw(window);
+        {
+            PROFILE_ZONE("Physics");
+            const float frameStart = simulationTime;
+            simulationTime += objects.update(dt, isRunning, groundCarrierRect, groundHeight);
+
+            // Gate crossings, at the time within the step the body touched
+            // the gate rather than the frame's
+            const auto& crossings = objects.getTriggerEvents();
+            if (!crossings.empty()) {
+                for (const TriggerEvent& e : crossings) stoppedTimes.emplace_back(e.line, frameStart + e.time);
+                if (stoppedTimes.size() > maxStops)
+                    stoppedTimes.erase(stoppedTimes.begin(), stoppedTimes.end() - maxStops);
+                std::string text = "Gate Times:\n";
+                for (const auto& [gate, t] : stoppedTimes)
+                    text += "Gate " + std::to_string(gate + 1) + ": " + std::to_string(t).substr(0, 5) + "s\n";
+                stoppedTimesLabel->setText(text);
+            }
+        }
+        {
+            PROFILE_ZONE("Bodies");
+            renderClock.restart();
+            objects.draw(window);
+            renderTimeSum += renderClock.getElapsedTime().asSeconds();
+        }
 
         window.setView(window.getDefaultView());
-        gui.draw();
+        {
+            PROFILE_ZONE("GUI");
+            gui.draw();
+        }
+
+        if (++renderFrames == 30) {
+            const float ms = renderTimeSum * 1000.f / static_cast<float>(renderFrames);
+            std::string text = "Render: " + std::to_string(ms).substr(0, 5) + " ms ";
+            text += objects.isBatchedRendering()
+                ? "(batched, " + std::to_string(objects.getRenderer().getDrawCalls()) + " batch draws)"
+                : "(per shape)";
+            frameTimeLabel->setText(text + " - F3 to switch");
+            renderTimeSum = 0.f;
+            renderFrames = 0;
+        }
+
+        // Includes the frame limiter's wait
+        PROFILE_ZONE("Display");
         window.display();
     }
 
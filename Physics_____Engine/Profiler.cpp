@@ -0,0 +1,203 @@
+#include "Profiler.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <memory>
+#include <mutex>
+
+std::atomic<bool> Profiler::enabled{ false };
+
+namespace {
+    struct ThreadRing {
+        std::unique_ptr<ProfileEvent[]> events{ new ProfileEvent[Profiler::ringCapacity] };
+        std::atomic<uint64_t> written{ 0 };   // events ever written
+        uint64_t collected = 0;               // endFrame's read position
+        uint32_t depth = 0;
+        uint32_t id = 0;
+        std::string name;
+    };
+
+    struct ZoneHistory {
+        Profiler::ZoneStats stats;
+        float samples[Profiler::statsWindow] = {};
+        uint64_t frameNs = 0;
+    };
+
+    // Rings outlive their threads, so a reader never sees one go away
+    std::mutex registryMutex;
+    std::vector<std::unique_ptr<ThreadRing>> rings;
+    thread_local ThreadRing* localRing = nullptr;
+    thread_local const char* localName = nullptr;
+
+    // Main thread only
+    std::vector<ZoneHistory> zones;
+    std::vector<ProfileEvent> frameEvents;
+    std::vector<Profiler::ZoneStats> stats;
+    size_t frameIndex = 0;
+
+    const auto epoch = std::chrono::steady_clock::now();
+
+    ThreadRing& threadRing() {
+        if (localRing) return *localRing;
+        auto ring = std::make_unique<ThreadRing>();
+        std::lock_guard<std::mutex> lock(registryMutex);
+        ring->id = static_cast<uint32_t>(rings.size());
+        ring->name = localName ? localName : "thread " + std::to_string(ring->id);
+        localRing = ring.get();
+        rings.push_back(std::move(ring));
+        return *localRing;
+    }
+
+    ZoneHistory& zoneFor(const char* name, uint32_t depth) {
+        for (ZoneHistory& z : zones) {
+            if (z.stats.name == name) {
+                z.stats.depth = std::min(z.stats.depth, depth);
+                return z;
+            }
+        }
+        zones.emplace_back();
+        zones.back().stats.name = name;
+        zones.back().stats.depth = depth;
+        return zones.back();
+    }
+
+    // Appends the ring's events from 'from' on to 'out' and returns how
+    // many it had written. Its thread keeps recording while we copy, so
+    // 'written' is read again afterwards: any slot it may have reached by
+    // then (it could be rewriting the one after the last published event)
+    // is dropped rather than returned half written
+    uint64_t copyRing(const ThreadRing& ring, uint64_t from, std::vector<ProfileEvent>& out) {
+        constexpr uint64_t capacity = Profiler::ringCapacity;
+        const uint64_t written = ring.written.load(std::memory_order_acquire);
+        from = std::max(from, written > capacity ? written - capacity : 0);
+        const size_t base = out.size();
+        for (uint64_t k = from; k < written; ++k) out.push_back(ring.events[k % capacity]);
+
+        std::atomic_thread_fence(std::memory_order_acquire);
+        const uint64_t after = ring.written.load(std::memory_order_relaxed);
+        const uint64_t intact = after + 1 > capacity ? after + 1 - capacity : 0;
+        if (intact > from) {
+            const size_t lost = static_cast<size_t>(std::min(intact, written) - from);
+            out.erase(out.begin() + base, out.begin() + base + lost);
+        }
+        return written;
+    }
+}
+
+uint64_t Profiler::now() {
+    return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now() - epoch).count());
+}
+
+uint32_t Profiler::enterZone() {
+    return threadRing().depth++;
+}
+
+void Profiler::leaveZone(const char* name, uint64_t start, uint32_t depth) {
+    ThreadRing& ring = threadRing();
+    ring.depth = depth;
+    const uint64_t n = ring.written.load(std::memory_order_relaxed);
+    ring.events[n % ringCapacity] = { name, start, now(), depth };
+    ring.written.store(n + 1, std::memory_order_release);
+}
+
+void Profiler::setThreadName(const char* name) {
+    localName = name;
+    if (!localRing) return;
+    std::lock_guard<std::mutex> lock(registryMutex);
+    localRing->name = name;
+}
+
+// --- Statistics ---
+void Profiler::endFrame() {
+    frameEvents.clear();
+    {
+        std::lock_guard<std::mutex> lock(registryMutex);
+        for (auto& ring : rings) {
+            // Whatever was overwritten before we got to it is lost
+            ring->collected = copyRing(*ring, ring->collected, frameEvents);
+        }
+    }
+
+    // Zones finish inside out; by start time, new zones are listed in the
+    // order they run, parents first
+    std::sort(frameEvents.begin(), frameEvents.end(),
+              [](const ProfileEvent& a, const ProfileEvent& b) { return a.start < b.start; });
+    for (ZoneHistory& z : zones) z.frameNs = 0;
+    for (const ProfileEvent& e : frameEvents) zoneFor(e.name, e.depth).frameNs += e.end - e.start;
+
+    const size_t slot = frameIndex++ % statsWindow;
+    const size_t filled = std::min(frameIndex, statsWindow);
+    float sorted[statsWindow];
+    stats.resize(zones.size());
+    for (size_t i = 0; i < zones.size(); ++i) {
+        ZoneHistory& z = zones[i];
+        z.samples[slot] = static_cast<float>(z.frameNs) * 1e-6f;
+        z.stats.lastMs = z.samples[slot];
+
+        float sum = 0.f;
+        for (size_t s = 0; s < filled; ++s) sum += z.samples[s];
+        z.stats.avgMs = sum / static_cast<float>(filled);
+
+        std::copy(z.samples, z.samples + filled, sorted);
+        const size_t rank = std::min(filled - 1, filled * 99 / 100);
+        std::nth_element(sorted, sorted + rank, sorted + filled);
+        z.stats.p99Ms = sorted[rank];
+        stats[i] = z.stats;
+    }
+}
+
+const std::vector<Profiler::ZoneStats>& Profiler::getStats() {
+    return stats;
+}
+
+std::string Profiler::formatStats() {
+    std::string text = "zone                  avg ms   p99 ms\n";
+    char line[96];
+    for (const ZoneStats& z : stats) {
+        const int indent = static_cast<int>(std::min<uint32_t>(z.depth, 4)) * 2;
+        std::snprintf(line, sizeof(line), "%*s%-*.*s %7.2f  %7.2f\n", indent, "", 20 - indent, 20 - indent, z.name,
+                      z.avgMs, z.p99Ms);
+        text += line;
+    }
+    return text;
+}
+
+// --- Chrome trace ---
+bool Profiler::writeChromeTrace(const std::string& path, std::string& error) {
+    std::ofstream file(path);
+    if (!file) {
+        error = "cannot write " + path;
+        return false;
+    }
+
+    std::lock_guard<std::mutex> lock(registryMutex);
+    file << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[";
+    bool first = true;
+    char buffer[256];
+    std::vector<ProfileEvent> events;
+    for (const auto& ring : rings) {
+        std::snprintf(buffer, sizeof(buffer),
+                      "%s\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%u,\"args\":{\"name\":\"%s\"}}",
+                      first ? "" : ",", ring->id, ring->name.c_str());
+        file << buffer;
+        first = false;
+
+        events.clear();
+        copyRing(*ring, 0, events);
+        for (const ProfileEvent& e : events) {
+            std::snprintf(buffer, sizeof(buffer),
+                          ",\n{\"name\":\"%s\",\"ph\":\"X\",\"pid\":1,\"tid\":%u,\"ts\":%.3f,\"dur\":%.3f}",
+                          e.name, ring->id, static_cast<double>(e.start) * 1e-3,
+                          static_cast<double>(e.end - e.start) * 1e-3);
+            file << buffer;
+        }
+    }
+    file << "\n]}\n";
+    if (!file) {
+        error = "write failed: " + path;
+        return false;
+    }
+    return true;
+}
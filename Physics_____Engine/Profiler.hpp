@@ -0,0 +1,97 @@
+#pragma once
+#include <atomic>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// ---------------------
+// Frame profiler.
+//
+// PROFILE_ZONE("name") times the rest of the enclosing scope. Every
+// thread writes its finished zones into its own ring of the last
+// ringCapacity events and publishes them with one release store, so
+// recording never locks. The main thread reads the rings (endFrame,
+// writeChromeTrace) while the others keep recording; a thread that laps
+// its ring between two reads loses its oldest events, and the reader
+// drops any slot the thread may have been rewriting while it copied.
+// Names must be string literals: they are kept by pointer.
+//
+// Disabled (the default), a zone costs one relaxed load and a branch.
+// Building with PHYSICS_NO_PROFILER removes the zones altogether.
+// ---------------------
+struct ProfileEvent {
+    const char* name = nullptr;
+    uint64_t start = 0;          // ns since the profiler's epoch
+    uint64_t end = 0;
+    uint32_t depth = 0;          // nesting on its thread, 0 = outermost
+};
+
+class Profiler {
+public:
+    // Rolling statistics of one zone over the last statsWindow frames:
+    // the zone's total time per frame, summed over every thread
+    struct ZoneStats {
+        const char* name = nullptr;
+        uint32_t depth = 0;
+        float lastMs = 0.f;
+        float avgMs = 0.f;
+        float p99Ms = 0.f;
+    };
+
+    static constexpr size_t ringCapacity = size_t(1) << 15;
+    static constexpr size_t statsWindow = 240;
+
+    static void setEnabled(bool on) { enabled.store(on, std::memory_order_relaxed); }
+    static bool isEnabled() { return enabled.load(std::memory_order_relaxed); }
+
+    // Names the calling thread in traces; call once, early
+    static void setThreadName(const char* name);
+
+    // Main thread, once per frame: folds the zones recorded since the last
+    // call into the statistics
+    static void endFrame();
+    // In order of first appearance
+    static const std::vector<ZoneStats>& getStats();
+    // One line per zone, indented by depth, for an overlay
+    static std::string formatStats();
+
+    // Everything still in the rings as Chrome trace-event JSON (load it in
+    // chrome://tracing or Perfetto)
+    static bool writeChromeTrace(const std::string& path, std::string& error);
+
+    // Used by ProfileZone
+    static uint64_t now();
+    static uint32_t enterZone();
+    static void leaveZone(const char* name, uint64_t start, uint32_t depth);
+
+private:
+    static std::atomic<bool> enabled;
+};
+
+class ProfileZone {
+public:
+    explicit ProfileZone(const char* name) {
+        if (!Profiler::isEnabled()) return;
+        zoneName = name;
+        depth = Profiler::enterZone();
+        start = Profiler::now();
+    }
+    ~ProfileZone() {
+        if (zoneName) Profiler::leaveZone(zoneName, start, depth);
+    }
+    ProfileZone(const ProfileZone&) = delete;
+    ProfileZone& operator=(const ProfileZone&) = delete;
+
+private:
+    const char* zoneName = nullptr;
+    uint64_t start = 0;
+    uint32_t depth = 0;
+};
+
+#define PROFILE_CONCAT_INNER(a, b) a##b
+#define PROFILE_CONCAT(a, b) PROFILE_CONCAT_INNER(a, b)
+#ifdef PHYSICS_NO_PROFILER
+#define PROFILE_ZONE(name) ((void)0)
+#else
+#define PROFILE_ZONE(name) ProfileZone PROFILE_CONCAT(profileZone, __LINE__)(name)
+#endif
@@ -0,0 +1,452 @@
+#include "Recording.hpp"
+#include "Profiler.hpp"
+#include <cmath>
+#include <cstring>
+
+namespace {
+
+const char recordingMagic[8] = { 'P', 'H', 'Y', 'S', 'R', 'E', 'C', '\0' };
+const char indexMagic[8] = { 'P', 'H', 'Y', 'S', 'R', 'I', 'D', 'X' };
+
+size_t keyframePayloadSize(size_t n) { return ((n + 3) & ~size_t(3)) + 8 * n * sizeof(float); }
+
+// Quantized values stay well inside int32, so predictions fit in int64
+int32_t quantize(float v, double invQuantum) {
+    const double q = v * invQuantum;
+    if (!(std::abs(q) < 1e9)) return 0;
+    return static_cast<int32_t>(std::llround(q));
+}
+
+void putVarint(std::vector<uint8_t>& out, uint64_t v) {
+    while (v >= 0x80) {
+        out.push_back(static_cast<uint8_t>(v | 0x80));
+        v >>= 7;
+    }
+    out.push_back(static_cast<uint8_t>(v));
+}
+
+bool getVarint(const uint8_t*& p, const uint8_t* end, uint64_t& v) {
+    v = 0;
+    for (int shift = 0; shift < 64 && p < end; shift += 7) {
+        const uint8_t byte = *p++;
+        v |= static_cast<uint64_t>(byte & 0x7F) << shift;
+        if (!(byte & 0x80)) return true;
+    }
+    return false;
+}
+
+uint64_t zigzag(int64_t v) { return (static_cast<uint64_t>(v) << 1) ^ static_cast<uint64_t>(v >> 63); }
+int64_t unzigzag(uint64_t v) { return static_cast<int64_t>(v >> 1) ^ -static_cast<int64_t>(v & 1); }
+
+template <typename T>
+void putArray(std::vector<uint8_t>& out, const std::vector<T>& a) {
+    const size_t at = out.size();
+    out.resize(at + a.size() * sizeof(T));
+    if (!a.empty()) std::memcpy(out.data() + at, a.data(), a.size() * sizeof(T));
+}
+
+}
+
+// --- RecordingWriter ---
+bool RecordingWriter::start(const std::string& path, float stepDt, std::string& error) {
+    stop();
+    file.open(path, std::ios::binary | std::ios::trunc);
+    if (!file) {
+        error = "cannot write " + path;
+        return false;
+    }
+
+    RecordingHeader h{};
+    std::memcpy(h.magic, recordingMagic, sizeof(recordingMagic));
+    h.version = recordingVersion;
+    h.headerSize = sizeof(RecordingHeader);
+    h.stepDt = stepDt;
+    h.quantum = quantum;
+    h.keyframeInterval = keyframeInterval;
+    file.write(reinterpret_cast<const char*>(&h), sizeof(h));
+
+    queue.clear();
+    freeFrames.clear();
+    for (size_t i = 0; i < queueDepth; ++i) freeFrames.push_back(std::make_unique<Frame>());
+    stopping = false;
+    lastCount = 0;
+    lastLayout = 0;
+    sinceKeyframe = 0;
+    framesDropped = 0;
+    index.clear();
+    lastStep = 0;
+    framesWritten = 0;
+    bytesWritten = sizeof(h);
+    full = false;
+
+    recording = true;
+    writer = std::thread([this]() { writerLoop(); });
+    return true;
+}
+
+void RecordingWriter::stop() {
+    if (!recording) return;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    wake.notify_all();
+    writer.join();
+    recording = false;
+
+    RecordingTrailer trailer{};
+    trailer.indexOffset = bytesWritten;
+    trailer.entryCount = index.size();
+    trailer.lastStep = lastStep;
+    std::memcpy(trailer.magic, indexMagic, sizeof(indexMagic));
+    file.write(reinterpret_cast<const char*>(index.data()), static_cast<std::streamsize>(index.size() * sizeof(RecordingIndexEntry)));
+    file.write(reinterpret_cast<const char*>(&trailer), sizeof(trailer));
+    bytesWritten += index.size() * sizeof(RecordingIndexEntry) + sizeof(trailer);
+    file.close();
+}
+
+void RecordingWriter::capture(const World& world, uint64_t step) {
+    if (!recording || full.load(std::memory_order_relaxed)) return;
+    PROFILE_ZONE("Record capture");
+
+    std::unique_ptr<Frame> frame;
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        if (!dropWhenBehind) frameFreed.wait(lock, [this]() { return !freeFrames.empty(); });
+        if (!freeFrames.empty()) {
+            frame = std::move(freeFrames.back());
+            freeFrames.pop_back();
+        }
+    }
+    if (!frame) {
+        ++framesDropped;
+        return;
+    }
+
+    const BodyStore& b = world.getStore();
+    const size_t n = b.count();
+    frame->step = step;
+    frame->count = n;
+    // A body swapped for another keeps the count but not the layout the
+    // deltas would be decoded against
+    const uint64_t layout = world.getLayoutRevision();
+    frame->keyframe = sinceKeyframe == 0 || sinceKeyframe >= keyframeInterval || n != lastCount || layout != lastLayout;
+    frame->posX.assign(b.posX.begin(), b.posX.end());
+    frame->posY.assign(b.posY.begin(), b.posY.end());
+    frame->velX.assign(b.velX.begin(), b.velX.end());
+    frame->velY.assign(b.velY.begin(), b.velY.end());
+    if (frame->keyframe) {
+        frame->type.resize(n);
+        frame->sizeX.resize(n);
+        frame->sizeY.resize(n);
+        frame->mass.resize(n);
+        for (size_t i = 0; i < n; ++i) {
+            frame->type[i] = static_cast<uint8_t>(b.type[i]);
+            frame->sizeX[i] = b.size[i].x;
+            frame->sizeY[i] = b.size[i].y;
+            frame->mass[i] = b.invMass[i] > 0.f ? 1.f / b.invMass[i] : 0.f;
+        }
+        frame->elasticity.assign(b.restitution.begin(), b.restitution.end());
+    }
+    lastCount = n;
+    lastLayout = layout;
+    sinceKeyframe = frame->keyframe ? 1 : sinceKeyframe + 1;
+
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        queue.push_back(std::move(frame));
+    }
+    wake.notify_one();
+}
+
+void RecordingWriter::writerLoop() {
+    Profiler::setThreadName("recording writer");
+    for (;;) {
+        std::unique_ptr<Frame> frame;
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            wake.wait(lock, [this]() { return stopping || !queue.empty(); });
+            if (queue.empty()) return;
+            frame = std::move(queue.front());
+            queue.pop_front();
+        }
+
+        if (!full.load(std::memory_order_relaxed)) encode(*frame);
+
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            freeFrames.push_back(std::move(frame));
+        }
+        frameFreed.notify_one();
+    }
+}
+
+void RecordingWriter::encode(const Frame& frame) {
+    PROFILE_ZONE("Encode frame");
+    out.clear();
+    out.resize(sizeof(FrameHeader));
+    if (frame.keyframe) encodeKeyframe(frame);
+    else encodeDelta(frame);
+
+    FrameHeader h{};
+    h.kind = frame.keyframe ? FrameKeyframe : FrameDelta;
+    h.bodyCount = static_cast<uint32_t>(frame.count);
+    h.step = frame.step;
+    h.payloadSize = out.size() - sizeof(FrameHeader);
+    std::memcpy(out.data(), &h, sizeof(h));
+
+    const uint64_t offset = bytesWritten;
+    if (!append(out.data(), out.size())) return;
+    if (frame.keyframe) index.push_back({ frame.step, offset });
+    lastStep = frame.step;
+    framesWritten.fetch_add(1, std::memory_order_relaxed);
+}
+
+void RecordingWriter::encodeKeyframe(const Frame& frame) {
+    const size_t n = frame.count;
+    putArray(out, frame.type);
+    out.resize(out.size() + (((n + 3) & ~size_t(3)) - n), 0);
+    for (const auto* a : { &frame.sizeX, &frame.sizeY, &frame.mass, &frame.elasticity,
+                           &frame.posX, &frame.posY, &frame.velX, &frame.velY })
+        putArray(out, *a);
+
+    // The next delta predicts from here, with no motion assumed yet
+    const std::vector<float>* state[4] = { &frame.posX, &frame.posY, &frame.velX, &frame.velY };
+    const double inv = 1.0 / quantum;
+    for (int c = 0; c < 4; ++c) {
+        q1[c].resize(n);
+        for (size_t i = 0; i < n; ++i) q1[c][i] = quantize((*state[c])[i], inv);
+        q0[c] = q1[c];
+    }
+}
+
+void RecordingWriter::encodeDelta(const Frame& frame) {
+    const size_t n = frame.count;
+    const std::vector<float>* state[4] = { &frame.posX, &frame.posY, &frame.velX, &frame.velY };
+    const double inv = 1.0 / quantum;
+
+    uint64_t run = 0;
+    for (size_t i = 0; i < n; ++i) {
+        int64_t residual[4];
+        bool zero = true;
+        for (int c = 0; c < 4; ++c) {
+            const int32_t q = quantize((*state[c])[i], inv);
+            const int64_t predicted = 2 * static_cast<int64_t>(q1[c][i]) - q0[c][i];
+            residual[c] = q - predicted;
+            zero = zero && residual[c] == 0;
+            q0[c][i] = q1[c][i];
+            q1[c][i] = q;
+        }
+        if (zero) {
+            ++run;
+            continue;
+        }
+        putVarint(out, run);
+        run = 0;
+        for (int c = 0; c < 4; ++c) putVarint(out, zigzag(residual[c]));
+    }
+    if (run > 0) putVarint(out, run);
+}
+
+// Frames are written whole or not at all, leaving room for the index
+bool RecordingWriter::append(const void* data, size_t bytes) {
+    const uint64_t indexBytes = (index.size() + 1) * sizeof(RecordingIndexEntry) + sizeof(RecordingTrailer);
+    if (maxBytes > 0 && bytesWritten + bytes + indexBytes > maxBytes) {
+        full = true;
+        return false;
+    }
+    file.write(static_cast<const char*>(data), static_cast<std::streamsize>(bytes));
+    if (!file) {
+        full = true;
+        return false;
+    }
+    bytesWritten += bytes;
+    return true;
+}
+
+// --- RecordingReader ---
+bool RecordingReader::open(const std::string& path, std::string& error) {
+    close();
+    if (!file.open(path, error)) return false;
+
+    auto fail = [&](const char* what) {
+        error = path + ": " + what;
+        close();
+        return false;
+    };
+    if (file.size() < sizeof(RecordingHeader)) return fail("not a recording");
+
+    RecordingHeader h;
+    std::memcpy(&h, file.data(), sizeof(h));
+    if (std::memcmp(h.magic, recordingMagic, sizeof(recordingMagic)) != 0) return fail("not a recording");
+    if (h.version != recordingVersion) return fail("unsupported recording version");
+    if (h.headerSize < sizeof(RecordingHeader) || h.headerSize > file.size() || !(h.quantum > 0.f))
+        return fail("corrupt header");
+    stepDt = h.stepDt;
+    quantum = h.quantum;
+
+    // Use the index if the recording was closed cleanly
+    RecordingTrailer t{};
+    if (file.size() >= h.headerSize + sizeof(RecordingTrailer))
+        std::memcpy(&t, file.data() + file.size() - sizeof(t), sizeof(t));
+    const bool indexed = std::memcmp(t.magic, indexMagic, sizeof(indexMagic)) == 0 &&
+        t.indexOffset >= h.headerSize && t.entryCount <= file.size() &&
+        t.indexOffset + t.entryCount * sizeof(RecordingIndexEntry) + sizeof(t) == file.size();
+
+    if (indexed) {
+        keyframes.resize(static_cast<size_t>(t.entryCount));
+        std::memcpy(keyframes.data(), file.data() + t.indexOffset, keyframes.size() * sizeof(RecordingIndexEntry));
+        lastStep = t.lastStep;
+        framesEnd = t.indexOffset;
+    }
+    else {
+        framesEnd = file.size();
+        if (!scanFrames(h.headerSize)) return fail("corrupt frame table");
+    }
+    if (keyframes.empty()) return fail("no frames");
+    return true;
+}
+
+void RecordingReader::close() {
+    file.close();
+    keyframes.clear();
+    lastStep = 0;
+    framesEnd = 0;
+    valid = false;
+    count = 0;
+}
+
+bool RecordingReader::readFrameHeader(uint64_t offset, FrameHeader& h) const {
+    if (offset + sizeof(FrameHeader) > framesEnd) return false;
+    std::memcpy(&h, file.data() + offset, sizeof(h));
+    return h.payloadSize <= framesEnd - offset - sizeof(FrameHeader);
+}
+
+// Rebuilds the keyframe index of a recording that was never closed; a
+// frame cut off mid-write ends the recording
+bool RecordingReader::scanFrames(uint64_t offset) {
+    FrameHeader h;
+    while (readFrameHeader(offset, h)) {
+        if (h.kind == FrameKeyframe) keyframes.push_back({ h.step, offset });
+        else if (h.kind != FrameDelta) return false;
+        lastStep = h.step;
+        offset += sizeof(FrameHeader) + h.payloadSize;
+    }
+    framesEnd = offset;
+    return true;
+}
+
+bool RecordingReader::seek(uint64_t step) {
+    if (keyframes.empty()) return false;
+
+    auto it = std::upper_bound(keyframes.begin(), keyframes.end(), step,
+                               [](uint64_t s, const RecordingIndexEntry& e) { return s < e.step; });
+    if (it != keyframes.begin()) --it;
+
+    // Going forward past no keyframe: continue from the current frame
+    const bool forward = valid && currentStep <= step && it->step <= currentStep;
+    if (!forward && !decodeAt(it->offset)) return false;
+
+    FrameHeader h;
+    while (readFrameHeader(nextOffset, h) && h.step <= step) {
+        if (!decodeAt(nextOffset)) return false;
+    }
+    return true;
+}
+
+bool RecordingReader::decodeAt(uint64_t offset) {
+    FrameHeader h;
+    const bool ok = readFrameHeader(offset, h) &&
+        (h.kind == FrameKeyframe ? decodeKeyframe(h, file.data() + offset + sizeof(h))
+                                 : decodeDelta(h, file.data() + offset + sizeof(h)));
+    valid = ok;
+    if (!ok) return false;
+    currentStep = h.step;
+    nextOffset = offset + sizeof(h) + h.payloadSize;
+    return true;
+}
+
+bool RecordingReader::decodeKeyframe(const FrameHeader& h, const uint8_t* payload) {
+    const size_t n = h.bodyCount;
+    if (h.payloadSize != keyframePayloadSize(n)) return false;
+
+    count = n;
+    type.assign(payload, payload + n);
+    const uint8_t* p = payload + ((n + 3) & ~size_t(3));
+    for (auto* a : { &sizeX, &sizeY, &mass, &elasticity, &state[0], &state[1], &state[2], &state[3] }) {
+        a->resize(n);
+        if (n > 0) std::memcpy(a->data(), p, n * sizeof(float));
+        p += n * sizeof(float);
+    }
+
+    const double inv = 1.0 / quantum;
+    for (int c = 0; c < 4; ++c) {
+        q1[c].resize(n);
+        for (size_t i = 0; i < n; ++i) q1[c][i] = quantize(state[c][i], inv);
+        q0[c] = q1[c];
+    }
+    return true;
+}
+
+bool RecordingReader::decodeDelta(const FrameHeader& h, const uint8_t* payload) {
+    if (!valid || h.bodyCount != count) return false;
+
+    const uint8_t* p = payload;
+    const uint8_t* end = payload + h.payloadSize;
+    auto advance = [&](size_t i, const int64_t* residual) {
+        for (int c = 0; c < 4; ++c) {
+            const int64_t q = 2 * static_cast<int64_t>(q1[c][i]) - q0[c][i] + residual[c];
+            q0[c][i] = q1[c][i];
+            q1[c][i] = static_cast<int32_t>(q);
+            state[c][i] = static_cast<float>(static_cast<double>(q) * quantum);
+        }
+    };
+
+    const int64_t none[4] = { 0, 0, 0, 0 };
+    size_t i = 0;
+    while (i < count) {
+        uint64_t run;
+        if (!getVarint(p, end, run) || run > count - i) return false;
+        for (const size_t stop = i + static_cast<size_t>(run); i < stop; ++i) advance(i, none);
+        if (i == count) break;
+
+        int64_t residual[4];
+        for (int c = 0; c < 4; ++c) {
+            uint64_t v;
+            if (!getVarint(p, end, v)) return false;
+            residual[c] = unzigzag(v);
+        }
+        advance(i++, residual);
+    }
+    return p == end;
+}
+
+BodyColumns RecordingReader::getColumns() const {
+    BodyColumns c;
+    c.count = count;
+    c.type = type.data();
+    c.posX = state[0].data();
+    c.posY = state[1].data();
+    c.sizeX = sizeX.data();
+    c.sizeY = sizeY.data();
+    c.velX = state[2].data();
+    c.velY = state[3].data();
+    c.mass = mass.data();
+    c.elasticity = elasticity.data();
+    return c;
+}
+
+void RecordingReader::apply(World& world) const {
+    BodyStore& b = world.getStore();
+    if (b.count() != count) return;
+
+    for (size_t i = 0; i < count; ++i) {
+        b.posX[i] = b.prevX[i] = state[0][i];
+        b.posY[i] = b.prevY[i] = state[1][i];
+        b.velX[i] = state[2][i];
+        b.velY[i] = state[3][i];
+        b.refreshBounds(i);
+        world.wake(i);
+    }
+    world.markMoved();
+}
@@ -0,0 +1,220 @@
+#pragma once
+#include "World.hpp"
+#include "SceneBinary.hpp"
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+// ---------------------
+// Simulation recordings (.prec), little-endian.
+//
+//   header    RecordingHeader
+//   frames    FrameHeader + payload, one per captured step
+//   index     RecordingIndexEntry per keyframe, then RecordingTrailer
+//
+// Keyframes hold every body in full (type, size, mass, elasticity,
+// position, velocity as float32) and are written every keyframeInterval
+// frames and whenever the body count changes. The frames in between only
+// hold positions and velocities, quantized to 'quantum' and predicted
+// from the two frames before (p + (p - p_prev)): a body in free fall or
+// at rest has a residual of zero. Residuals are zigzag varints, and runs
+// of bodies whose four residuals are all zero are stored as one count,
+// so a settled pile costs a few bytes per frame.
+//
+// The index is written on stop(). A file cut short (crash, full disk)
+// is still readable: the reader then scans the frame headers instead.
+// ---------------------
+struct RecordingHeader {
+    char magic[8];                 // "PHYSREC\0"
+    uint32_t version;
+    uint32_t headerSize;
+    float stepDt;
+    float quantum;                 // px (and px/s) per delta unit
+    uint32_t keyframeInterval;
+    uint32_t reserved;
+};
+static_assert(sizeof(RecordingHeader) == 32, "recording header layout changed");
+
+struct FrameHeader {
+    uint32_t kind;                 // FrameKind
+    uint32_t bodyCount;
+    uint64_t step;
+    uint64_t payloadSize;
+};
+static_assert(sizeof(FrameHeader) == 24, "frame header layout changed");
+
+enum FrameKind : uint32_t { FrameKeyframe = 0, FrameDelta = 1 };
+
+struct RecordingIndexEntry {
+    uint64_t step;
+    uint64_t offset;               // of the keyframe's FrameHeader
+};
+
+struct RecordingTrailer {
+    uint64_t indexOffset;
+    uint64_t entryCount;
+    uint64_t lastStep;
+    char magic[8];                 // "PHYSRIDX"
+};
+static_assert(sizeof(RecordingTrailer) == 32, "recording trailer layout changed");
+
+constexpr uint32_t recordingVersion = 1;
+
+// ---------------------
+// Streams frames to disk from a background thread.
+//
+// capture() runs on the simulation thread and only copies the state into
+// a pooled buffer; encoding and writing happen on the writer thread. If
+// the writer falls behind and every buffer is queued, the frame is
+// dropped (and counted) rather than stalling the step, unless dropping is
+// turned off. Frames are encoded against the last frame actually
+// written, so a dropped frame is a gap in the recording, not corruption.
+// ---------------------
+class RecordingWriter {
+public:
+    RecordingWriter() = default;
+    ~RecordingWriter() { stop(); }
+    RecordingWriter(const RecordingWriter&) = delete;
+    RecordingWriter& operator=(const RecordingWriter&) = delete;
+
+    // Settings take effect on the next start()
+    void setKeyframeInterval(uint32_t frames) { keyframeInterval = std::max(1u, frames); }
+    void setQuantum(float q) { quantum = q > 0.f ? q : quantum; }
+    // Buffers the writer may fall behind by before frames are dropped
+    void setQueueDepth(size_t frames) { queueDepth = std::max<size_t>(1, frames); }
+    // Off: capture() waits for the writer instead of dropping frames
+    // (headless runs that want every step)
+    void setDropWhenBehind(bool drop) { dropWhenBehind = drop; }
+    // Recording stops (and the file is closed cleanly) before the file
+    // grows past this size; 0 = no limit
+    void setMaxBytes(uint64_t bytes) { maxBytes = bytes; }
+
+    bool start(const std::string& path, float stepDt, std::string& error);
+    // Waits for the queue to drain, writes the index and closes the file
+    void stop();
+    bool isRecording() const { return recording; }
+
+    // Call after a step; 'step' should increase between calls
+    void capture(const World& world, uint64_t step);
+
+    uint64_t getFramesWritten() const { return framesWritten.load(std::memory_order_relaxed); }
+    uint64_t getFramesDropped() const { return framesDropped; }
+    uint64_t getBytesWritten() const { return bytesWritten.load(std::memory_order_relaxed); }
+    // True once the size limit was hit; later captures are ignored
+    bool isFull() const { return full.load(std::memory_order_relaxed); }
+
+private:
+    struct Frame {
+        uint64_t step = 0;
+        bool keyframe = false;
+        size_t count = 0;
+        std::vector<float> posX, posY, velX, velY;
+        // Keyframes only
+        std::vector<uint8_t> type;
+        std::vector<float> sizeX, sizeY, mass, elasticity;
+    };
+
+    void writerLoop();
+    void encode(const Frame& frame);
+    void encodeKeyframe(const Frame& frame);
+    void encodeDelta(const Frame& frame);
+    bool append(const void* data, size_t bytes);
+
+private:
+    uint32_t keyframeInterval = 60;
+    float quantum = 1.f / 64.f;
+    size_t queueDepth = 8;
+    bool dropWhenBehind = true;
+    uint64_t maxBytes = 0;
+
+    bool recording = false;
+    std::ofstream file;
+    std::thread writer;
+
+    // Sim thread -> writer thread
+    std::mutex mutex;
+    std::condition_variable wake;
+    std::condition_variable frameFreed;
+    std::deque<std::unique_ptr<Frame>> queue;
+    std::vector<std::unique_ptr<Frame>> freeFrames;
+    bool stopping = false;
+
+    // Sim thread only
+    size_t lastCount = 0;
+    uint64_t lastLayout = 0;     // BodyStore::getLayoutRevision()
+    uint32_t sinceKeyframe = 0;
+    uint64_t framesDropped = 0;
+
+    // Writer thread only: quantized history (q1 = last frame, q0 = the
+    // one before) of posX, posY, velX, velY, and the output buffer
+    std::vector<int32_t> q1[4], q0[4];
+    std::vector<uint8_t> out;
+    std::vector<RecordingIndexEntry> index;
+    uint64_t lastStep = 0;
+
+    std::atomic<uint64_t> framesWritten{ 0 };
+    std::atomic<uint64_t> bytesWritten{ 0 };
+    std::atomic<bool> full{ false };
+};
+
+// ---------------------
+// Random access into a recording: seek() decodes from the nearest
+// keyframe at or before the target (or onwards from the current frame,
+// when that is closer), so scrubbing never re-simulates.
+// ---------------------
+class RecordingReader {
+public:
+    bool open(const std::string& path, std::string& error);
+    void close();
+    bool isOpen() const { return file.data() != nullptr; }
+
+    float getStepDt() const { return stepDt; }
+    uint64_t getFirstStep() const { return keyframes.empty() ? 0 : keyframes.front().step; }
+    uint64_t getLastStep() const { return lastStep; }
+    size_t getKeyframeCount() const { return keyframes.size(); }
+
+    // Decodes the last frame at or before 'step' (the first frame if
+    // 'step' is earlier). False if the file is damaged there.
+    bool seek(uint64_t step);
+    uint64_t getStep() const { return currentStep; }
+
+    // State of the current frame, valid until the next seek()
+    size_t getBodyCount() const { return count; }
+    BodyColumns getColumns() const;
+    // Writes positions and velocities into 'world', which must already
+    // hold the same bodies (see getColumns() to build it)
+    void apply(World& world) const;
+
+private:
+    bool decodeAt(uint64_t offset);
+    bool decodeKeyframe(const FrameHeader& h, const uint8_t* payload);
+    bool decodeDelta(const FrameHeader& h, const uint8_t* payload);
+    bool scanFrames(uint64_t offset);
+    bool readFrameHeader(uint64_t offset, FrameHeader& h) const;
+
+private:
+    MappedFile file;
+    float stepDt = 0.f;
+    float quantum = 1.f;
+    std::vector<RecordingIndexEntry> keyframes;
+    uint64_t lastStep = 0;
+    uint64_t framesEnd = 0;        // index offset, or file size without one
+
+    // Current frame; nextOffset is where the following frame starts
+    bool valid = false;
+    uint64_t currentStep = 0;
+    uint64_t nextOffset = 0;
+    size_t count = 0;
+    std::vector<uint8_t> type;
+    std::vector<float> sizeX, sizeY, mass, elasticity;
+    std::vector<float> state[4];
+    std::vector<int32_t> q1[4], q0[4];
+};
@@ -0,0 +1,71 @@
+#include "Rewind.hpp"
+#include <algorithm>
+#include <cmath>
+
+void RewindBuffer::configure(float span, float step, size_t budget) {
+    seconds = std::max(span, 0.f);
+    baseInterval = interval = std::max(step, 1e-3f);
+    fullCapacity = std::max<size_t>(1, static_cast<size_t>(std::ceil(seconds / interval)));
+    maxBytes = budget;
+    slots.clear();
+    slots.resize(fullCapacity);
+    clear();
+}
+
+void RewindBuffer::fitBudget() {
+    if (maxBytes == 0 || count == 0) return;
+    // Sizes vary with the contacts; fit the largest held
+    size_t snapshotBytes = 1;
+    for (size_t k = 0; k < count; ++k) snapshotBytes = std::max(snapshotBytes, slots[slotIndex(k)].snapshot.getByteSize());
+    const size_t capacity = std::clamp<size_t>(maxBytes / snapshotBytes, 1, fullCapacity);
+    if (capacity == slots.size()) return;
+
+    // Keep the newest snapshots, oldest first, in a ring of the new size
+    const size_t kept = std::min(count, capacity);
+    std::vector<Slot> resized(capacity);
+    for (size_t k = 0; k < kept; ++k) resized[k] = std::move(slots[slotIndex(count - kept + k)]);
+    slots = std::move(resized);
+    first = 0;
+    count = kept;
+    interval = std::max(baseInterval, seconds / static_cast<float>(capacity));
+}
+
+void RewindBuffer::record(const World& world, float time) {
+    if (count && time < slots[slotIndex(count - 1)].time + interval) return;
+    fitBudget();
+
+    Slot* slot;
+    if (count < slots.size()) {
+        slot = &slots[slotIndex(count)];
+        ++count;
+    }
+    else {
+        // Full: the oldest slot becomes the newest
+        slot = &slots[first];
+        first = (first + 1) % slots.size();
+    }
+    world.saveSnapshot(slot->snapshot);
+    slot->time = time;
+    if (count == 1) fitBudget();
+}
+
+size_t RewindBuffer::getByteSize() const {
+    size_t bytes = 0;
+    for (const Slot& s : slots) bytes += s.snapshot.getByteSize();
+    return bytes;
+}
+
+bool RewindBuffer::stepBack(World& world, float& time, bool* bodiesChanged) {
+    // A little slack, so a snapshot taken in this very step counts as now
+    const float before = time - 1e-4f;
+    size_t k = count;
+    while (k && slots[slotIndex(k - 1)].time >= before) --k;
+    if (!k) return false;
+    count = k;
+
+    const Slot& slot = slots[slotIndex(count - 1)];
+    const bool changed = world.restoreSnapshot(slot.snapshot);
+    if (bodiesChanged) *bodiesChanged = changed;
+    time = slot.time;
+    return true;
+}
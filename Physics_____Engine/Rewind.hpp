@@ -0,0 +1,68 @@
+#pragma once
+#include "World.hpp"
+#include <vector>
+
+// ---------------------
+// The last few seconds of a run as a ring of world snapshots, one per
+// 'interval' of simulated time, to step back through. Once the ring has
+// wrapped, every slot (and its buffer) is reused, so keeping history
+// costs one snapshot copy per interval and no allocation. Memory is
+// capacity * snapshot size: at 0.1 s over 10 s, 100 snapshots.
+//
+// With a byte budget, the ring holds only as many snapshots as fit in it
+// at the current snapshot size, and spaces them further apart so they
+// still span the whole history: a large world steps back in coarser
+// jumps instead of growing without bound. The ring is resized (keeping
+// the newest snapshots) when the world's size moves the fit.
+// ---------------------
+class RewindBuffer {
+public:
+    RewindBuffer() { configure(10.f, 0.1f); }
+
+    // Keeps 'seconds' of history at one snapshot per 'interval', within
+    // 'maxBytes' of snapshots (0 = no limit); clears it
+    void configure(float seconds, float interval, size_t maxBytes = 0);
+    // The spacing in use, stretched past the configured one by the budget
+    float getInterval() const { return interval; }
+    size_t getCapacity() const { return slots.size(); }
+    size_t getMaxBytes() const { return maxBytes; }
+
+    // Forgets the history but keeps the buffers
+    void clear() { first = 0; count = 0; }
+
+    // Call after each step with the simulated time; takes a snapshot when
+    // the ring is empty or 'interval' has passed since the newest
+    void record(const World& world, float time);
+
+    size_t size() const { return count; }
+    bool empty() const { return count == 0; }
+    float getOldestTime() const { return count ? slots[first].time : 0.f; }
+    float getNewestTime() const { return count ? slots[slotIndex(count - 1)].time : 0.f; }
+    size_t getByteSize() const;
+
+    // Restores the newest snapshot taken before 'time' and sets 'time' to
+    // its time. Newer snapshots are dropped (the run forks from there);
+    // the restored one stays, so pressing again goes one further back.
+    // False if there is none. 'bodiesChanged' as World::restoreSnapshot.
+    bool stepBack(World& world, float& time, bool* bodiesChanged = nullptr);
+
+private:
+    struct Slot {
+        WorldSnapshot snapshot;
+        float time = 0.f;
+    };
+
+    size_t slotIndex(size_t k) const { return (first + k) % slots.size(); }
+    // Fits the ring to the budget at the largest snapshot held
+    void fitBudget();
+
+private:
+    std::vector<Slot> slots;
+    float seconds = 10.f;
+    float baseInterval = 0.1f;
+    float interval = 0.1f;
+    size_t fullCapacity = 1;    // slots without a budget
+    size_t maxBytes = 0;
+    size_t first = 0;           // oldest
+    size_t count = 0;
+};
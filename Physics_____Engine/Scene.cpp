@@ -0,0 +1,410 @@
+#include "Scene.hpp"
+#include "SceneBinary.hpp"
+#include <fstream>
+#include <sstream>
+#include <algorithm>
+#include <cmath>
+
+static bool readBodyTail(std::istringstream& in, Body& body) {
+    float vx = 0.f, vy = 0.f, mass = 1.f, elasticity = 0.5f;
+    if (in >> vx) {
+        if (!(in >> vy >> mass >> elasticity)) return false;
+    }
+    body.velocity = { vx, vy };
+    body.mass = std::max(0.01f, mass);
+    body.elasticity = std::clamp(elasticity, 0.f, 1.f);
+    return true;
+}
+
+// "<a> <b | world x y> [length [frequency damping]]" after the joint type
+static bool readJoint(std::istringstream& in, const World& world, size_t first, JointDef& joint) {
+    size_t a = 0;
+    std::string b;
+    if (!(in >> a >> b) || first + a >= world.size()) return false;
+    joint.a = world.getHandle(first + a);
+    if (b == "world") {
+        if (!(in >> joint.anchor.x >> joint.anchor.y)) return false;
+    }
+    else {
+        std::istringstream bIn(b);
+        size_t index = 0;
+        if (!(bIn >> index) || first + index >= world.size()) return false;
+        joint.b = world.getHandle(first + index);
+    }
+    if (in >> joint.length) {
+        if (in >> joint.frequency && !(in >> joint.damping)) return false;
+    }
+    return true;
+}
+
+bool loadSceneText(const std::string& path, World& world, std::string& error, std::vector<SceneLine>* lines) {
+    std::ifstream file(path);
+    if (!file) {
+        error = "cannot open " + path;
+        return false;
+    }
+    const size_t first = world.size();
+
+    std::string line;
+    int lineNo = 0;
+    while (std::getline(file, line)) {
+        ++lineNo;
+        size_t hash = line.find('#');
+        if (hash != std::string::npos) line.erase(hash);
+
+        std::istringstream in(line);
+        std::string keyword;
+        if (!(in >> keyword)) continue;
+
+        bool ok = true;
+        if (keyword == "gravity") {
+            float g = 0.f;
+            ok = static_cast<bool>(in >> g);
+            if (ok) world.setGravity(g);
+        }
+        else if (keyword == "ground") {
+            float y = 0.f, friction = 0.f;
+            ok = static_cast<bool>(in >> y);
+            if (ok) {
+                in >> friction;
+                world.setGroundY(y);
+                world.setGroundFriction(std::clamp(friction, 0.f, 1.f));
+            }
+        }
+        else if (keyword == "cellsize") {
+            float size = 0.f;
+            ok = static_cast<bool>(in >> size);
+            if (ok) world.setCellSize(std::max(0.f, size));
+        }
+        else if (keyword == "sleep") {
+            std::string first;
+            ok = static_cast<bool>(in >> first);
+            if (ok && first == "off") {
+                world.setSleepEnabled(false);
+            }
+            else if (ok) {
+                std::istringstream speedIn(first);
+                float speed = 0.f, time = 0.f;
+                ok = (speedIn >> speed) && (in >> time);
+                if (ok) world.setSleepThresholds(std::max(0.f, speed), std::max(0.f, time));
+            }
+        }
+        else if (keyword == "solver") {
+            int velocity = 0;
+            ok = static_cast<bool>(in >> velocity);
+            if (ok) world.setVelocityIterations(velocity);
+
+            std::string word;
+            while (ok && in >> word) {
+                if (word == "split")
+                    world.setContactCorrection(ContactSolver::Correction::SplitImpulse);
+                else if (word == "baumgarte")
+                    world.setContactCorrection(ContactSolver::Correction::Baumgarte);
+                else {
+                    std::istringstream positionIn(word);
+                    int position = 0;
+                    ok = static_cast<bool>(positionIn >> position);
+                    if (ok) world.setPositionIterations(position);
+                }
+            }
+        }
+        else if (keyword == "circle") {
+            Body body;
+            body.type = ObjectType::Circle;
+            float r = 0.f;
+            ok = (in >> body.position.x >> body.position.y >> r) && readBodyTail(in, body);
+            body.size = { r, r };
+            if (ok) world.addBody(body);
+        }
+        else if (keyword == "rect" || keyword == "triangle") {
+            Body body;
+            body.type = keyword == "rect" ? ObjectType::Rectangle : ObjectType::Triangle;
+            ok = (in >> body.position.x >> body.position.y >> body.size.x >> body.size.y) && readBodyTail(in, body);
+            if (ok) world.addBody(body);
+        }
+        else if (keyword == "trigger") {
+            SceneLine l;
+            ok = static_cast<bool>(in >> l.start.x >> l.start.y >> l.end.x >> l.end.y);
+            if (ok && lines) lines->push_back(l);
+        }
+        else if (keyword == "joint") {
+            std::string type;
+            JointDef joint;
+            ok = (in >> type) && parseJointType(type, joint.type) && readJoint(in, world, first, joint)
+                 && world.addJoint(joint) != JointSolver::noJoint;
+        }
+        else {
+            ok = false;
+        }
+
+        if (!ok) {
+            error = path + ":" + std::to_string(lineNo) + ": cannot parse '" + line + "'";
+            return false;
+        }
+    }
+    return true;
+}
+
+bool saveSceneText(const std::string& path, const World& world, const std::vector<SceneLine>& lines, std::string& error) {
+    std::ofstream file(path);
+    if (!file) {
+        error = "cannot write " + path;
+        return false;
+    }
+
+    // Enough digits that a text round trip does not move anything
+    file.precision(9);
+    file << "gravity " << world.getGravity() << "\n";
+    file << "ground " << world.getGroundY() << " " << world.getGroundFriction() << "\n";
+    file << "cellsize " << world.getCellSize() << "\n";
+    if (world.isSleepEnabled())
+        file << "sleep " << world.getSleepSpeed() << " " << world.getSleepTime() << "\n";
+    else
+        file << "sleep off\n";
+    file << "solver " << world.getVelocityIterations() << " " << world.getPositionIterations() << " "
+         << (world.getContactCorrection() == ContactSolver::Correction::Baumgarte ? "baumgarte" : "split") << "\n";
+    // Joints refer to bodies by their place in the file
+    std::vector<size_t> fileIndex(world.size(), SIZE_MAX);
+    size_t written = 0;
+    for (size_t i = 0; i < world.size(); ++i) {
+        const Body b = world.getBody(i);
+        if (b.type == ObjectType::None) continue;
+        fileIndex[i] = written++;
+
+        const char* keyword = b.type == ObjectType::Circle ? "circle" : b.type == ObjectType::Rectangle ? "rect" : "triangle";
+        file << keyword << " " << b.position.x << " " << b.position.y << " " << b.size.x;
+        if (b.type != ObjectType::Circle) file << " " << b.size.y;
+        file << " " << b.velocity.x << " " << b.velocity.y << " " << b.mass << " " << b.elasticity << "\n";
+    }
+    for (const SceneLine& l : lines)
+        file << "trigger " << l.start.x << " " << l.start.y << " " << l.end.x << " " << l.end.y << "\n";
+    for (size_t k = 0; k < world.getJointCount(); ++k) {
+        const JointDef& j = world.getJoint(k);
+        const size_t a = world.indexOf(j.a);
+        const size_t b = j.toWorld() ? BodyStore::noBody : world.indexOf(j.b);
+        if (a == BodyStore::noBody || fileIndex[a] == SIZE_MAX) continue;
+        if (!j.toWorld() && (b == BodyStore::noBody || fileIndex[b] == SIZE_MAX)) continue;
+
+        file << "joint " << jointTypeName(j.type) << " " << fileIndex[a] << " ";
+        if (j.toWorld())
+            file << "world " << j.anchor.x << " " << j.anchor.y;
+        else
+            file << fileIndex[b];
+        file << " " << j.length << " " << j.frequency << " " << j.damping << "\n";
+    }
+
+    if (!file) {
+        error = "failed writing " + path;
+        return false;
+    }
+    return true;
+}
+
+bool loadScene(const std::string& path, World& world, std::vector<SceneLine>* lines, std::string& error) {
+    char magic[8] = {};
+    std::ifstream probe(path, std::ios::binary);
+    probe.read(magic, sizeof(magic));
+    if (probe && std::string(magic, sizeof(magic)) == "PHYSCENE")
+        return loadSceneBinary(path, world, lines, error);
+    return loadSceneText(path, world, error, lines);
+}
+
+bool saveScene(const std::string& path, const World& world, const std::vector<SceneLine>& lines, std::string& error) {
+    const std::string ext = ".pscene";
+    if (path.size() >= ext.size() && path.compare(path.size() - ext.size(), ext.size(), ext) == 0)
+        return saveSceneBinary(path, world, lines, error);
+    return saveSceneText(path, world, lines, error);
+}
+
+// --- Generated scenes ---
+namespace {
+    // SplitMix64: the standard distributions differ between libraries,
+    // this does not
+    struct SceneRandom {
+        uint64_t state;
+
+        explicit SceneRandom(uint32_t seed) : state(seed * 0x9E3779B97F4A7C15ull + 1) {}
+
+        uint64_t next() {
+            uint64_t z = (state += 0x9E3779B97F4A7C15ull);
+            z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+            z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+            return z ^ (z >> 31);
+        }
+        float uniform(float lo, float hi) {
+            return lo + (hi - lo) * static_cast<float>(next() >> 40) * (1.f / 16777216.f);
+        }
+        uint32_t below(uint32_t n) { return static_cast<uint32_t>(next() % n); }
+    };
+}
+
+void generateRain(World& world, size_t count, float radius) {
+    const size_t columns = std::max<size_t>(1, static_cast<size_t>(std::sqrt(static_cast<double>(count))));
+    const float spacing = radius * 3.f;
+
+    world.setGroundY(0.f);
+    world.reserve(world.size() + count);
+
+    for (size_t i = 0; i < count; ++i) {
+        Body body;
+        body.type = ObjectType::Circle;
+        body.size = { radius, radius };
+        body.position = { static_cast<float>(i % columns) * spacing,
+                          -spacing - static_cast<float>(i / columns) * spacing };
+        world.addBody(body);
+    }
+}
+
+void generatePile(World& world, size_t count, uint32_t seed) {
+    SceneRandom random(seed);
+    const size_t columns = std::max<size_t>(1, static_cast<size_t>(std::sqrt(static_cast<double>(count) * 4.0)));
+    const float spacing = 11.f;
+
+    world.setGroundY(0.f);
+    world.reserve(world.size() + count);
+
+    for (size_t i = 0; i < count; ++i) {
+        const float x = static_cast<float>(i % columns) * spacing + random.uniform(-0.5f, 0.5f);
+        const float y = -spacing * 0.5f - static_cast<float>(i / columns) * spacing;
+
+        Body body;
+        if (random.below(2) == 0) {
+            body.type = ObjectType::Circle;
+            const float r = random.uniform(3.f, 5.f);
+            body.size = { r, r };
+            body.position = { x, y };
+        }
+        else {
+            body.type = ObjectType::Rectangle;
+            body.size = { random.uniform(5.f, 9.f), random.uniform(5.f, 9.f) };
+            body.position = { x - body.size.x * 0.5f, y - body.size.y * 0.5f };
+        }
+        body.mass = body.size.x * body.size.y * 0.05f;
+        body.elasticity = 0.1f;
+        world.addBody(body);
+    }
+}
+
+void generateStacks(World& world, size_t count, size_t height) {
+    const float box = 16.f;
+    const float gap = 1.f;
+    height = std::max<size_t>(1, height);
+
+    world.setGroundY(0.f);
+    world.reserve(world.size() + count);
+
+    for (size_t i = 0; i < count; ++i) {
+        const size_t tower = i / height;
+        const size_t level = i % height;
+
+        Body body;
+        body.type = ObjectType::Rectangle;
+        body.size = { box, box };
+        body.position = { static_cast<float>(tower) * box * 2.5f,
+                          -static_cast<float>(level + 1) * (box + gap) };
+        body.elasticity = 0.f;
+        world.addBody(body);
+    }
+}
+
+void generateMixed(World& world, size_t count, uint32_t seed) {
+    SceneRandom random(seed);
+    const size_t columns = std::max<size_t>(1, static_cast<size_t>(std::sqrt(static_cast<double>(count))));
+    const float spacing = 24.f;
+    const float top = -static_cast<float>(count / columns + 1) * spacing;
+
+    world.setGroundY(0.f);
+    world.reserve(world.size() + count);
+
+    for (size_t i = 0; i < count; ++i) {
+        Body body;
+        if (i % 20 == 19) {
+            // Projectile: small, heavy and fast, from off to the left
+            body.type = ObjectType::Circle;
+            body.size = { 2.f, 2.f };
+            body.position = { -random.uniform(50.f, 500.f), random.uniform(top, -spacing) };
+            body.velocity = { random.uniform(600.f, 1200.f), random.uniform(-150.f, 0.f) };
+            body.mass = 4.f;
+            body.elasticity = 0.3f;
+            world.addBody(body);
+            continue;
+        }
+
+        const float x = static_cast<float>(i % columns) * spacing + random.uniform(-3.f, 3.f);
+        const float y = -spacing - static_cast<float>(i / columns) * spacing + random.uniform(-3.f, 3.f);
+        switch (random.below(3)) {
+        case 0:
+            body.type = ObjectType::Circle;
+            body.size.x = body.size.y = random.uniform(3.f, 8.f);
+            body.position = { x, y };
+            break;
+        case 1:
+            body.type = ObjectType::Rectangle;
+            body.size = { random.uniform(6.f, 16.f), random.uniform(6.f, 16.f) };
+            body.position = { x - body.size.x * 0.5f, y - body.size.y * 0.5f };
+            break;
+        default:
+            body.type = ObjectType::Triangle;
+            body.size = { random.uniform(8.f, 16.f), random.uniform(8.f, 16.f) };
+            body.position = { x - body.size.x * 0.5f, y - body.size.y * 0.5f };
+            break;
+        }
+        body.velocity = { random.uniform(-20.f, 20.f), 0.f };
+        body.mass = random.uniform(0.5f, 2.f);
+        body.elasticity = random.uniform(0.1f, 0.7f);
+        world.addBody(body);
+    }
+}
+
+void generateTriggerField(World& world, size_t count, std::vector<SceneLine>& lines, uint32_t seed) {
+    SceneRandom random(seed);
+    const float radius = 4.f;
+    generateRain(world, count, radius);
+
+    // Lines scattered over the columns the rain falls through, down to
+    // the ground
+    const size_t columns = std::max<size_t>(1, static_cast<size_t>(std::sqrt(static_cast<double>(count))));
+    const float width = static_cast<float>(columns) * radius * 3.f;
+    const float top = -static_cast<float>(count / columns + 1) * radius * 3.f;
+    const size_t lineCount = std::max<size_t>(1, count / 8);
+    lines.reserve(lines.size() + lineCount);
+
+    for (size_t i = 0; i < lineCount; ++i) {
+        const sf::Vector2f start(random.uniform(0.f, width), random.uniform(top, -radius));
+        const float angle = random.uniform(-0.5f, 0.5f);
+        const float length = random.uniform(20.f, 60.f);
+        lines.push_back({ start, start + sf::Vector2f(std::cos(angle), std::sin(angle)) * length });
+    }
+}
+
+void generateRopes(World& world, size_t count, size_t segments, uint32_t seed) {
+    SceneRandom random(seed);
+    segments = std::max<size_t>(1, segments);
+    const size_t ropes = std::max<size_t>(1, count / (segments + 1));
+    const float link = 6.f;
+    const float length = link * static_cast<float>(segments + 1);
+    const float spacing = length * 0.5f;
+
+    world.setGroundY(0.f);
+    world.reserve(world.size() + ropes * (segments + 1));
+
+    for (size_t i = 0; i < ropes; ++i) {
+        // Each weight starts to one side of its anchor, so the ropes swing
+        // into their neighbours
+        const sf::Vector2f anchor(static_cast<float>(i) * spacing, -length * 2.f);
+        const float angle = random.uniform(-1.2f, 1.2f);
+
+        Body weight;
+        weight.type = ObjectType::Circle;
+        weight.size = { 5.f, 5.f };
+        weight.position = anchor + sf::Vector2f(std::sin(angle), std::cos(angle)) * length;
+        weight.mass = 2.f;
+        weight.elasticity = 0.2f;
+
+        RopeDef rope;
+        rope.a = world.getHandle(world.addBody(weight));
+        rope.anchor = anchor;
+        rope.segments = segments;
+        world.addRope(rope);
+    }
+}
@@ -0,0 +1,61 @@
+#pragma once
+#include "World.hpp"
+#include <string>
+#include <vector>
+
+// ---------------------
+// Plain-text scene files, one statement per line ('#' starts a comment):
+//
+//   gravity  <g>
+//   ground   <y> [friction]
+//   cellsize <size>                  (broadphase grid, 0 = automatic)
+//   sleep    <speed> <time> | off    (rest thresholds in px/s and seconds)
+//   solver   <velocity iterations> [position iterations] [split | baumgarte]
+//   circle   <x> <y> <radius>        [vx vy mass elasticity]
+//   rect     <x> <y> <width> <height> [vx vy mass elasticity]
+//   triangle <x> <y> <width> <height> [vx vy mass elasticity]
+//   trigger  <x0> <y0> <x1> <y1>
+//   joint    <distance|spring|rope|pin> <a> <b | world x y> [length [frequency damping]]
+//
+// Joint ends are body indices counted from the first body of the file;
+// a length of 0 (or none) is the distance when the scene is loaded.
+// Large scenes are better kept in the binary format (SceneBinary.hpp);
+// loadScene/saveScene pick the format from the file.
+// ---------------------
+
+// Trigger line as stored in a scene; the world itself does not use them
+struct SceneLine {
+    sf::Vector2f start{};
+    sf::Vector2f end{};
+};
+
+// Trigger lines are appended to 'lines' if given, skipped otherwise
+bool loadSceneText(const std::string& path, World& world, std::string& error, std::vector<SceneLine>* lines = nullptr);
+bool saveSceneText(const std::string& path, const World& world, const std::vector<SceneLine>& lines, std::string& error);
+
+// Binary if the file starts with the .pscene magic, text otherwise
+bool loadScene(const std::string& path, World& world, std::vector<SceneLine>* lines, std::string& error);
+// Binary for a .pscene path, text otherwise
+bool saveScene(const std::string& path, const World& world, const std::vector<SceneLine>& lines, std::string& error);
+
+// ---------------------
+// Generated test scenes (runner, benchmark). All put the ground at y = 0
+// with the bodies above it, and are the same for the same arguments on
+// every platform.
+// ---------------------
+
+// Grid of 'count' circles of the given radius, dropped from above the ground
+void generateRain(World& world, size_t count, float radius);
+// Mixed small circles and boxes packed tightly just above the ground,
+// so they settle into one wide, dense pile
+void generatePile(World& world, size_t count, uint32_t seed = 1);
+// Towers of 'height' boxes standing on the ground, side by side
+void generateStacks(World& world, size_t count, size_t height = 30);
+// Circles, rectangles and triangles of random sizes falling from a loose
+// grid, with one in twenty a small projectile fired in from the left
+void generateMixed(World& world, size_t count, uint32_t seed = 1);
+// Rain crossing a field of count / 8 short trigger lines, appended to 'lines'
+void generateTriggerField(World& world, size_t count, std::vector<SceneLine>& lines, uint32_t seed = 1);
+// Weights swinging on ropes of 'segments' links hung side by side from
+// world anchors, about 'count' bodies in all
+void generateRopes(World& world, size_t count, size_t segments = 30, uint32_t seed = 1);
@@ -0,0 +1,316 @@
+#include "SceneBinary.hpp"
+#include "Scene.hpp"
+#include <algorithm>
+#include <bit>
+#include <cstring>
+#include <fstream>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace {
+
+const char sceneMagic[8] = { 'P', 'H', 'Y', 'S', 'C', 'E', 'N', 'E' };
+
+uint64_t align64(uint64_t offset) { return (offset + 63) & ~uint64_t(63); }
+
+size_t columnElementSize(int c) { return c == ColumnType ? 1 : 4; }
+
+uint64_t jointOffset(const SceneFileHeader& h) { return align64(h.lineOffset + h.lineCount * 16); }
+
+}
+
+// --- MappedFile ---
+#ifdef _WIN32
+bool MappedFile::open(const std::string& path, std::string& error) {
+    close();
+    HANDLE f = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (f == INVALID_HANDLE_VALUE) {
+        error = "cannot open " + path;
+        return false;
+    }
+    LARGE_INTEGER size{};
+    if (!GetFileSizeEx(f, &size) || size.QuadPart == 0) {
+        CloseHandle(f);
+        error = path + ": empty file";
+        return false;
+    }
+    HANDLE m = CreateFileMappingA(f, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    const void* view = m ? MapViewOfFile(m, FILE_MAP_READ, 0, 0, 0) : nullptr;
+    if (!view) {
+        if (m) CloseHandle(m);
+        CloseHandle(f);
+        error = "cannot map " + path;
+        return false;
+    }
+    file = f;
+    mapping = m;
+    bytes = static_cast<const uint8_t*>(view);
+    length = static_cast<size_t>(size.QuadPart);
+    return true;
+}
+
+void MappedFile::close() {
+    if (bytes) UnmapViewOfFile(bytes);
+    if (mapping) CloseHandle(mapping);
+    if (file) CloseHandle(file);
+    bytes = nullptr;
+    mapping = file = nullptr;
+    length = 0;
+}
+#else
+bool MappedFile::open(const std::string& path, std::string& error) {
+    close();
+    const int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        error = "cannot open " + path;
+        return false;
+    }
+    struct stat st{};
+    if (fstat(fd, &st) != 0 || st.st_size == 0) {
+        ::close(fd);
+        error = path + ": empty file";
+        return false;
+    }
+    void* view = mmap(nullptr, static_cast<size_t>(st.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd);
+    if (view == MAP_FAILED) {
+        error = "cannot map " + path;
+        return false;
+    }
+    bytes = static_cast<const uint8_t*>(view);
+    length = static_cast<size_t>(st.st_size);
+    return true;
+}
+
+void MappedFile::close() {
+    if (bytes) munmap(const_cast<uint8_t*>(bytes), length);
+    bytes = nullptr;
+    length = 0;
+}
+#endif
+
+// --- MappedScene ---
+bool MappedScene::open(const std::string& path, std::string& error) {
+    if constexpr (std::endian::native != std::endian::little) {
+        error = "scene files are little-endian; this host is not";
+        return false;
+    }
+    if (!file.open(path, error)) return false;
+
+    auto fail = [&](const char* what) {
+        error = path + ": " + what;
+        file.close();
+        return false;
+    };
+    if (file.size() < sizeof(SceneFileHeader)) return fail("not a scene file");
+
+    const SceneFileHeader& h = header();
+    if (std::memcmp(h.magic, sceneMagic, sizeof(sceneMagic)) != 0) return fail("not a scene file");
+    if (h.version < sceneFileOldestVersion || h.version > sceneFileVersion) return fail("unsupported scene version");
+    if (h.headerSize < sizeof(SceneFileHeader) || h.fileSize != file.size()) return fail("truncated or corrupt");
+
+    // Every column and the line table must lie inside the file
+    const uint64_t size = file.size();
+    if (h.bodyCount > size || h.lineCount > size) return fail("truncated or corrupt");
+    for (int c = 0; c < ColumnCount; ++c) {
+        const uint64_t offset = h.columnOffset[c];
+        if (offset % 4 != 0 || offset > size || h.bodyCount * columnElementSize(c) > size - offset)
+            return fail("truncated or corrupt");
+    }
+    if (h.lineOffset % 4 != 0 || h.lineOffset > size || h.lineCount * 16 > size - h.lineOffset)
+        return fail("truncated or corrupt");
+    if (h.version < 2 && h.jointCount != 0) return fail("truncated or corrupt");
+    if (h.jointCount && (jointOffset(h) > size || uint64_t(h.jointCount) * sizeof(SceneJoint) > size - jointOffset(h)))
+        return fail("truncated or corrupt");
+    return true;
+}
+
+BodyColumns MappedScene::getColumns() const {
+    BodyColumns c;
+    c.count = getBodyCount();
+    c.type = file.data() + header().columnOffset[ColumnType];
+    c.posX = column(ColumnPosX);
+    c.posY = column(ColumnPosY);
+    c.sizeX = column(ColumnSizeX);
+    c.sizeY = column(ColumnSizeY);
+    c.velX = column(ColumnVelX);
+    c.velY = column(ColumnVelY);
+    c.mass = column(ColumnMass);
+    c.elasticity = column(ColumnElasticity);
+    return c;
+}
+
+const float* MappedScene::getLines() const {
+    return reinterpret_cast<const float*>(file.data() + header().lineOffset);
+}
+
+const SceneJoint* MappedScene::getJoints() const {
+    return reinterpret_cast<const SceneJoint*>(file.data() + jointOffset(header()));
+}
+
+// --- Load / save ---
+bool loadSceneBinary(const std::string& path, World& world, std::vector<SceneLine>* lines, std::string& error) {
+    MappedScene scene;
+    if (!scene.open(path, error)) return false;
+
+    const SceneFileHeader& h = scene.header();
+    world.setGravity(h.gravity);
+    world.setGroundY(h.groundY);
+    world.setGroundFriction(std::clamp(h.groundFriction, 0.f, 1.f));
+    world.setCellSize(std::max(0.f, h.cellSize));
+    world.setSleepEnabled(!(h.flags & SceneSleepOff));
+    world.setSleepThresholds(std::max(0.f, h.sleepSpeed), std::max(0.f, h.sleepTime));
+    world.setVelocityIterations(h.velocityIterations);
+    world.setPositionIterations(h.positionIterations);
+    world.setContactCorrection(h.flags & SceneBaumgarte ? ContactSolver::Correction::Baumgarte : ContactSolver::Correction::SplitImpulse);
+    const size_t first = world.size();
+    world.addBodies(scene.getColumns());
+
+    const SceneJoint* joints = scene.getJoints();
+    for (size_t k = 0; k < scene.getJointCount(); ++k) {
+        const SceneJoint& j = joints[k];
+        const bool toWorld = j.b == sceneWorld;
+        if (j.type > static_cast<uint32_t>(JointType::Pin) || j.a >= scene.getBodyCount()
+            || (!toWorld && j.b >= scene.getBodyCount())) {
+            error = path + ": joint " + std::to_string(k) + " is corrupt";
+            return false;
+        }
+        JointDef joint;
+        joint.type = static_cast<JointType>(j.type);
+        joint.a = world.getHandle(first + j.a);
+        if (!toWorld) joint.b = world.getHandle(first + j.b);
+        joint.anchor = { j.anchorX, j.anchorY };
+        joint.length = j.length;
+        joint.frequency = j.frequency;
+        joint.damping = j.damping;
+        if (world.addJoint(joint) == JointSolver::noJoint) {
+            error = path + ": joint " + std::to_string(k) + " is corrupt";
+            return false;
+        }
+    }
+
+    if (lines) {
+        const float* l = scene.getLines();
+        for (size_t k = 0; k < scene.getLineCount(); ++k, l += 4)
+            lines->push_back({ { l[0], l[1] }, { l[2], l[3] } });
+    }
+    return true;
+}
+
+bool saveSceneBinary(const std::string& path, const World& world, const std::vector<SceneLine>& lines, std::string& error) {
+    const BodyStore& bodies = world.getStore();
+    const size_t n = bodies.count();
+
+    SceneFileHeader h{};
+    std::memcpy(h.magic, sceneMagic, sizeof(sceneMagic));
+    h.version = sceneFileVersion;
+    h.headerSize = sizeof(SceneFileHeader);
+    h.bodyCount = n;
+    h.lineCount = lines.size();
+    h.gravity = world.getGravity();
+    h.groundY = world.getGroundY();
+    h.groundFriction = world.getGroundFriction();
+    h.cellSize = world.getCellSize();
+    h.sleepSpeed = world.getSleepSpeed();
+    h.sleepTime = world.getSleepTime();
+    h.velocityIterations = world.getVelocityIterations();
+    h.positionIterations = world.getPositionIterations();
+    if (!world.isSleepEnabled()) h.flags |= SceneSleepOff;
+    if (world.getContactCorrection() == ContactSolver::Correction::Baumgarte) h.flags |= SceneBaumgarte;
+
+    uint64_t offset = align64(sizeof(SceneFileHeader));
+    for (int c = 0; c < ColumnCount; ++c) {
+        h.columnOffset[c] = offset;
+        offset = align64(offset + n * columnElementSize(c));
+    }
+    h.lineOffset = offset;
+
+    // Joints whose bodies are gone are left out
+    std::vector<SceneJoint> joints;
+    joints.reserve(world.getJointCount());
+    for (size_t k = 0; k < world.getJointCount(); ++k) {
+        const JointDef& j = world.getJoint(k);
+        const size_t a = world.indexOf(j.a);
+        const size_t b = j.toWorld() ? BodyStore::noBody : world.indexOf(j.b);
+        if (a == BodyStore::noBody || (!j.toWorld() && b == BodyStore::noBody)) continue;
+        joints.push_back({ static_cast<uint32_t>(j.type), static_cast<uint32_t>(a),
+                           j.toWorld() ? sceneWorld : static_cast<uint32_t>(b),
+                           j.anchor.x, j.anchor.y, j.length, j.frequency, j.damping });
+    }
+    h.jointCount = static_cast<uint32_t>(joints.size());
+    h.fileSize = joints.empty() ? offset + lines.size() * 16 : jointOffset(h) + joints.size() * sizeof(SceneJoint);
+
+    std::ofstream out(path, std::ios::binary | std::ios::trunc);
+    if (!out) {
+        error = "cannot write " + path;
+        return false;
+    }
+
+    uint64_t written = 0;
+    auto write = [&](const void* data, size_t bytes) {
+        out.write(static_cast<const char*>(data), static_cast<std::streamsize>(bytes));
+        written += bytes;
+    };
+    auto padTo = [&](uint64_t target) {
+        static const char zeros[64] = {};
+        write(zeros, static_cast<size_t>(target - written));
+    };
+
+    // Columns the store does not hold as-is go through a small buffer
+    std::vector<float> buffer;
+    auto writeDerived = [&](auto value) {
+        const size_t chunk = 1 << 14;
+        buffer.resize(std::min(n, chunk));
+        for (size_t begin = 0; begin < n; begin += chunk) {
+            const size_t end = std::min(n, begin + chunk);
+            for (size_t i = begin; i < end; ++i) buffer[i - begin] = value(i);
+            write(buffer.data(), (end - begin) * sizeof(float));
+        }
+    };
+
+    write(&h, sizeof(h));
+    padTo(h.columnOffset[ColumnType]);
+    std::vector<uint8_t> types(n);
+    for (size_t i = 0; i < n; ++i) types[i] = static_cast<uint8_t>(bodies.type[i]);
+    write(types.data(), n);
+    padTo(h.columnOffset[ColumnPosX]);
+    write(bodies.posX.data(), n * sizeof(float));
+    padTo(h.columnOffset[ColumnPosY]);
+    write(bodies.posY.data(), n * sizeof(float));
+    padTo(h.columnOffset[ColumnSizeX]);
+    writeDerived([&](size_t i) { return bodies.size[i].x; });
+    padTo(h.columnOffset[ColumnSizeY]);
+    writeDerived([&](size_t i) { return bodies.size[i].y; });
+    padTo(h.columnOffset[ColumnVelX]);
+    write(bodies.velX.data(), n * sizeof(float));
+    padTo(h.columnOffset[ColumnVelY]);
+    write(bodies.velY.data(), n * sizeof(float));
+    padTo(h.columnOffset[ColumnMass]);
+    writeDerived([&](size_t i) { return bodies.invMass[i] > 0.f ? 1.f / bodies.invMass[i] : 0.f; });
+    padTo(h.columnOffset[ColumnElasticity]);
+    write(bodies.restitution.data(), n * sizeof(float));
+    padTo(h.lineOffset);
+    for (const SceneLine& line : lines) {
+        const float l[4] = { line.start.x, line.start.y, line.end.x, line.end.y };
+        write(l, sizeof(l));
+    }
+    if (!joints.empty()) {
+        padTo(jointOffset(h));
+        write(joints.data(), joints.size() * sizeof(SceneJoint));
+    }
+
+    if (!out) {
+        error = "failed writing " + path;
+        return false;
+    }
+    return true;
+}
@@ -0,0 +1,128 @@
+#pragma once
+#include "World.hpp"
+#include <cstdint>
+#include <string>
+#include <vector>
+
+struct SceneLine;
+
+// ---------------------
+// Binary scene files (.pscene), little-endian, versioned.
+//
+//   header   SceneFileHeader (fixed size, at offset 0)
+//   columns  one array per body field, each starting on a 64-byte
+//            boundary: type (uint8), posX, posY, sizeX, sizeY, velX, velY,
+//            mass, elasticity (float32)
+//   lines    trigger lines as float32 x0 y0 x1 y1
+//   joints   SceneJoint records, on the 64-byte boundary after the lines
+//            (version 2 on; version 1 files have none)
+//
+// The body table is stored as columns, so a mapped file can be read in
+// place (MappedScene hands out pointers into the mapping) and loading is
+// one copy per array instead of per-body parsing.
+// ---------------------
+struct SceneFileHeader {
+    char magic[8];                 // "PHYSCENE"
+    uint32_t version;
+    uint32_t headerSize;
+    uint64_t fileSize;
+    uint64_t bodyCount;
+    uint64_t lineCount;
+    uint64_t columnOffset[9];      // see SceneColumn
+    uint64_t lineOffset;
+    float gravity;
+    float groundY;
+    float groundFriction;
+    float cellSize;                // 0 = automatic
+    float sleepSpeed;
+    float sleepTime;
+    int32_t velocityIterations;
+    int32_t positionIterations;
+    uint32_t flags;                // SceneFlags
+    uint32_t jointCount;           // version 1: reserved, always 0
+};
+static_assert(sizeof(SceneFileHeader) == 160, "scene header layout changed");
+
+enum SceneFlags : uint32_t {
+    SceneSleepOff = 1u << 0,
+    SceneBaumgarte = 1u << 1
+};
+
+// Joint ends are body indices in the file; b = sceneWorld ties a to the anchor
+struct SceneJoint {
+    uint32_t type;                 // JointType
+    uint32_t a;
+    uint32_t b;
+    float anchorX;
+    float anchorY;
+    float length;
+    float frequency;
+    float damping;
+};
+static_assert(sizeof(SceneJoint) == 32, "scene joint layout changed");
+
+constexpr uint32_t sceneWorld = UINT32_MAX;
+
+enum SceneColumn {
+    ColumnType, ColumnPosX, ColumnPosY, ColumnSizeX, ColumnSizeY,
+    ColumnVelX, ColumnVelY, ColumnMass, ColumnElasticity, ColumnCount
+};
+
+// ---------------------
+// Read-only memory mapping of a whole file
+// ---------------------
+class MappedFile {
+public:
+    MappedFile() = default;
+    ~MappedFile() { close(); }
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    bool open(const std::string& path, std::string& error);
+    void close();
+
+    const uint8_t* data() const { return bytes; }
+    size_t size() const { return length; }
+
+private:
+    const uint8_t* bytes = nullptr;
+    size_t length = 0;
+#ifdef _WIN32
+    void* file = nullptr;
+    void* mapping = nullptr;
+#endif
+};
+
+// ---------------------
+// A mapped .pscene, validated once on open and then read in place
+// ---------------------
+class MappedScene {
+public:
+    bool open(const std::string& path, std::string& error);
+
+    const SceneFileHeader& header() const { return *reinterpret_cast<const SceneFileHeader*>(file.data()); }
+    size_t getBodyCount() const { return static_cast<size_t>(header().bodyCount); }
+    size_t getLineCount() const { return static_cast<size_t>(header().lineCount); }
+    size_t getJointCount() const { return header().jointCount; }
+
+    // Pointers into the mapping, valid while this object lives
+    BodyColumns getColumns() const;
+    const float* getLines() const;
+    const SceneJoint* getJoints() const;
+
+private:
+    const float* column(SceneColumn c) const {
+        return reinterpret_cast<const float*>(file.data() + header().columnOffset[c]);
+    }
+
+private:
+    MappedFile file;
+};
+
+constexpr uint32_t sceneFileVersion = 2;
+constexpr uint32_t sceneFileOldestVersion = 1;
+
+// Appends the scene's bodies and joints to 'world' and applies its settings
+// (gravity, ground, grid, sleeping, solver). Trigger lines are appended to 'lines' if given.
+bool loadSceneBinary(const std::string& path, World& world, std::vector<SceneLine>* lines, std::string& error);
+bool saveSceneBinary(const std::string& path, const World& world, const std::vector<SceneLine>& lines, std::string& error);
@@ -0,0 +1,707 @@
+#include "SimdKernels.hpp"
+#include <algorithm>
+#include <cmath>
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) || defined(__i386__)
+#define PHYSICS_X86 1
+#include <immintrin.h>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+#endif
+
+#if defined(PHYSICS_X86) && (defined(__GNUC__) || defined(__clang__))
+#define PHYSICS_TARGET_AVX2 __attribute__((target("avx2")))
+#else
+#define PHYSICS_TARGET_AVX2
+#endif
+
+namespace {
+
+struct Streams {
+    float* px; float* py;
+    float* vx; float* vy;
+    const float* e;
+    const float* loX; const float* loY;
+    const float* hiX; const float* hiY;
+    float* minX; float* minY;
+    float* maxX; float* maxY;
+
+    explicit Streams(BodyStore& b)
+        : px(b.posX.data()), py(b.posY.data()), vx(b.velX.data()), vy(b.velY.data()),
+          e(b.restitution.data()),
+          loX(b.localMinX.data()), loY(b.localMinY.data()), hiX(b.localMaxX.data()), hiY(b.localMaxY.data()),
+          minX(b.minX.data()), minY(b.minY.data()), maxX(b.maxX.data()), maxY(b.maxY.data()) {}
+};
+
+void integrateScalar(const Streams& s, size_t begin, size_t end, const IntegrateParams& p) {
+    const float gdt = p.gravity * p.dt;
+    const float keep = 1.f - p.groundFriction;
+
+    for (size_t i = begin; i < end; ++i) {
+        float vy = s.vy[i] + gdt;
+        float vx = s.vx[i];
+        const float px = s.px[i] + vx * p.dt;
+        float py = s.py[i] + vy * p.dt;
+
+        const float bottom = py + s.hiY[i];
+        if (bottom >= p.groundY) {
+            py = py + (p.groundY - bottom);
+
+            vy = -vy * s.e[i];
+            vx = vx * keep;
+
+            if (std::abs(vy) < 1.f) vy = 0.f;
+            if (std::abs(vx) < 1.f) vx = 0.f;
+        }
+
+        s.vx[i] = vx;
+        s.vy[i] = vy;
+        s.px[i] = px;
+        s.py[i] = py;
+        s.minX[i] = px + s.loX[i];
+        s.minY[i] = py + s.loY[i];
+        s.maxX[i] = px + s.hiX[i];
+        s.maxY[i] = py + s.hiY[i];
+    }
+}
+
+#if defined(PHYSICS_X86)
+size_t integrateSse2(const Streams& s, size_t begin, size_t end, const IntegrateParams& p) {
+    const __m128 dt = _mm_set1_ps(p.dt);
+    const __m128 gdt = _mm_set1_ps(p.gravity * p.dt);
+    const __m128 groundY = _mm_set1_ps(p.groundY);
+    const __m128 keep = _mm_set1_ps(1.f - p.groundFriction);
+    const __m128 one = _mm_set1_ps(1.f);
+    const __m128 sign = _mm_set1_ps(-0.f);
+
+    size_t i = begin;
+    for (; i + 4 <= end; i += 4) {
+        __m128 vy = _mm_add_ps(_mm_loadu_ps(s.vy + i), gdt);
+        __m128 vx = _mm_loadu_ps(s.vx + i);
+        const __m128 px = _mm_add_ps(_mm_loadu_ps(s.px + i), _mm_mul_ps(vx, dt));
+        __m128 py = _mm_add_ps(_mm_loadu_ps(s.py + i), _mm_mul_ps(vy, dt));
+
+        const __m128 hiY = _mm_loadu_ps(s.hiY + i);
+        const __m128 bottom = _mm_add_ps(py, hiY);
+        const __m128 hit = _mm_cmpge_ps(bottom, groundY);
+
+        // Bounced values, blended in only where the body reached the ground
+        const __m128 pyG = _mm_add_ps(py, _mm_sub_ps(groundY, bottom));
+        __m128 vyG = _mm_mul_ps(_mm_xor_ps(vy, sign), _mm_loadu_ps(s.e + i));
+        __m128 vxG = _mm_mul_ps(vx, keep);
+        vyG = _mm_andnot_ps(_mm_cmplt_ps(_mm_andnot_ps(sign, vyG), one), vyG);
+        vxG = _mm_andnot_ps(_mm_cmplt_ps(_mm_andnot_ps(sign, vxG), one), vxG);
+
+        py = _mm_or_ps(_mm_and_ps(hit, pyG), _mm_andnot_ps(hit, py));
+        vy = _mm_or_ps(_mm_and_ps(hit, vyG), _mm_andnot_ps(hit, vy));
+        vx = _mm_or_ps(_mm_and_ps(hit, vxG), _mm_andnot_ps(hit, vx));
+
+        _mm_storeu_ps(s.vx + i, vx);
+        _mm_storeu_ps(s.vy + i, vy);
+        _mm_storeu_ps(s.px + i, px);
+        _mm_storeu_ps(s.py + i, py);
+        _mm_storeu_ps(s.minX + i, _mm_add_ps(px, _mm_loadu_ps(s.loX + i)));
+        _mm_storeu_ps(s.minY + i, _mm_add_ps(py, _mm_loadu_ps(s.loY + i)));
+        _mm_storeu_ps(s.maxX + i, _mm_add_ps(px, _mm_loadu_ps(s.hiX + i)));
+        _mm_storeu_ps(s.maxY + i, _mm_add_ps(py, hiY));
+    }
+    return i;
+}
+
+PHYSICS_TARGET_AVX2
+size_t integrateAvx2(const Streams& s, size_t begin, size_t end, const IntegrateParams& p) {
+    const __m256 dt = _mm256_set1_ps(p.dt);
+    const __m256 gdt = _mm256_set1_ps(p.gravity * p.dt);
+    const __m256 groundY = _mm256_set1_ps(p.groundY);
+    const __m256 keep = _mm256_set1_ps(1.f - p.groundFriction);
+    const __m256 one = _mm256_set1_ps(1.f);
+    const __m256 sign = _mm256_set1_ps(-0.f);
+
+    size_t i = begin;
+    for (; i + 8 <= end; i += 8) {
+        __m256 vy = _mm256_add_ps(_mm256_loadu_ps(s.vy + i), gdt);
+        __m256 vx = _mm256_loadu_ps(s.vx + i);
+        const __m256 px = _mm256_add_ps(_mm256_loadu_ps(s.px + i), _mm256_mul_ps(vx, dt));
+        __m256 py = _mm256_add_ps(_mm256_loadu_ps(s.py + i), _mm256_mul_ps(vy, dt));
+
+        const __m256 hiY = _mm256_loadu_ps(s.hiY + i);
+        const __m256 bottom = _mm256_add_ps(py, hiY);
+        const __m256 hit = _mm256_cmp_ps(bottom, groundY, _CMP_GE_OQ);
+
+        const __m256 pyG = _mm256_add_ps(py, _mm256_sub_ps(groundY, bottom));
+        __m256 vyG = _mm256_mul_ps(_mm256_xor_ps(vy, sign), _mm256_loadu_ps(s.e + i));
+        __m256 vxG = _mm256_mul_ps(vx, keep);
+        vyG = _mm256_andnot_ps(_mm256_cmp_ps(_mm256_andnot_ps(sign, vyG), one, _CMP_LT_OQ), vyG);
+        vxG = _mm256_andnot_ps(_mm256_cmp_ps(_mm256_andnot_ps(sign, vxG), one, _CMP_LT_OQ), vxG);
+
+        py = _mm256_blendv_ps(py, pyG, hit);
+        vy = _mm256_blendv_ps(vy, vyG, hit);
+        vx = _mm256_blendv_ps(vx, vxG, hit);
+
+        _mm256_storeu_ps(s.vx + i, vx);
+        _mm256_storeu_ps(s.vy + i, vy);
+        _mm256_storeu_ps(s.px + i, px);
+        _mm256_storeu_ps(s.py + i, py);
+        _mm256_storeu_ps(s.minX + i, _mm256_add_ps(px, _mm256_loadu_ps(s.loX + i)));
+        _mm256_storeu_ps(s.minY + i, _mm256_add_ps(py, _mm256_loadu_ps(s.loY + i)));
+        _mm256_storeu_ps(s.maxX + i, _mm256_add_ps(px, _mm256_loadu_ps(s.hiX + i)));
+        _mm256_storeu_ps(s.maxY + i, _mm256_add_ps(py, hiY));
+    }
+    return i;
+}
+
+bool cpuHasAvx2() {
+#if defined(_MSC_VER)
+    int info[4];
+    __cpuid(info, 0);
+    if (info[0] < 7) return false;
+    __cpuid(info, 1);
+    const bool osxsave = (info[2] & (1 << 27)) != 0;
+    const bool avx = (info[2] & (1 << 28)) != 0;
+    if (!osxsave || !avx) return false;
+    if ((_xgetbv(0) & 0x6) != 0x6) return false;
+    __cpuidex(info, 7, 0);
+    return (info[1] & (1 << 5)) != 0;
+#else
+    __builtin_cpu_init();
+    return __builtin_cpu_supports("avx2");
+#endif
+}
+#endif
+
+SimdLevel& activeLevel() {
+    static SimdLevel level = detectSimdLevel();
+    return level;
+}
+
+} // namespace
+
+SimdLevel detectSimdLevel() {
+#if defined(PHYSICS_X86)
+    if (cpuHasAvx2()) return SimdLevel::Avx2;
+    return SimdLevel::Sse2;
+#else
+    return SimdLevel::Scalar;
+#endif
+}
+
+SimdLevel getSimdLevel() {
+    return activeLevel();
+}
+
+void setSimdLevel(SimdLevel level) {
+    const SimdLevel best = detectSimdLevel();
+    activeLevel() = static_cast<int>(level) > static_cast<int>(best) ? best : level;
+}
+
+const char* simdLevelName(SimdLevel level) {
+    switch (level) {
+    case SimdLevel::Avx2: return "avx2";
+    case SimdLevel::Sse2: return "sse2";
+    case SimdLevel::Scalar:
+    default: return "scalar";
+    }
+}
+
+// Integrates an all-awake run with the widest available path
+static void integrateRun(const Streams& s, size_t begin, size_t end, const IntegrateParams& params) {
+    size_t i = begin;
+
+#if defined(PHYSICS_X86)
+    switch (activeLevel()) {
+    case SimdLevel::Avx2:
+        i = integrateAvx2(s, i, end, params);
+        i = integrateSse2(s, i, end, params);
+        break;
+    case SimdLevel::Sse2:
+        i = integrateSse2(s, i, end, params);
+        break;
+    case SimdLevel::Scalar:
+    default:
+        break;
+    }
+#endif
+
+    integrateScalar(s, i, end, params);
+}
+
+void integrateBodies(BodyStore& bodies, size_t begin, size_t end, const IntegrateParams& params) {
+    const Streams s(bodies);
+    const uint8_t* awake = bodies.awake.data();
+    const size_t block = 8;
+
+    size_t runStart = begin;
+    size_t i = begin;
+    for (; i + block <= end; i += block) {
+        size_t awakeCount = 0;
+        for (size_t k = 0; k < block; ++k) awakeCount += awake[i + k];
+        if (awakeCount == block) continue;
+
+        integrateRun(s, runStart, i, params);
+        runStart = i + block;
+        if (awakeCount == 0) continue;
+
+        for (size_t k = i; k < i + block; ++k)
+            if (awake[k]) integrateScalar(s, k, k + 1, params);
+    }
+    integrateRun(s, runStart, i, params);
+
+    for (; i < end; ++i)
+        if (awake[i]) integrateScalar(s, i, i + 1, params);
+}
+
+// --- Particles ---
+namespace {
+
+void particlesScalar(const ParticleStreams& s, size_t begin, size_t end, const ParticleParams& p) {
+    const float keep = 1.f - p.drag * p.dt;
+    const float gdt = p.gravity * p.dt;
+
+    for (size_t i = begin; i < end; ++i) {
+        const float vx = s.vx[i] * keep;
+        const float vy = s.vy[i] * keep + gdt;
+        s.vx[i] = vx;
+        s.vy[i] = vy;
+        s.px[i] = s.px[i] + vx * p.dt;
+        s.py[i] = s.py[i] + vy * p.dt;
+        s.life[i] = s.life[i] - p.dt;
+    }
+}
+
+#if defined(PHYSICS_X86)
+size_t particlesSse2(const ParticleStreams& s, size_t begin, size_t end, const ParticleParams& p) {
+    const __m128 dt = _mm_set1_ps(p.dt);
+    const __m128 keep = _mm_set1_ps(1.f - p.drag * p.dt);
+    const __m128 gdt = _mm_set1_ps(p.gravity * p.dt);
+
+    size_t i = begin;
+    for (; i + 4 <= end; i += 4) {
+        const __m128 vx = _mm_mul_ps(_mm_loadu_ps(s.vx + i), keep);
+        const __m128 vy = _mm_add_ps(_mm_mul_ps(_mm_loadu_ps(s.vy + i), keep), gdt);
+        _mm_storeu_ps(s.vx + i, vx);
+        _mm_storeu_ps(s.vy + i, vy);
+        _mm_storeu_ps(s.px + i, _mm_add_ps(_mm_loadu_ps(s.px + i), _mm_mul_ps(vx, dt)));
+        _mm_storeu_ps(s.py + i, _mm_add_ps(_mm_loadu_ps(s.py + i), _mm_mul_ps(vy, dt)));
+        _mm_storeu_ps(s.life + i, _mm_sub_ps(_mm_loadu_ps(s.life + i), dt));
+    }
+    return i;
+}
+
+PHYSICS_TARGET_AVX2
+size_t particlesAvx2(const ParticleStreams& s, size_t begin, size_t end, const ParticleParams& p) {
+    const __m256 dt = _mm256_set1_ps(p.dt);
+    const __m256 keep = _mm256_set1_ps(1.f - p.drag * p.dt);
+    const __m256 gdt = _mm256_set1_ps(p.gravity * p.dt);
+
+    size_t i = begin;
+    for (; i + 8 <= end; i += 8) {
+        const __m256 vx = _mm256_mul_ps(_mm256_loadu_ps(s.vx + i), keep);
+        const __m256 vy = _mm256_add_ps(_mm256_mul_ps(_mm256_loadu_ps(s.vy + i), keep), gdt);
+        _mm256_storeu_ps(s.vx + i, vx);
+        _mm256_storeu_ps(s.vy + i, vy);
+        _mm256_storeu_ps(s.px + i, _mm256_add_ps(_mm256_loadu_ps(s.px + i), _mm256_mul_ps(vx, dt)));
+        _mm256_storeu_ps(s.py + i, _mm256_add_ps(_mm256_loadu_ps(s.py + i), _mm256_mul_ps(vy, dt)));
+        _mm256_storeu_ps(s.life + i, _mm256_sub_ps(_mm256_loadu_ps(s.life + i), dt));
+    }
+    return i;
+}
+#endif
+
+} // namespace
+
+void integrateParticles(const ParticleStreams& streams, size_t count, const ParticleParams& params) {
+    size_t i = 0;
+
+#if defined(PHYSICS_X86)
+    switch (activeLevel()) {
+    case SimdLevel::Avx2:
+        i = particlesAvx2(streams, i, count, params);
+        i = particlesSse2(streams, i, count, params);
+        break;
+    case SimdLevel::Sse2:
+        i = particlesSse2(streams, i, count, params);
+        break;
+    case SimdLevel::Scalar:
+    default:
+        break;
+    }
+#endif
+
+    particlesScalar(streams, i, count, params);
+}
+
+// --- Ballistics ---
+namespace {
+
+// Per-call constants; y after n steps is py + n * (b + a * n) with
+// b = vy * dt + a
+struct BallisticTerms {
+    float gdt, a, a4, inv2a, keep;
+
+    explicit BallisticTerms(const BallisticParams& p)
+        : gdt(p.gravity * p.dt), a(0.5f * p.gravity * p.dt * p.dt), a4(4.f * a), inv2a(1.f / (2.f * a)),
+          keep(1.f - p.groundFriction) {}
+};
+
+// Moves flight i on by n steps and bounces it if that reaches the ground
+void landScalar(const BallisticStreams& s, size_t i, float n, float b, const BallisticTerms& t, const BallisticParams& p) {
+    const float vx = s.vx[i];
+    const float px = s.px[i] + n * (vx * p.dt);
+    float py = s.py[i] + n * (b + t.a * n);
+    float vy = s.vy[i] + n * t.gdt;
+    float vxN = vx;
+
+    const float low = py + s.bottom[i];
+    const bool hit = low >= p.groundY;
+    if (hit) {
+        py = py + (p.groundY - low);
+
+        vy = -vy * s.e[i];
+        vxN = vxN * t.keep;
+
+        if (std::abs(vy) < 1.f) vy = 0.f;
+        if (std::abs(vxN) < 1.f) vxN = 0.f;
+    }
+
+    s.px[i] = px;
+    s.py[i] = py;
+    s.vx[i] = vxN;
+    s.vy[i] = vy;
+    s.steps[i] = n;
+    s.landed[i] = hit ? 1.f : 0.f;
+}
+
+void ballisticScalar(const BallisticStreams& s, size_t begin, size_t end, const BallisticParams& p) {
+    const BallisticTerms t(p);
+
+    for (size_t i = begin; i < end; ++i) {
+        // First whole n >= 1 with py + n * (b + a * n) + bottom >= groundY
+        const float h = p.groundY - (s.py[i] + s.bottom[i]);
+        const float b = s.vy[i] * p.dt + t.a;
+        const float disc = b * b + t.a4 * h;
+        float nq = (std::sqrt(std::max(disc, 0.f)) - b) * t.inv2a;
+        nq = std::min(std::max(nq, 1.f), p.maxSteps);
+        landScalar(s, i, std::ceil(nq), b, t, p);
+    }
+}
+
+// Gravity <= 0: the ground may be reached along a line, between the two
+// roots of a concave quadratic, or never. Scalar only; nothing in the
+// engine predicts these in bulk.
+void ballisticWeightless(const BallisticStreams& s, size_t begin, size_t end, const BallisticParams& p) {
+    const BallisticTerms t(p);
+
+    for (size_t i = begin; i < end; ++i) {
+        const float h = p.groundY - (s.py[i] + s.bottom[i]);
+        const float b = s.vy[i] * p.dt + t.a;
+        float n = p.maxSteps;
+        if (t.a == 0.f) {
+            if (b > 0.f) n = std::ceil(std::max(h / b, 1.f));
+        } else {
+            const float disc = b * b + t.a4 * h;
+            if (disc >= 0.f) {
+                const float first = std::ceil(std::max((std::sqrt(disc) - b) * t.inv2a, 1.f));
+                const float last = (-std::sqrt(disc) - b) * t.inv2a;
+                if (first <= last) n = first;
+            }
+        }
+        landScalar(s, i, std::min(n, p.maxSteps), b, t, p);
+    }
+}
+
+#if defined(PHYSICS_X86)
+size_t ballisticSse2(const BallisticStreams& s, size_t begin, size_t end, const BallisticParams& p) {
+    const BallisticTerms t(p);
+    const __m128 dt = _mm_set1_ps(p.dt);
+    const __m128 gdt = _mm_set1_ps(t.gdt);
+    const __m128 a = _mm_set1_ps(t.a);
+    const __m128 a4 = _mm_set1_ps(t.a4);
+    const __m128 inv2a = _mm_set1_ps(t.inv2a);
+    const __m128 keep = _mm_set1_ps(t.keep);
+    const __m128 groundY = _mm_set1_ps(p.groundY);
+    const __m128 maxSteps = _mm_set1_ps(p.maxSteps);
+    const __m128 zero = _mm_setzero_ps();
+    const __m128 one = _mm_set1_ps(1.f);
+    const __m128 sign = _mm_set1_ps(-0.f);
+
+    size_t i = begin;
+    for (; i + 4 <= end; i += 4) {
+        const __m128 vx = _mm_loadu_ps(s.vx + i);
+        const __m128 vy = _mm_loadu_ps(s.vy + i);
+        const __m128 bottom = _mm_loadu_ps(s.bottom + i);
+        __m128 py = _mm_loadu_ps(s.py + i);
+
+        const __m128 h = _mm_sub_ps(groundY, _mm_add_ps(py, bottom));
+        const __m128 b = _mm_add_ps(_mm_mul_ps(vy, dt), a);
+        const __m128 disc = _mm_add_ps(_mm_mul_ps(b, b), _mm_mul_ps(a4, h));
+        __m128 nq = _mm_mul_ps(_mm_sub_ps(_mm_sqrt_ps(_mm_max_ps(disc, zero)), b), inv2a);
+        nq = _mm_min_ps(_mm_max_ps(nq, one), maxSteps);
+        // Ceiling of a value in [1, 2^24]: truncate, then step up if it was cut
+        const __m128 cut = _mm_cvtepi32_ps(_mm_cvttps_epi32(nq));
+        const __m128 n = _mm_add_ps(cut, _mm_and_ps(_mm_cmplt_ps(cut, nq), one));
+
+        const __m128 px = _mm_add_ps(_mm_loadu_ps(s.px + i), _mm_mul_ps(n, _mm_mul_ps(vx, dt)));
+        py = _mm_add_ps(py, _mm_mul_ps(n, _mm_add_ps(b, _mm_mul_ps(a, n))));
+        __m128 vyN = _mm_add_ps(vy, _mm_mul_ps(n, gdt));
+        __m128 vxN = vx;
+
+        const __m128 low = _mm_add_ps(py, bottom);
+        const __m128 hit = _mm_cmpge_ps(low, groundY);
+
+        const __m128 pyG = _mm_add_ps(py, _mm_sub_ps(groundY, low));
+        __m128 vyG = _mm_mul_ps(_mm_xor_ps(vyN, sign), _mm_loadu_ps(s.e + i));
+        __m128 vxG = _mm_mul_ps(vxN, keep);
+        vyG = _mm_andnot_ps(_mm_cmplt_ps(_mm_andnot_ps(sign, vyG), one), vyG);
+        vxG = _mm_andnot_ps(_mm_cmplt_ps(_mm_andnot_ps(sign, vxG), one), vxG);
+
+        py = _mm_or_ps(_mm_and_ps(hit, pyG), _mm_andnot_ps(hit, py));
+        vyN = _mm_or_ps(_mm_and_ps(hit, vyG), _mm_andnot_ps(hit, vyN));
+        vxN = _mm_or_ps(_mm_and_ps(hit, vxG), _mm_andnot_ps(hit, vxN));
+
+        _mm_storeu_ps(s.px + i, px);
+        _mm_storeu_ps(s.py + i, py);
+        _mm_storeu_ps(s.vx + i, vxN);
+        _mm_storeu_ps(s.vy + i, vyN);
+        _mm_storeu_ps(s.steps + i, n);
+        _mm_storeu_ps(s.landed + i, _mm_and_ps(hit, one));
+    }
+    return i;
+}
+
+PHYSICS_TARGET_AVX2
+size_t ballisticAvx2(const BallisticStreams& s, size_t begin, size_t end, const BallisticParams& p) {
+    const BallisticTerms t(p);
+    const __m256 dt = _mm256_set1_ps(p.dt);
+    const __m256 gdt = _mm256_set1_ps(t.gdt);
+    const __m256 a = _mm256_set1_ps(t.a);
+    const __m256 a4 = _mm256_set1_ps(t.a4);
+    const __m256 inv2a = _mm256_set1_ps(t.inv2a);
+    const __m256 keep = _mm256_set1_ps(t.keep);
+    const __m256 groundY = _mm256_set1_ps(p.groundY);
+    const __m256 maxSteps = _mm256_set1_ps(p.maxSteps);
+    const __m256 zero = _mm256_setzero_ps();
+    const __m256 one = _mm256_set1_ps(1.f);
+    const __m256 sign = _mm256_set1_ps(-0.f);
+
+    size_t i = begin;
+    for (; i + 8 <= end; i += 8) {
+        const __m256 vx = _mm256_loadu_ps(s.vx + i);
+        const __m256 vy = _mm256_loadu_ps(s.vy + i);
+        const __m256 bottom = _mm256_loadu_ps(s.bottom + i);
+        __m256 py = _mm256_loadu_ps(s.py + i);
+
+        const __m256 h = _mm256_sub_ps(groundY, _mm256_add_ps(py, bottom));
+        const __m256 b = _mm256_add_ps(_mm256_mul_ps(vy, dt), a);
+        const __m256 disc = _mm256_add_ps(_mm256_mul_ps(b, b), _mm256_mul_ps(a4, h));
+        __m256 nq = _mm256_mul_ps(_mm256_sub_ps(_mm256_sqrt_ps(_mm256_max_ps(disc, zero)), b), inv2a);
+        nq = _mm256_min_ps(_mm256_max_ps(nq, one), maxSteps);
+        const __m256 n = _mm256_ceil_ps(nq);
+
+        const __m256 px = _mm256_add_ps(_mm256_loadu_ps(s.px + i), _mm256_mul_ps(n, _mm256_mul_ps(vx, dt)));
+        py = _mm256_add_ps(py, _mm256_mul_ps(n, _mm256_add_ps(b, _mm256_mul_ps(a, n))));
+        __m256 vyN = _mm256_add_ps(vy, _mm256_mul_ps(n, gdt));
+        __m256 vxN = vx;
+
+        const __m256 low = _mm256_add_ps(py, bottom);
+        const __m256 hit = _mm256_cmp_ps(low, groundY, _CMP_GE_OQ);
+
+        const __m256 pyG = _mm256_add_ps(py, _mm256_sub_ps(groundY, low));
+        __m256 vyG = _mm256_mul_ps(_mm256_xor_ps(vyN, sign), _mm256_loadu_ps(s.e + i));
+        __m256 vxG = _mm256_mul_ps(vxN, keep);
+        vyG = _mm256_andnot_ps(_mm256_cmp_ps(_mm256_andnot_ps(sign, vyG), one, _CMP_LT_OQ), vyG);
+        vxG = _mm256_andnot_ps(_mm256_cmp_ps(_mm256_andnot_ps(sign, vxG), one, _CMP_LT_OQ), vxG);
+
+        py = _mm256_blendv_ps(py, pyG, hit);
+        vyN = _mm256_blendv_ps(vyN, vyG, hit);
+        vxN = _mm256_blendv_ps(vxN, vxG, hit);
+
+        _mm256_storeu_ps(s.px + i, px);
+        _mm256_storeu_ps(s.py + i, py);
+        _mm256_storeu_ps(s.vx + i, vxN);
+        _mm256_storeu_ps(s.vy + i, vyN);
+        _mm256_storeu_ps(s.steps + i, n);
+        _mm256_storeu_ps(s.landed + i, _mm256_and_ps(hit, one));
+    }
+    return i;
+}
+#endif
+
+} // namespace
+
+void advanceBallistic(const BallisticStreams& streams, size_t count, const BallisticParams& params) {
+    if (!(params.gravity > 0.f) || !(params.dt > 0.f)) {
+        ballisticWeightless(streams, 0, count, params);
+        return;
+    }
+
+    size_t i = 0;
+
+#if defined(PHYSICS_X86)
+    switch (activeLevel()) {
+    case SimdLevel::Avx2:
+        i = ballisticAvx2(streams, i, count, params);
+        i = ballisticSse2(streams, i, count, params);
+        break;
+    case SimdLevel::Sse2:
+        i = ballisticSse2(streams, i, count, params);
+        break;
+    case SimdLevel::Scalar:
+    default:
+        break;
+    }
+#endif
+
+    ballisticScalar(streams, i, count, params);
+}
+
+// --- Joint rows ---
+namespace {
+
+// v = clamp(v, lo, hi) written as _mm_max_ps / _mm_min_ps evaluate it, so
+// the paths agree on ties
+inline float clampRow(float v, float lo, float hi) {
+    v = v > lo ? v : lo;
+    return v < hi ? v : hi;
+}
+
+float jointRowsScalar(const JointRowStreams& s, size_t begin, size_t end) {
+    float change = 0.f;
+    for (size_t i = begin; i < end; ++i) {
+        const uint32_t a = s.a[i], b = s.b[i];
+        const float ia = s.invMass[a], ib = s.invMass[b];
+        const float cdot = (s.vx[b] - s.vx[a]) * s.nx[i] + (s.vy[b] - s.vy[a]) * s.ny[i];
+
+        const float old = s.impulse[i];
+        const float acc = clampRow(old - s.mass[i] * (cdot + s.bias[i] + s.gamma[i] * old), s.lower[i], s.upper[i]);
+        const float j = acc - old;
+        s.impulse[i] = acc;
+
+        const float jx = j * s.nx[i], jy = j * s.ny[i];
+        const float ax = s.vx[a] - ia * jx, ay = s.vy[a] - ia * jy;
+        const float bx = s.vx[b] + ib * jx, by = s.vy[b] + ib * jy;
+        if (a) { s.vx[a] = ax; s.vy[a] = ay; }
+        if (b) { s.vx[b] = bx; s.vy[b] = by; }
+        change = std::max(change, std::abs(j) * (ia + ib));
+    }
+    return change;
+}
+
+#if defined(PHYSICS_X86)
+// Lanes hold distinct bodies, so the new velocities go back one by one
+template <size_t Lanes>
+inline void scatterRows(const JointRowStreams& s, size_t i, const float* ax, const float* ay, const float* bx, const float* by) {
+    for (size_t k = 0; k < Lanes; ++k) {
+        const uint32_t a = s.a[i + k], b = s.b[i + k];
+        if (a) { s.vx[a] = ax[k]; s.vy[a] = ay[k]; }
+        if (b) { s.vx[b] = bx[k]; s.vy[b] = by[k]; }
+    }
+}
+
+size_t jointRowsSse2(const JointRowStreams& s, size_t begin, size_t end, float& change) {
+    const __m128 sign = _mm_set1_ps(-0.f);
+    __m128 maxChange = _mm_set1_ps(change);
+    alignas(16) float ax[4], ay[4], bx[4], by[4];
+
+    size_t i = begin;
+    for (; i + 4 <= end; i += 4) {
+        const uint32_t* a = s.a + i;
+        const uint32_t* b = s.b + i;
+        const __m128 vax = _mm_setr_ps(s.vx[a[0]], s.vx[a[1]], s.vx[a[2]], s.vx[a[3]]);
+        const __m128 vay = _mm_setr_ps(s.vy[a[0]], s.vy[a[1]], s.vy[a[2]], s.vy[a[3]]);
+        const __m128 vbx = _mm_setr_ps(s.vx[b[0]], s.vx[b[1]], s.vx[b[2]], s.vx[b[3]]);
+        const __m128 vby = _mm_setr_ps(s.vy[b[0]], s.vy[b[1]], s.vy[b[2]], s.vy[b[3]]);
+        const __m128 ia = _mm_setr_ps(s.invMass[a[0]], s.invMass[a[1]], s.invMass[a[2]], s.invMass[a[3]]);
+        const __m128 ib = _mm_setr_ps(s.invMass[b[0]], s.invMass[b[1]], s.invMass[b[2]], s.invMass[b[3]]);
+        const __m128 nx = _mm_loadu_ps(s.nx + i);
+        const __m128 ny = _mm_loadu_ps(s.ny + i);
+
+        const __m128 cdot = _mm_add_ps(_mm_mul_ps(_mm_sub_ps(vbx, vax), nx), _mm_mul_ps(_mm_sub_ps(vby, vay), ny));
+        const __m128 old = _mm_loadu_ps(s.impulse + i);
+        const __m128 target = _mm_add_ps(_mm_add_ps(cdot, _mm_loadu_ps(s.bias + i)), _mm_mul_ps(_mm_loadu_ps(s.gamma + i), old));
+        __m128 acc = _mm_sub_ps(old, _mm_mul_ps(_mm_loadu_ps(s.mass + i), target));
+        acc = _mm_min_ps(_mm_max_ps(acc, _mm_loadu_ps(s.lower + i)), _mm_loadu_ps(s.upper + i));
+        const __m128 j = _mm_sub_ps(acc, old);
+        _mm_storeu_ps(s.impulse + i, acc);
+
+        const __m128 jx = _mm_mul_ps(j, nx), jy = _mm_mul_ps(j, ny);
+        _mm_store_ps(ax, _mm_sub_ps(vax, _mm_mul_ps(ia, jx)));
+        _mm_store_ps(ay, _mm_sub_ps(vay, _mm_mul_ps(ia, jy)));
+        _mm_store_ps(bx, _mm_add_ps(vbx, _mm_mul_ps(ib, jx)));
+        _mm_store_ps(by, _mm_add_ps(vby, _mm_mul_ps(ib, jy)));
+        scatterRows<4>(s, i, ax, ay, bx, by);
+        maxChange = _mm_max_ps(maxChange, _mm_mul_ps(_mm_andnot_ps(sign, j), _mm_add_ps(ia, ib)));
+    }
+
+    alignas(16) float lanes[4];
+    _mm_store_ps(lanes, maxChange);
+    change = std::max({ lanes[0], lanes[1], lanes[2], lanes[3] });
+    return i;
+}
+
+PHYSICS_TARGET_AVX2
+size_t jointRowsAvx2(const JointRowStreams& s, size_t begin, size_t end, float& change) {
+    const __m256 sign = _mm256_set1_ps(-0.f);
+    __m256 maxChange = _mm256_set1_ps(change);
+    alignas(32) float ax[8], ay[8], bx[8], by[8];
+
+    size_t i = begin;
+    for (; i + 8 <= end; i += 8) {
+        const __m256i a = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(s.a + i));
+        const __m256i b = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(s.b + i));
+        const __m256 vax = _mm256_i32gather_ps(s.vx, a, 4);
+        const __m256 vay = _mm256_i32gather_ps(s.vy, a, 4);
+        const __m256 vbx = _mm256_i32gather_ps(s.vx, b, 4);
+        const __m256 vby = _mm256_i32gather_ps(s.vy, b, 4);
+        const __m256 ia = _mm256_i32gather_ps(s.invMass, a, 4);
+        const __m256 ib = _mm256_i32gather_ps(s.invMass, b, 4);
+        const __m256 nx = _mm256_loadu_ps(s.nx + i);
+        const __m256 ny = _mm256_loadu_ps(s.ny + i);
+
+        const __m256 cdot = _mm256_add_ps(_mm256_mul_ps(_mm256_sub_ps(vbx, vax), nx), _mm256_mul_ps(_mm256_sub_ps(vby, vay), ny));
+        const __m256 old = _mm256_loadu_ps(s.impulse + i);
+        const __m256 target = _mm256_add_ps(_mm256_add_ps(cdot, _mm256_loadu_ps(s.bias + i)), _mm256_mul_ps(_mm256_loadu_ps(s.gamma + i), old));
+        __m256 acc = _mm256_sub_ps(old, _mm256_mul_ps(_mm256_loadu_ps(s.mass + i), target));
+        acc = _mm256_min_ps(_mm256_max_ps(acc, _mm256_loadu_ps(s.lower + i)), _mm256_loadu_ps(s.upper + i));
+        const __m256 j = _mm256_sub_ps(acc, old);
+        _mm256_storeu_ps(s.impulse + i, acc);
+
+        const __m256 jx = _mm256_mul_ps(j, nx), jy = _mm256_mul_ps(j, ny);
+        _mm256_store_ps(ax, _mm256_sub_ps(vax, _mm256_mul_ps(ia, jx)));
+        _mm256_store_ps(ay, _mm256_sub_ps(vay, _mm256_mul_ps(ia, jy)));
+        _mm256_store_ps(bx, _mm256_add_ps(vbx, _mm256_mul_ps(ib, jx)));
+        _mm256_store_ps(by, _mm256_add_ps(vby, _mm256_mul_ps(ib, jy)));
+        scatterRows<8>(s, i, ax, ay, bx, by);
+        maxChange = _mm256_max_ps(maxChange, _mm256_mul_ps(_mm256_andnot_ps(sign, j), _mm256_add_ps(ia, ib)));
+    }
+
+    alignas(32) float lanes[8];
+    _mm256_store_ps(lanes, maxChange);
+    for (float lane : lanes) change = std::max(change, lane);
+    return i;
+}
+#endif
+
+} // namespace
+
+float solveJointRows(const JointRowStreams& streams, size_t begin, size_t end) {
+    float change = 0.f;
+    size_t i = begin;
+
+#if defined(PHYSICS_X86)
+    switch (activeLevel()) {
+    case SimdLevel::Avx2:
+        i = jointRowsAvx2(streams, i, end, change);
+        i = jointRowsSse2(streams, i, end, change);
+        break;
+    case SimdLevel::Sse2:
+        i = jointRowsSse2(streams, i, end, change);
+        break;
+    case SimdLevel::Scalar:
+    default:
+        break;
+    }
+#endif
+
+    return std::max(change, jointRowsScalar(streams, i, end));
+}
@@ -0,0 +1,92 @@
+#pragma once
+#include "BodyStore.hpp"
+
+// ---------------------
+// Vectorised per-body kernels. The SSE2 (4 bodies) and AVX2 (8 bodies)
+// paths do the same float operations in the same order as the scalar
+// path, so all three give bit-identical results. The widest path the CPU
+// supports is picked at startup.
+// ---------------------
+
+enum class SimdLevel { Scalar, Sse2, Avx2 };
+
+struct IntegrateParams {
+    float dt = 0.f;
+    float gravity = 0.f;
+    float groundY = 0.f;
+    float groundFriction = 0.f;
+};
+
+// Gravity, position update, ground clamp/bounce/friction, rest snapping
+// and bounds refresh for the awake bodies in [begin, end). Runs of fully
+// awake 8-body blocks go through the vector path, fully asleep blocks are
+// skipped and mixed blocks are done body by body.
+void integrateBodies(BodyStore& bodies, size_t begin, size_t end, const IntegrateParams& params);
+
+struct ParticleStreams {
+    float* px; float* py;
+    float* vx; float* vy;
+    float* life;
+};
+
+struct ParticleParams {
+    float dt = 0.f;
+    float gravity = 0.f;
+    float drag = 0.f;      // fraction of velocity lost per second
+};
+
+// Ballistic update of particles [0, count): drag, gravity, position and
+// remaining lifetime. Same SIMD selection as integrateBodies.
+void integrateParticles(const ParticleStreams& streams, size_t count, const ParticleParams& params);
+
+struct BallisticStreams {
+    float* px; float* py;     // flight start in; ground contact (or where the flight stopped) out
+    float* vx; float* vy;     // velocity at the start in; after the bounce out
+    float* steps;             // out: steps the flight took
+    float* landed;            // out: 1 if it ended on the ground, 0 if maxSteps ran out first
+    const float* e;           // restitution
+    const float* bottom;      // from the position down to the bottom of the bounds
+};
+
+struct BallisticParams {
+    float dt = 0.f;
+    float gravity = 0.f;
+    float groundY = 0.f;
+    float groundFriction = 0.f;
+    float maxSteps = 0.f;     // at most 2^24
+};
+
+// One flight of each launch [0, count) in closed form: the step at which
+// integrateBodies' update first puts the body on the ground, its position
+// there and its velocity after the bounce, friction and rest snapping.
+// With semi-implicit Euler, y after n steps is y + n*vy*dt + g*dt^2*n(n+1)/2,
+// so the step is the ceiling of a quadratic's root. Same SIMD selection
+// as integrateBodies.
+void advanceBallistic(const BallisticStreams& streams, size_t count, const BallisticParams& params);
+
+struct JointRowStreams {
+    float* vx; float* vy;     // by solver body; body 0 is the world and is never written
+    const float* invMass;     // by solver body, 0 for the world, sleepers and static bodies
+    const uint32_t* a;        // the row's two solver bodies
+    const uint32_t* b;
+    const float* nx; const float* ny;   // unit direction, from a towards b
+    const float* mass;        // effective mass, softened for springs; 0 = inactive
+    const float* bias;        // velocity target
+    const float* gamma;       // softness (springs), 0 for rigid rows
+    const float* lower;       // bounds of the accumulated impulse
+    const float* upper;
+    float* impulse;           // accumulated, in and out
+};
+
+// One sequential-impulse pass over the joint rows [begin, end). Rows in
+// one call must not share a solver body other than the world, so lanes
+// can gather and scatter velocities freely (graph-coloured batches).
+// Returns the largest velocity change it made. Same SIMD selection as
+// integrateBodies.
+float solveJointRows(const JointRowStreams& streams, size_t begin, size_t end);
+
+SimdLevel detectSimdLevel();
+SimdLevel getSimdLevel();
+// Forces a path (clamped to what the CPU supports), e.g. to compare them
+void setSimdLevel(SimdLevel level);
+const char* simdLevelName(SimdLevel level);
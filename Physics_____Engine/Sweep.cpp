@@ -0,0 +1,235 @@
+#include "Sweep.hpp"
+#include "Triggers.hpp"
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+
+namespace {
+    constexpr float degrees = 180.f / 3.14159265f;
+    // A body this close to the ground line counts as touching it
+    constexpr float groundContact = 0.5f;
+
+    struct Launch {
+        float values[4];    // by SweepField
+    };
+
+    // splitmix64: a full-period generator whose every state is a good seed,
+    // so (seed, run) can be mixed straight into one
+    uint64_t nextRandom(uint64_t& state) {
+        uint64_t z = (state += 0x9E3779B97F4A7C15ull);
+        z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+        z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+        return z ^ (z >> 31);
+    }
+
+    Launch launchFor(const SweepSpec& spec, const Launch& scene, uint64_t run) {
+        Launch launch = scene;
+        if (spec.samples) {
+            uint64_t state = spec.seed ^ (run * 0xD1B54A32D192ED03ull);
+            for (const SweepAxis& a : spec.axes) {
+                const float u = static_cast<float>(nextRandom(state) >> 40) * (1.f / 16777216.f);
+                launch.values[static_cast<size_t>(a.field)] = a.min + (a.max - a.min) * u;
+            }
+        }
+        else {
+            for (size_t k = spec.axes.size(); k-- > 0;) {
+                const SweepAxis& a = spec.axes[k];
+                const uint64_t step = run % a.count;
+                run /= a.count;
+                const float t = a.count > 1 ? static_cast<float>(step) / static_cast<float>(a.count - 1) : 0.f;
+                launch.values[static_cast<size_t>(a.field)] = a.min + (a.max - a.min) * t;
+            }
+        }
+        return launch;
+    }
+
+    // One run on its own copy of the world
+    SweepResult simulate(const World& base, const TriggerSet& baseTriggers, const SweepSpec& spec,
+                         const Launch& launch, uint64_t run) {
+        World world(base);
+        world.setThreadPool(nullptr);
+        TriggerSet triggers(baseTriggers);
+        std::vector<TriggerEvent> events;
+
+        SweepResult r;
+        r.run = run;
+        r.speed = launch.values[static_cast<size_t>(SweepField::Speed)];
+        r.angle = launch.values[static_cast<size_t>(SweepField::Angle)];
+        r.mass = std::max(0.01f, launch.values[static_cast<size_t>(SweepField::Mass)]);
+        r.elasticity = std::clamp(launch.values[static_cast<size_t>(SweepField::Elasticity)], 0.f, 1.f);
+
+        const size_t i = spec.body;
+        const BodyHandle launched = world.getHandle(i);
+        Body body = world.getBody(i);
+        body.velocity = { r.speed * std::cos(r.angle / degrees), -r.speed * std::sin(r.angle / degrees) };
+        body.mass = r.mass;
+        body.elasticity = r.elasticity;
+        world.setBody(i, body);
+
+        const BodyStore& b = world.getStore();
+        const float ground = world.getGroundY() - groundContact;
+        float time = 0.f;
+        for (uint32_t s = 0; s < spec.maxSteps; ++s) {
+            world.step(spec.dt);
+            events.clear();
+            triggers.detect(world, time, spec.dt, events);
+            time += spec.dt;
+
+            for (const TriggerEvent& e : events) {
+                if (e.body != launched) continue;
+                if (r.crossings++ == 0) r.firstCrossingTime = e.time;
+            }
+            if (r.landingTime < 0.f && b.maxY[i] >= ground) {
+                r.landingX = b.posX[i];
+                r.landingTime = time;
+            }
+            if (!world.isAwake(i)) {
+                r.restTime = time;
+                break;
+            }
+        }
+        r.restX = b.posX[i];
+        return r;
+    }
+}
+
+size_t getSweepRunCount(const SweepSpec& spec) {
+    if (spec.samples) return spec.samples;
+    if (spec.axes.empty()) return 0;
+    size_t runs = 1;
+    for (const SweepAxis& a : spec.axes) {
+        if (a.count == 0 || runs > SIZE_MAX / a.count) return 0;
+        runs *= a.count;
+    }
+    return runs;
+}
+
+bool runSweep(const World& base, const std::vector<SceneLine>& lines, const SweepSpec& spec, ThreadPool* pool,
+              const SweepSink& sink, std::string& error) {
+    if (spec.body >= base.size()) {
+        error = "sweep body " + std::to_string(spec.body) + " not in the scene (" + std::to_string(base.size()) + " bodies)";
+        return false;
+    }
+    if (!(spec.dt > 0.f) || spec.maxSteps == 0) {
+        error = "sweep needs a positive step and step limit";
+        return false;
+    }
+    const size_t runs = getSweepRunCount(spec);
+    if (runs == 0) {
+        error = "empty sweep: give at least one axis with a nonzero count";
+        return false;
+    }
+
+    // The scene's own launch, for the fields not swept
+    const Body body = base.getBody(spec.body);
+    Launch scene;
+    const float speed = std::hypot(body.velocity.x, body.velocity.y);
+    scene.values[static_cast<size_t>(SweepField::Speed)] = speed;
+    scene.values[static_cast<size_t>(SweepField::Angle)] = speed > 0.f ? std::atan2(-body.velocity.y, body.velocity.x) * degrees : 0.f;
+    scene.values[static_cast<size_t>(SweepField::Mass)] = body.mass;
+    scene.values[static_cast<size_t>(SweepField::Elasticity)] = body.elasticity;
+
+    // Lines are binned on first use; do it here, once, so the runs' copies
+    // start with the grid built
+    TriggerSet triggers;
+    for (const SceneLine& l : lines) triggers.add(l.start, l.end);
+    triggers.queryRect(sf::FloatRect(0.f, 0.f, 0.f, 0.f), [](uint32_t) { return false; });
+
+    std::vector<SweepResult> batch;
+    for (size_t first = 0; first < runs; first += sweepBatchRuns) {
+        batch.resize(std::min(sweepBatchRuns, runs - first));
+        const std::function<void(size_t)> task = [&](size_t k) {
+            const uint64_t run = first + k;
+            batch[k] = simulate(base, triggers, spec, launchFor(spec, scene, run), run);
+        };
+        if (pool) {
+            pool->parallelFor(batch.size(), task);
+        }
+        else {
+            for (size_t k = 0; k < batch.size(); ++k) task(k);
+        }
+        if (!sink(batch, error)) return false;
+    }
+    return true;
+}
+
+bool parseSweepField(const std::string& name, SweepField& field) {
+    for (SweepField f : { SweepField::Speed, SweepField::Angle, SweepField::Mass, SweepField::Elasticity }) {
+        if (name == sweepFieldName(f)) {
+            field = f;
+            return true;
+        }
+    }
+    return false;
+}
+
+const char* sweepFieldName(SweepField field) {
+    switch (field) {
+    case SweepField::Angle: return "angle";
+    case SweepField::Mass: return "mass";
+    case SweepField::Elasticity: return "elasticity";
+    case SweepField::Speed:
+    default: return "speed";
+    }
+}
+
+// --- Output ---
+bool SweepWriter::open(const std::string& filePath, std::string& error) {
+    path = filePath;
+    binary = path.size() >= 7 && path.compare(path.size() - 7, 7, ".psweep") == 0;
+    file.open(path, binary ? std::ios::binary : std::ios::out);
+    if (!file) {
+        error = "cannot write " + path;
+        return false;
+    }
+
+    if (binary) {
+        SweepFileHeader header{};
+        std::memcpy(header.magic, "PHYSWEEP", 8);
+        header.version = version;
+        header.headerSize = sizeof(SweepFileHeader);
+        header.recordSize = sizeof(SweepResult);
+        file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    }
+    else {
+        file << "run,speed,angle,mass,elasticity,landing_x,landing_time,rest_x,rest_time,crossings,first_crossing_time\n";
+    }
+    if (!file) {
+        error = "write failed: " + path;
+        return false;
+    }
+    return true;
+}
+
+bool SweepWriter::write(const std::vector<SweepResult>& batch, std::string& error) {
+    if (binary) {
+        file.write(reinterpret_cast<const char*>(batch.data()), static_cast<std::streamsize>(batch.size() * sizeof(SweepResult)));
+    }
+    else {
+        std::string text;
+        char line[256];
+        for (const SweepResult& r : batch) {
+            std::snprintf(line, sizeof(line), "%llu,%g,%g,%g,%g,%.3f,%.4f,%.3f,%.4f,%u,%.4f\n",
+                          static_cast<unsigned long long>(r.run), r.speed, r.angle, r.mass, r.elasticity,
+                          r.landingX, r.landingTime, r.restX, r.restTime, r.crossings, r.firstCrossingTime);
+            text += line;
+        }
+        file << text;
+    }
+    if (!file) {
+        error = "write failed: " + path;
+        return false;
+    }
+    return true;
+}
+
+bool SweepWriter::close(std::string& error) {
+    if (!file.is_open()) return true;
+    file.close();
+    if (!file) {
+        error = "write failed: " + path;
+        return false;
+    }
+    return true;
+}
@@ -0,0 +1,104 @@
+#pragma once
+#include "World.hpp"
+#include "Scene.hpp"
+#include "ThreadPool.hpp"
+#include <cstdint>
+#include <fstream>
+#include <functional>
+#include <string>
+#include <vector>
+
+// A launch parameter of the swept body
+enum class SweepField : uint32_t { Speed, Angle, Mass, Elasticity };
+
+// The range one field is swept over: 'count' evenly spaced values from
+// min to max (both included) in a grid, uniform draws from [min, max] in
+// a Monte Carlo sweep
+struct SweepAxis {
+    SweepField field = SweepField::Speed;
+    float min = 0.f;
+    float max = 0.f;
+    uint32_t count = 1;
+};
+
+struct SweepSpec {
+    size_t body = 0;                 // launched in every run
+    std::vector<SweepAxis> axes;     // fields not listed keep the scene's values
+    size_t samples = 0;              // 0 = every grid point; else this many random runs
+    uint64_t seed = 1;
+    float dt = 1.f / 60.f;
+    uint32_t maxSteps = 3600;        // a run still moving by then stops there
+};
+
+// One run's launch and outcome. Speed and angle (degrees, up from the
+// +x axis, as in the velocity popup) give the launch velocity.
+struct SweepResult {
+    uint64_t run = 0;
+    float speed = 0.f;
+    float angle = 0.f;
+    float mass = 0.f;
+    float elasticity = 0.f;
+    float landingX = 0.f;            // at the first ground contact
+    float landingTime = -1.f;        // seconds, -1 if it never touched the ground
+    float restX = 0.f;               // where it fell asleep, or where it was at maxSteps
+    float restTime = -1.f;           // seconds, -1 if still awake at maxSteps
+    uint32_t crossings = 0;          // trigger line events of the launched body
+    float firstCrossingTime = -1.f;
+};
+static_assert(sizeof(SweepResult) == 48, "sweep record layout changed");
+
+// ---------------------
+// Parameter sweeps and Monte Carlo runs of one scene.
+//
+// Every run is an independent copy of the base world with the swept body
+// relaunched, stepped on its own until that body falls asleep (so scenes
+// with sleep off always run maxSteps). Runs go to the pool one world per
+// task and only read the base world, so they share no mutable state and
+// scale with the pool's threads. Results are handed over in run order,
+// sweepBatchRuns at a time, so output streams in bounded memory.
+//
+// Grid runs enumerate the axes like nested loops, the last axis fastest.
+// Random runs draw from a generator seeded by (seed, run), so a run's
+// values do not depend on the thread count or on which runs come before.
+// ---------------------
+using SweepSink = std::function<bool(const std::vector<SweepResult>& batch, std::string& error)>;
+
+constexpr size_t sweepBatchRuns = 1024;
+
+size_t getSweepRunCount(const SweepSpec& spec);
+
+// False with 'error' if the spec does not fit the scene or 'sink' fails.
+// A null pool runs everything on the calling thread.
+bool runSweep(const World& base, const std::vector<SceneLine>& lines, const SweepSpec& spec, ThreadPool* pool,
+              const SweepSink& sink, std::string& error);
+
+bool parseSweepField(const std::string& name, SweepField& field);
+const char* sweepFieldName(SweepField field);
+
+// ---------------------
+// Sweep result files: binary (.psweep) for a path ending in .psweep, CSV
+// with a header row otherwise. Binary files are a SweepFileHeader and
+// then SweepResult records as laid out above, little-endian.
+// ---------------------
+struct SweepFileHeader {
+    char magic[8];                 // "PHYSWEEP"
+    uint32_t version;
+    uint32_t headerSize;
+    uint32_t recordSize;
+    uint32_t reserved;
+};
+static_assert(sizeof(SweepFileHeader) == 24, "sweep header layout changed");
+
+class SweepWriter {
+public:
+    bool open(const std::string& path, std::string& error);
+    bool write(const std::vector<SweepResult>& batch, std::string& error);
+    bool close(std::string& error);
+
+    static constexpr uint32_t version = 1;
+
+private:
+    std::ofstream file;
+    std::string path;
+    bool binary = false;
+};
@@ -0,0 +1,99 @@
+#include "ThreadPool.hpp"
+#include "Profiler.hpp"
+#include <algorithm>
+
+ThreadPool::ThreadPool(unsigned threads) {
+    if (threads == 0) threads = std::max(1u, std::thread::hardware_concurrency());
+
+    // The calling thread is the last participant and uses no queue of its own
+    for (unsigned i = 1; i < threads; ++i)
+        queues.push_back(std::make_unique<Queue>());
+    for (size_t i = 0; i < queues.size(); ++i)
+        workers.emplace_back([this, i]() { workerLoop(i); });
+}
+
+ThreadPool::~ThreadPool() {
+    {
+        std::lock_guard<std::mutex> lock(wakeMutex);
+        stopping = true;
+    }
+    wake.notify_all();
+    for (auto& w : workers) w.join();
+}
+
+bool ThreadPool::popLocal(size_t queue, Job& job) {
+    Queue& q = *queues[queue];
+    std::lock_guard<std::mutex> lock(q.mutex);
+    if (q.jobs.empty()) return false;
+    job = q.jobs.back();
+    q.jobs.pop_back();
+    return true;
+}
+
+bool ThreadPool::steal(size_t thief, Job& job) {
+    const size_t n = queues.size();
+    for (size_t k = 1; k <= n; ++k) {
+        Queue& q = *queues[(thief + k) % n];
+        std::lock_guard<std::mutex> lock(q.mutex);
+        if (q.jobs.empty()) continue;
+        job = q.jobs.front();
+        q.jobs.pop_front();
+        return true;
+    }
+    return false;
+}
+
+bool ThreadPool::findWork(size_t self, Job& job) {
+    const bool found = (self < queues.size() && popLocal(self, job)) || steal(self, job);
+    if (found) pending.fetch_sub(1, std::memory_order_relaxed);
+    return found;
+}
+
+void ThreadPool::run(Job& job) {
+    (*job.task)(job.index);
+    job.remaining->fetch_sub(1, std::memory_order_acq_rel);
+}
+
+void ThreadPool::workerLoop(size_t self) {
+    Profiler::setThreadName("pool worker");
+    for (;;) {
+        Job job;
+        if (findWork(self, job)) {
+            run(job);
+            continue;
+        }
+
+        std::unique_lock<std::mutex> lock(wakeMutex);
+        wake.wait(lock, [this]() { return stopping || pending.load(std::memory_order_relaxed) > 0; });
+        if (stopping) return;
+    }
+}
+
+void ThreadPool::parallelFor(size_t count, const std::function<void(size_t)>& task) {
+    if (count == 0) return;
+    if (queues.empty() || count == 1) {
+        for (size_t i = 0; i < count; ++i) task(i);
+        return;
+    }
+
+    // Deal the tasks out round-robin, then let stealing even things out
+    std::atomic<size_t> remaining{ count };
+    {
+        std::lock_guard<std::mutex> lock(wakeMutex);
+        pending.fetch_add(count, std::memory_order_relaxed);
+    }
+    for (size_t i = 0; i < count; ++i) {
+        Queue& q = *queues[i % queues.size()];
+        std::lock_guard<std::mutex> lock(q.mutex);
+        q.jobs.push_back({ &task, i, &remaining });
+    }
+    wake.notify_all();
+
+    // The caller steals too instead of idling
+    const size_t self = queues.size();
+    while (remaining.load(std::memory_order_acquire) > 0) {
+        Job job;
+        if (findWork(self, job)) run(job);
+        else std::this_thread::yield();
+    }
+}
@@ -0,0 +1,60 @@
+#pragma once
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// ---------------------
+// Work-stealing thread pool. Every worker owns a deque: it pops its own
+// work from the back and, when empty, steals from the front of the
+// others. parallelFor blocks until all of its tasks are done and the
+// calling thread helps while it waits.
+// ---------------------
+class ThreadPool {
+public:
+    // 0 = one thread per hardware core (the caller counts as one)
+    explicit ThreadPool(unsigned threads = 0);
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    // Total threads taking part in parallelFor, caller included
+    unsigned getThreadCount() const { return static_cast<unsigned>(queues.size()) + 1; }
+
+    // Runs task(i) for every i in [0, count). Tasks must not touch shared
+    // mutable state; the order they run in is unspecified.
+    void parallelFor(size_t count, const std::function<void(size_t)>& task);
+
+private:
+    struct Job {
+        const std::function<void(size_t)>* task = nullptr;
+        size_t index = 0;
+        std::atomic<size_t>* remaining = nullptr;
+    };
+
+    struct Queue {
+        std::mutex mutex;
+        std::deque<Job> jobs;
+    };
+
+    bool popLocal(size_t queue, Job& job);
+    bool steal(size_t thief, Job& job);
+    bool findWork(size_t self, Job& job);
+    void run(Job& job);
+    void workerLoop(size_t self);
+
+private:
+    std::vector<std::unique_ptr<Queue>> queues;
+    std::vector<std::thread> workers;
+
+    std::mutex wakeMutex;
+    std::condition_variable wake;
+    std::atomic<size_t> pending{ 0 };   // queued, not yet picked up
+    bool stopping = false;
+};
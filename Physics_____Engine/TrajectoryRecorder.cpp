@@ -0,0 +1,176 @@
+#include "TrajectoryRecorder.hpp"
+#include <algorithm>
+#include <cmath>
+
+namespace {
+
+const sf::Color trackColors[] = {
+    sf::Color::Red, sf::Color::Yellow, sf::Color::Cyan, sf::Color::Magenta,
+    sf::Color(255, 140, 0), sf::Color(120, 255, 120), sf::Color(255, 255, 255), sf::Color(90, 160, 255)
+};
+
+float distanceToSegment2(const sf::Vector2f& p, const sf::Vector2f& a, const sf::Vector2f& b) {
+    const sf::Vector2f ab = b - a;
+    const sf::Vector2f ap = p - a;
+    const float len2 = ab.x * ab.x + ab.y * ab.y;
+    float t = len2 > 0.f ? (ap.x * ab.x + ap.y * ab.y) / len2 : 0.f;
+    t = std::clamp(t, 0.f, 1.f);
+    const sf::Vector2f d = ap - ab * t;
+    return d.x * d.x + d.y * d.y;
+}
+
+}
+
+TrajectoryRecorder::TrajectoryRecorder(size_t maxTracks, size_t pointsPerTrack, float tolerance) {
+    configure(maxTracks, pointsPerTrack, tolerance);
+}
+
+void TrajectoryRecorder::configure(size_t maxTracks, size_t pointsPerTrack, float tol) {
+    capacity = std::max<size_t>(2, pointsPerTrack);
+    tolerance = std::max(0.f, tol);
+
+    tracks.assign(std::max<size_t>(1, maxTracks), Track{});
+    points.assign(tracks.size() * capacity, {});
+    window.assign(tracks.size() * windowSize, {});
+
+    // Each track draws at most its ring plus the window and live segments
+    vertices.clear();
+    vertices.reserve(tracks.size() * (capacity + 2) * 2);
+    useBuffer = sf::VertexBuffer::isAvailable() && buffer.create(vertices.capacity());
+}
+
+// --- Tracks ---
+int TrajectoryRecorder::findTrack(BodyHandle body) const {
+    for (size_t t = 0; t < tracks.size(); ++t)
+        if (tracks[t].active && tracks[t].body == body) return static_cast<int>(t);
+    return -1;
+}
+
+bool TrajectoryRecorder::trace(BodyHandle body) {
+    if (findTrack(body) >= 0) return true;
+    for (size_t t = 0; t < tracks.size(); ++t) {
+        if (tracks[t].active) continue;
+        tracks[t] = Track{};
+        tracks[t].active = true;
+        tracks[t].body = body;
+        tracks[t].color = trackColors[t % (sizeof(trackColors) / sizeof(trackColors[0]))];
+        return true;
+    }
+    return false;
+}
+
+void TrajectoryRecorder::untrace(BodyHandle body) {
+    const int t = findTrack(body);
+    if (t >= 0) tracks[t].active = false;
+}
+
+void TrajectoryRecorder::clear() {
+    for (Track& track : tracks) track.active = false;
+}
+
+void TrajectoryRecorder::resetPaths() {
+    for (Track& track : tracks) {
+        track.head = 0;
+        track.count = 0;
+        track.pending = 0;
+    }
+}
+
+size_t TrajectoryRecorder::getTrackCount() const {
+    return static_cast<size_t>(std::count_if(tracks.begin(), tracks.end(), [](const Track& t) { return t.active; }));
+}
+
+size_t TrajectoryRecorder::getMemoryBytes() const {
+    return tracks.capacity() * sizeof(Track) + points.capacity() * sizeof(sf::Vector2f) +
+        window.capacity() * sizeof(sf::Vector2f) + vertices.capacity() * sizeof(sf::Vertex);
+}
+
+// --- Recording ---
+void TrajectoryRecorder::push(size_t t, const sf::Vector2f& p) {
+    Track& track = tracks[t];
+    sf::Vector2f* ring = points.data() + t * capacity;
+    if (track.count < capacity) {
+        ring[(track.head + track.count) % capacity] = p;
+        ++track.count;
+    }
+    else {
+        ring[track.head] = p;
+        track.head = (track.head + 1) % capacity;
+    }
+}
+
+const sf::Vector2f& TrajectoryRecorder::last(size_t t) const {
+    const Track& track = tracks[t];
+    return points[t * capacity + (track.head + track.count - 1) % capacity];
+}
+
+void TrajectoryRecorder::record(const World& world) {
+    const float tol2 = tolerance * tolerance;
+
+    for (size_t t = 0; t < tracks.size(); ++t) {
+        Track& track = tracks[t];
+        if (!track.active) continue;
+        const size_t body = world.indexOf(track.body);
+        if (body == BodyStore::noBody) {
+            track.active = false;
+            continue;
+        }
+
+        const sf::Vector2f p = world.getPosition(body);
+        if (track.count == 0) {
+            push(t, p);
+            continue;
+        }
+
+        sf::Vector2f* pending = window.data() + t * windowSize;
+        const sf::Vector2f& newest = track.pending > 0 ? pending[track.pending - 1] : last(t);
+        const sf::Vector2f step = p - newest;
+        if (step.x * step.x + step.y * step.y < 1e-4f) continue;
+
+        // Every skipped sample must stay within tolerance of anchor -> p
+        bool fits = track.pending < windowSize;
+        const sf::Vector2f anchor = last(t);
+        for (size_t k = 0; fits && k < track.pending; ++k)
+            fits = distanceToSegment2(pending[k], anchor, p) <= tol2;
+
+        if (!fits) {
+            push(t, pending[track.pending - 1]);
+            track.pending = 0;
+        }
+        pending[track.pending++] = p;
+    }
+}
+
+// --- Drawing ---
+void TrajectoryRecorder::draw(sf::RenderTarget& target, const World& world, float alpha) {
+    vertices.clear();
+
+    for (size_t t = 0; t < tracks.size(); ++t) {
+        const Track& track = tracks[t];
+        const size_t body = track.active ? world.indexOf(track.body) : BodyStore::noBody;
+        if (body == BodyStore::noBody || track.count == 0) continue;
+
+        const sf::Vector2f* ring = points.data() + t * capacity;
+        for (size_t k = 1; k < track.count; ++k) {
+            vertices.emplace_back(ring[(track.head + k - 1) % capacity], track.color);
+            vertices.emplace_back(ring[(track.head + k) % capacity], track.color);
+        }
+
+        // Open window (within tolerance of a straight segment) and live tail
+        sf::Vector2f tail = last(t);
+        if (track.pending > 0) {
+            const sf::Vector2f& newest = window[t * windowSize + track.pending - 1];
+            vertices.emplace_back(tail, track.color);
+            vertices.emplace_back(newest, track.color);
+            tail = newest;
+        }
+        vertices.emplace_back(tail, track.color);
+        vertices.emplace_back(world.getInterpolatedPosition(body, alpha), track.color);
+    }
+
+    if (vertices.empty()) return;
+    if (useBuffer && buffer.update(vertices.data(), vertices.size(), 0))
+        target.draw(buffer, 0, vertices.size());
+    else
+        target.draw(vertices.data(), vertices.size(), sf::Lines);
+}
@@ -0,0 +1,72 @@
+#pragma once
+#include <SFML/Graphics.hpp>
+#include "World.hpp"
+#include <vector>
+
+// ---------------------
+// Fixed-memory path tracer for any number of bodies (up to maxTracks).
+//
+// Every traced body owns a ring of pointsPerTrack points; once full the
+// oldest point is overwritten. Samples are simplified online with an
+// opening-window test: a sample is only kept when skipping it would move
+// the path more than 'tolerance' px away from a sample it replaces, so
+// straight and resting stretches cost almost nothing. All storage,
+// including the streaming vertex buffer every track is drawn from, is
+// allocated by configure() and never grows while recording.
+// ---------------------
+class TrajectoryRecorder {
+public:
+    explicit TrajectoryRecorder(size_t maxTracks = 32, size_t pointsPerTrack = 1024, float tolerance = 0.5f);
+
+    // Reallocates storage for the given limits and drops every track
+    void configure(size_t maxTracks, size_t pointsPerTrack, float tolerance);
+
+    // Returns false when every track slot is taken. A track ends by
+    // itself once its body is removed.
+    bool trace(BodyHandle body);
+    void untrace(BodyHandle body);
+    bool isTraced(BodyHandle body) const { return findTrack(body) >= 0; }
+    // Drops all tracks, or only their recorded points
+    void clear();
+    void resetPaths();
+
+    size_t getTrackCount() const;
+    size_t getMaxTracks() const { return tracks.size(); }
+    size_t getPointsPerTrack() const { return capacity; }
+    float getTolerance() const { return tolerance; }
+    size_t getMemoryBytes() const;
+
+    // Samples every traced body; call once per simulation step
+    void record(const World& world);
+
+    // Recorded paths plus a live segment to the interpolated position
+    void draw(sf::RenderTarget& target, const World& world, float alpha);
+
+    // Samples the opening window may hold before a point is forced out
+    static constexpr size_t windowSize = 32;
+
+private:
+    struct Track {
+        bool active = false;
+        BodyHandle body;
+        size_t head = 0;        // ring index of the oldest point
+        size_t count = 0;       // points in the ring
+        size_t pending = 0;     // samples in the window since the last point
+        sf::Color color;
+    };
+
+    int findTrack(BodyHandle body) const;
+    void push(size_t t, const sf::Vector2f& p);
+    const sf::Vector2f& last(size_t t) const;
+
+private:
+    std::vector<Track> tracks;
+    std::vector<sf::Vector2f> points;   // tracks.size() rings of 'capacity'
+    std::vector<sf::Vector2f> window;   // tracks.size() windows of windowSize
+    size_t capacity = 0;
+    float tolerance = 0.5f;
+
+    std::vector<sf::Vertex> vertices;
+    sf::VertexBuffer buffer{ sf::Lines, sf::VertexBuffer::Stream };
+    bool useBuffer = false;
+};
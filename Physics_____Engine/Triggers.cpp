@@ -0,0 +1,189 @@
+#include "Triggers.hpp"
+#include "Collision.hpp"
+#include "Profiler.hpp"
+#include <algorithm>
+#include <cmath>
+
+namespace {
+    float cross(const sf::Vector2f& a, const sf::Vector2f& b) { return a.x * b.y - a.y * b.x; }
+    float dot(const sf::Vector2f& a, const sf::Vector2f& b) { return a.x * b.x + a.y * b.y; }
+
+    // Fraction t in [0, 1] where o + t * d crosses segment pq, or -1
+    float raySegment(const sf::Vector2f& o, const sf::Vector2f& d, const sf::Vector2f& p, const sf::Vector2f& q) {
+        const sf::Vector2f e = q - p;
+        const float denom = cross(d, e);
+        if (std::abs(denom) < 1e-12f) return -1.f;
+        const sf::Vector2f po = p - o;
+        const float t = cross(po, e) / denom;
+        const float u = cross(po, d) / denom;
+        return (t >= 0.f && t <= 1.f && u >= 0.f && u <= 1.f) ? t : -1.f;
+    }
+
+    // Fraction t in [0, 1] where o + t * d enters the circle (c, r), or -1
+    float rayCircle(const sf::Vector2f& o, const sf::Vector2f& d, const sf::Vector2f& c, float r) {
+        const sf::Vector2f m = o - c;
+        const float a = dot(d, d);
+        const float b = dot(m, d);
+        const float disc = b * b - a * (dot(m, m) - r * r);
+        if (a < 1e-12f || disc < 0.f) return -1.f;
+        const float t = (-b - std::sqrt(disc)) / a;
+        return (t >= 0.f && t <= 1.f) ? t : -1.f;
+    }
+
+    float pointSegmentDistance2(const sf::Vector2f& p, const sf::Vector2f& a, const sf::Vector2f& b) {
+        const sf::Vector2f ab = b - a;
+        const float len2 = dot(ab, ab);
+        const float t = len2 > 0.f ? std::clamp(dot(p - a, ab) / len2, 0.f, 1.f) : 0.f;
+        const sf::Vector2f c = a + ab * t - p;
+        return dot(c, c);
+    }
+
+    float segmentDistance2(const sf::Vector2f& a, const sf::Vector2f& b, const sf::Vector2f& c, const sf::Vector2f& d) {
+        if (raySegment(a, b - a, c, d) >= 0.f) return 0.f;
+        return std::min({ pointSegmentDistance2(a, c, d), pointSegmentDistance2(b, c, d),
+                          pointSegmentDistance2(c, a, b), pointSegmentDistance2(d, a, b) });
+    }
+
+    // Does the shape (core polygon or point, grown by its radius) touch ab?
+    bool shapeTouches(const CollisionShape& s, const sf::Vector2f& a, const sf::Vector2f& b) {
+        const float r2 = s.radius * s.radius;
+        if (s.count == 1) return pointSegmentDistance2(s.vertices[0], a, b) <= r2;
+
+        bool aInside = true;
+        for (int k = 0; k < s.count; ++k) aInside = aInside && dot(a - s.vertices[k], s.normals[k]) <= 0.f;
+        if (aInside) return true;
+        for (int k = 0; k < s.count; ++k) {
+            if (segmentDistance2(a, b, s.vertices[k], s.vertices[(k + 1) % s.count]) <= r2) return true;
+        }
+        return false;
+    }
+
+    // Earliest t in [0, 1] where the shape, moved by t * d, touches ab; -1
+    // if it does not. This is a ray cast of the contact features of the
+    // Minkowski sum: core vertices against the segment's sides and end
+    // caps, and the segment's ends against the core edges pushed out by
+    // the radius.
+    float sweep(const CollisionShape& s, const sf::Vector2f& d, const sf::Vector2f& a, const sf::Vector2f& b) {
+        const float r = s.radius;
+        const sf::Vector2f ab = b - a;
+        const float len = std::sqrt(dot(ab, ab));
+        const sf::Vector2f n = len > 0.f ? sf::Vector2f(-ab.y, ab.x) * (r / len) : sf::Vector2f();
+
+        float best = 2.f;
+        auto take = [&best](float t) { if (t >= 0.f && t < best) best = t; };
+        for (int k = 0; k < s.count; ++k) {
+            const sf::Vector2f& v = s.vertices[k];
+            take(raySegment(v, d, a + n, b + n));
+            take(raySegment(v, d, a - n, b - n));
+            take(rayCircle(v, d, a, r));
+            take(rayCircle(v, d, b, r));
+        }
+        if (s.count > 1) {
+            for (int k = 0; k < s.count; ++k) {
+                const sf::Vector2f offset = s.normals[k] * r;
+                const sf::Vector2f p = s.vertices[k] + offset;
+                const sf::Vector2f q = s.vertices[(k + 1) % s.count] + offset;
+                take(raySegment(a, -d, p, q));
+                take(raySegment(b, -d, p, q));
+            }
+        }
+        return best <= 1.f ? best : -1.f;
+    }
+}
+
+size_t TriggerSet::add(const sf::Vector2f& start, const sf::Vector2f& end) {
+    lines.push_back({ start, end });
+    boxes.push_back({ std::min(start.x, end.x), std::min(start.y, end.y), std::max(start.x, end.x), std::max(start.y, end.y) });
+    gridDirty = true;
+    return lines.size() - 1;
+}
+
+void TriggerSet::clear() {
+    lines.clear();
+    boxes.clear();
+    gridDirty = true;
+}
+
+// --- Grid ---
+// Cells about the size of an average line, so a line spans a few cells
+// and a body's swept box a few more; doubled until the grid has at most
+// a few cells per line, so lines scattered far apart stay cheap.
+void TriggerSet::buildGrid() const {
+    gridDirty = false;
+    bounds = boxes[0];
+    float extent = 0.f;
+    for (const Aabb& b : boxes) {
+        bounds = Aabb::merge(bounds, b);
+        extent += std::max(b.maxX - b.minX, b.maxY - b.minY);
+    }
+
+    const size_t maxCells = std::max<size_t>(1024, boxes.size() * 4);
+    const double width = static_cast<double>(bounds.maxX) - bounds.minX;
+    const double height = static_cast<double>(bounds.maxY) - bounds.minY;
+    double cellSize = std::max(1.0, static_cast<double>(extent) / static_cast<double>(boxes.size()));
+    while ((std::floor(width / cellSize) + 1.0) * (std::floor(height / cellSize) + 1.0) > static_cast<double>(maxCells))
+        cellSize *= 2.0;
+    columns = static_cast<int32_t>(width / cellSize) + 1;
+    rows = static_cast<int32_t>(height / cellSize) + 1;
+    invCellSize = static_cast<float>(1.0 / cellSize);
+
+    // Counting sort of (cell, line) entries
+    const size_t cells = static_cast<size_t>(columns) * static_cast<size_t>(rows);
+    cellStart.assign(cells + 1, 0);
+    auto forEachCell = [this](const Aabb& b, auto&& f) {
+        for (int32_t y = row(b.minY); y <= row(b.maxY); ++y)
+            for (int32_t x = column(b.minX); x <= column(b.maxX); ++x)
+                f(static_cast<size_t>(y) * static_cast<size_t>(columns) + static_cast<size_t>(x));
+    };
+    for (const Aabb& b : boxes) forEachCell(b, [this](size_t c) { ++cellStart[c + 1]; });
+    for (size_t c = 0; c < cells; ++c) cellStart[c + 1] += cellStart[c];
+
+    cellLines.resize(cellStart[cells]);
+    std::vector<uint32_t> fill(cellStart.begin(), cellStart.end() - 1);
+    for (uint32_t k = 0; k < boxes.size(); ++k)
+        forEachCell(boxes[k], [&](size_t c) { cellLines[fill[c]++] = k; });
+}
+
+void TriggerSet::detect(const World& world, float time, float dt, std::vector<TriggerEvent>& events) {
+    if (lines.empty()) return;
+    PROFILE_ZONE("Triggers");
+
+    const BodyStore& b = world.getStore();
+    stepEvents.clear();
+    for (size_t i = 0; i < b.count(); ++i) {
+        if (!b.awake[i]) continue;
+        const sf::Vector2f d(b.posX[i] - b.prevX[i], b.posY[i] - b.prevY[i]);
+        if (d.x == 0.f && d.y == 0.f) continue;
+
+        // Bounds before and after the step
+        const Aabb swept(b.minX[i] - std::max(d.x, 0.f) - contactSlop, b.minY[i] - std::max(d.y, 0.f) - contactSlop,
+                         b.maxX[i] - std::min(d.x, 0.f) + contactSlop, b.maxY[i] - std::min(d.y, 0.f) + contactSlop);
+        CollisionShape start;
+        bool haveShape = false;
+        auto sweepLine = [&](uint32_t k) {
+            if (!haveShape) {
+                // At the previous position, grown by the slop
+                start = makeCollisionShape(b, i);
+                for (int v = 0; v < start.count; ++v) start.vertices[v] -= d;
+                start.radius += contactSlop;
+                haveShape = true;
+            }
+            const SceneLine& line = lines[k];
+            if (shapeTouches(start, line.start, line.end)) return true;
+            const float t = sweep(start, d, line.start, line.end);
+            if (t >= 0.f) {
+                stepEvents.push_back({ k, b.handle[i], time + t * dt,
+                                       { b.prevX[i] + d.x * t, b.prevY[i] + d.y * t } });
+            }
+            return true;
+        };
+        visit(swept, sweepLine);
+    }
+
+    // Ties in a fixed order, so a replayed run lists them the same
+    std::sort(stepEvents.begin(), stepEvents.end(), [](const TriggerEvent& x, const TriggerEvent& y) {
+        if (x.time != y.time) return x.time < y.time;
+        return x.body.slot != y.body.slot ? x.body.slot < y.body.slot : x.line < y.line;
+    });
+    events.insert(events.end(), stepEvents.begin(), stepEvents.end());
+}
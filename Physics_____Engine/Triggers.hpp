@@ -0,0 +1,115 @@
+#pragma once
+#include "World.hpp"
+#include "Scene.hpp"
+#include "AabbTree.hpp"
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+
+// A body's shape started touching a trigger line
+struct TriggerEvent {
+    uint32_t line = 0;
+    BodyHandle body;
+    float time = 0.f;          // simulation time of first contact, within the step
+    sf::Vector2f position{};   // the body's position at that time
+};
+
+// ---------------------
+// Trigger lines (timing gates) and their crossing detection.
+//
+// After each step, every body that moved is swept from its previous to
+// its new position and tested exactly against the lines its swept bounds
+// reach, so the cost follows bodies x nearby lines rather than bodies x
+// lines. Lines never move, so they are binned once into a uniform grid
+// (cell about one line long, rebuilt on the first query after lines are
+// added); a line spanning several cells is reported once, from the cell
+// holding the top-left corner of its overlap with the query, as in the
+// Broadphase.
+//
+// Shapes are the collision shapes (outline included) and move in a
+// straight line over the step, so the contact time is exact for the
+// step's motion: the event is stamped at the fraction of the step where
+// the shape first comes within contactSlop of the line. A body already
+// that close when the step begins does not fire again, so a body resting
+// on a line fires once.
+// ---------------------
+class TriggerSet {
+public:
+    size_t add(const sf::Vector2f& start, const sf::Vector2f& end);
+    void clear();
+    size_t size() const { return lines.size(); }
+    const SceneLine& getLine(size_t index) const { return lines[index]; }
+    const std::vector<SceneLine>& getLines() const { return lines; }
+
+    // callback(line index) -> bool, false stops; tested on the line bounds
+    template <typename F> void queryRect(const sf::FloatRect& rect, F&& callback) const;
+
+    // Call after world.step(dt) for the step that began at 'time'. Appends
+    // the step's events to 'events', earliest first.
+    void detect(const World& world, float time, float dt, std::vector<TriggerEvent>& events);
+
+    static constexpr float contactSlop = 0.01f;
+
+private:
+    // Inclusive, unlike Aabb::overlaps: a horizontal or vertical line has
+    // an empty box
+    static bool touches(const Aabb& a, const Aabb& b) {
+        return a.minX <= b.maxX && b.minX <= a.maxX && a.minY <= b.maxY && b.minY <= a.maxY;
+    }
+    int32_t column(float x) const;
+    int32_t row(float y) const;
+    void buildGrid() const;
+    template <typename F> bool visit(const Aabb& box, F& callback) const;
+
+private:
+    std::vector<SceneLine> lines;
+    std::vector<Aabb> boxes;
+    std::vector<TriggerEvent> stepEvents;
+
+    // Grid over 'bounds', built lazily: cell c holds
+    // cellLines[cellStart[c] .. cellStart[c + 1])
+    mutable bool gridDirty = true;
+    mutable Aabb bounds;
+    mutable float invCellSize = 1.f;
+    mutable int32_t columns = 0;
+    mutable int32_t rows = 0;
+    mutable std::vector<uint32_t> cellStart;
+    mutable std::vector<uint32_t> cellLines;
+};
+
+inline int32_t TriggerSet::column(float x) const {
+    return static_cast<int32_t>(std::clamp((x - bounds.minX) * invCellSize, 0.f, static_cast<float>(columns - 1)));
+}
+
+inline int32_t TriggerSet::row(float y) const {
+    return static_cast<int32_t>(std::clamp((y - bounds.minY) * invCellSize, 0.f, static_cast<float>(rows - 1)));
+}
+
+// Returns false if the callback stopped the query
+template <typename F>
+bool TriggerSet::visit(const Aabb& box, F& callback) const {
+    if (lines.empty()) return true;
+    if (gridDirty) buildGrid();
+    if (!touches(box, bounds)) return true;
+
+    const int32_t x0 = column(box.minX), x1 = column(box.maxX);
+    const int32_t y0 = row(box.minY), y1 = row(box.maxY);
+    for (int32_t y = y0; y <= y1; ++y) {
+        for (int32_t x = x0; x <= x1; ++x) {
+            const size_t cell = static_cast<size_t>(y) * static_cast<size_t>(columns) + static_cast<size_t>(x);
+            for (uint32_t k = cellStart[cell]; k < cellStart[cell + 1]; ++k) {
+                const uint32_t line = cellLines[k];
+                const Aabb& b = boxes[line];
+                if (!touches(box, b)) continue;
+                if (std::max(column(b.minX), x0) != x || std::max(row(b.minY), y0) != y) continue;
+                if (!callback(line)) return false;
+            }
+        }
+    }
+    return true;
+}
+
+template <typename F>
+void TriggerSet::queryRect(const sf::FloatRect& rect, F&& callback) const {
+    visit(Aabb(rect), callback);
+}
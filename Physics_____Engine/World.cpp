@@ -0,0 +1,692 @@
+#include "World.hpp"
+#include "SimdKernels.hpp"
+#include "Profiler.hpp"
+#include <cmath>
+#include <algorithm>
+#include <cstring>
+
+size_t World::addBody(const Body& body) {
+    const size_t index = bodies.push(body);
+    proxies.push_back(tree.insert(bodies.bounds(index), static_cast<uint32_t>(index)));
+    ++awakeCount;
+    return index;
+}
+
+size_t World::addBodies(const BodyColumns& columns) {
+    const size_t first = bodies.append(columns);
+    const size_t n = columns.count;
+    awakeCount += n;
+
+    proxies.resize(first + n);
+    if (first == 0) {
+        std::vector<Aabb> boxes(n);
+        for (size_t i = 0; i < n; ++i) boxes[i] = { bodies.minX[i], bodies.minY[i], bodies.maxX[i], bodies.maxY[i] };
+        tree.build(boxes.data(), n, 0, proxies.data());
+    }
+    else {
+        for (size_t i = first; i < first + n; ++i)
+            proxies[i] = tree.insert(bodies.bounds(i), static_cast<uint32_t>(i));
+    }
+    return first;
+}
+
+namespace {
+    // Whatever rested on or against a body has to fall again once it goes
+    sf::FloatRect wakeArea(const BodyStore& bodies, size_t index) {
+        sf::FloatRect around = bodies.bounds(index);
+        around.left -= 2.f;
+        around.top -= 2.f;
+        around.width += 4.f;
+        around.height += 4.f;
+        return around;
+    }
+}
+
+void World::removeBody(size_t index) {
+    if (index >= bodies.count()) return;
+    const size_t last = bodies.count() - 1;
+
+    neighbours.clear();
+    queryRect(wakeArea(bodies, index), neighbours);
+    eraseBody(index);
+    remapPairs([index, last](size_t i) { return i == index ? BodyStore::noBody : i == last ? index : i; });
+
+    for (size_t n : neighbours) {
+        if (n != index) wake(n == last ? index : n);
+    }
+}
+
+bool World::removeBody(BodyHandle body) {
+    const size_t index = bodies.indexOf(body);
+    if (index == BodyStore::noBody) return false;
+    removeBody(index);
+    return true;
+}
+
+size_t World::removeBodies(const std::vector<BodyHandle>& handles, std::vector<size_t>* removedAt) {
+    if (removedAt) removedAt->clear();
+
+    // Neighbours by handle, since indices move as bodies go
+    std::vector<BodyHandle> woken;
+    for (const BodyHandle& body : handles) {
+        const size_t index = bodies.indexOf(body);
+        if (index == BodyStore::noBody) continue;
+        neighbours.clear();
+        queryRect(wakeArea(bodies, index), neighbours);
+        for (size_t n : neighbours) woken.push_back(bodies.handle[n]);
+    }
+
+    // 'at' follows which original body sits at each index through the
+    // swaps, so the cache is renumbered once at the end
+    const size_t count = bodies.count();
+    std::vector<uint32_t> at(count);
+    for (size_t i = 0; i < count; ++i) at[i] = static_cast<uint32_t>(i);
+    size_t removed = 0;
+    for (const BodyHandle& body : handles) {
+        const size_t index = bodies.indexOf(body);
+        if (index == BodyStore::noBody) continue;
+        eraseBody(index);
+        at[index] = at.back();
+        at.pop_back();
+        if (removedAt) removedAt->push_back(index);
+        ++removed;
+    }
+    if (removed == 0) return 0;
+
+    std::vector<size_t> newIndex(count, BodyStore::noBody);
+    for (size_t i = 0; i < at.size(); ++i) newIndex[at[i]] = i;
+    remapPairs([&newIndex](size_t i) { return newIndex[i]; });
+
+    for (const BodyHandle& body : woken) {
+        const size_t index = bodies.indexOf(body);
+        if (index != BodyStore::noBody) wake(index);
+    }
+    return removed;
+}
+
+void World::eraseBody(size_t index) {
+    const size_t last = bodies.count() - 1;
+    if (bodies.awake[index]) --awakeCount;
+    tree.remove(proxies[index]);
+    bodies.erase(index);
+    solver.onBodyRemoved(index, last);
+    joints.markDirty();
+    islandsBuilt = false;
+
+    // The last body moved into the gap
+    proxies[index] = proxies[last];
+    proxies.pop_back();
+    if (index != last) tree.setUserData(proxies[index], static_cast<uint32_t>(index));
+}
+
+// Pairs stay sorted with i < j for the next step's matching. A pair whose
+// ends would swap order is dropped rather than flipped, since its
+// manifold's normal and feature ids are oriented from i to j. The
+// renumbered ones are set aside in prevPairs / prevManifolds (only read
+// inside collide) and merged back in.
+template <typename Map>
+void World::remapPairs(Map map) {
+    prevPairs.clear();
+    prevManifolds.clear();
+    size_t kept = 0;
+    for (size_t k = 0; k < pairs.size(); ++k) {
+        const size_t i = map(pairs[k].first), j = map(pairs[k].second);
+        if (i == BodyStore::noBody || j == BodyStore::noBody || i > j) continue;
+        const Broadphase::Pair pair(static_cast<uint32_t>(i), static_cast<uint32_t>(j));
+        if (pair == pairs[k]) {
+            pairs[kept] = pair;
+            manifolds[kept] = manifolds[k];
+            ++kept;
+        }
+        else {
+            prevPairs.push_back(pair);
+            prevManifolds.push_back(manifolds[k]);
+        }
+    }
+
+    movedPairs.resize(prevPairs.size());
+    for (size_t m = 0; m < movedPairs.size(); ++m) movedPairs[m] = static_cast<uint32_t>(m);
+    std::sort(movedPairs.begin(), movedPairs.end(), [this](uint32_t a, uint32_t b) { return prevPairs[a] < prevPairs[b]; });
+
+    // Merge from the back, so the kept pairs can stay where they are
+    pairs.resize(kept + movedPairs.size());
+    manifolds.resize(pairs.size());
+    size_t from = kept, m = movedPairs.size();
+    for (size_t to = pairs.size(); m > 0;) {
+        --to;
+        if (from > 0 && pairs[from - 1] > prevPairs[movedPairs[m - 1]]) {
+            --from;
+            pairs[to] = pairs[from];
+            manifolds[to] = manifolds[from];
+        }
+        else {
+            --m;
+            pairs[to] = prevPairs[movedPairs[m]];
+            manifolds[to] = prevManifolds[movedPairs[m]];
+        }
+    }
+    prevPairs.clear();
+    prevManifolds.clear();
+}
+
+void World::clear() {
+    bodies.clear();
+    tree.clear();
+    proxies.clear();
+    awakeCount = 0;
+    impacts.clear();
+    pairs.clear();
+    manifolds.clear();
+    solver.clear();
+    joints.clear();
+}
+
+size_t World::addJoint(const JointDef& joint) {
+    const size_t index = joints.add(joint, bodies);
+    if (index == JointSolver::noJoint) return index;
+    wake(bodies.indexOf(joint.a));
+    if (!joint.toWorld()) wake(bodies.indexOf(joint.b));
+    return index;
+}
+
+size_t World::addRope(const RopeDef& rope) {
+    const bool toWorld = rope.b.slot == UINT32_MAX;
+    const size_t ia = bodies.indexOf(rope.a);
+    const size_t ib = toWorld ? BodyStore::noBody : bodies.indexOf(rope.b);
+    if (ia == BodyStore::noBody || (!toWorld && (ib == BodyStore::noBody || ia == ib)) || rope.segments == 0)
+        return BodyStore::noBody;
+
+    const sf::Vector2f from = bodies.centre(ia);
+    const sf::Vector2f to = toWorld ? rope.anchor : bodies.centre(ib);
+    const float links = static_cast<float>(rope.segments + 1);
+    const float link = std::max(rope.slack, 1.f) * std::hypot(to.x - from.x, to.y - from.y) / links;
+
+    Body segment;
+    segment.type = ObjectType::Circle;
+    segment.size = { rope.radius, rope.radius };
+    segment.mass = rope.mass;
+    segment.elasticity = 0.f;
+
+    const size_t first = bodies.count();
+    BodyHandle previous = rope.a;
+    for (size_t k = 0; k < rope.segments; ++k) {
+        segment.position = from + (to - from) * (static_cast<float>(k + 1) / links);
+        const BodyHandle h = getHandle(addBody(segment));
+        joints.add({ JointType::Rope, previous, h, {}, link }, bodies);
+        previous = h;
+    }
+    JointDef end{ JointType::Rope, previous, rope.b, rope.anchor, link };
+    joints.add(end, bodies);
+    wake(ia);
+    if (!toWorld) wake(ib);
+    return first;
+}
+
+void World::setBody(size_t index, const Body& body) {
+    wake(index);
+    bodies.set(index, body);
+    tree.move(proxies[index], bodies.bounds(index));
+}
+
+void World::setPosition(size_t index, const sf::Vector2f& pos) {
+    bodies.posX[index] = bodies.prevX[index] = pos.x;
+    bodies.posY[index] = bodies.prevY[index] = pos.y;
+    bodies.refreshBounds(index);
+    tree.move(proxies[index], bodies.bounds(index));
+    wake(index);
+}
+
+void World::setVelocity(size_t index, const sf::Vector2f& vel) {
+    bodies.velX[index] = vel.x;
+    bodies.velY[index] = vel.y;
+    wake(index);
+}
+
+void World::setGravity(float g) {
+    if (g == gravity) return;
+    gravity = g;
+    for (size_t i = 0; i < bodies.count(); ++i) wake(i);
+}
+
+void World::setGroundY(float y) {
+    if (y == groundY) return;
+    groundY = y;
+    for (size_t i = 0; i < bodies.count(); ++i) wake(i);
+}
+
+// --- Snapshots ---
+namespace {
+    struct SnapshotHeader {
+        uint64_t bodyCount;
+        uint64_t awakeCount;
+        uint64_t pairCount;
+        uint64_t impulseCount;
+        uint64_t jointCount;
+    };
+
+    template <typename T>
+    void putArray(uint8_t*& out, const T* data, size_t n) {
+        if (n) std::memcpy(out, data, n * sizeof(T));
+        out += n * sizeof(T);
+    }
+
+    template <typename V>
+    void getArray(const uint8_t*& in, V& v, size_t n) {
+        v.resize(n);
+        if (n) std::memcpy(static_cast<void*>(v.data()), in, n * sizeof(v[0]));
+        in += n * sizeof(v[0]);
+    }
+}
+
+void World::saveSnapshot(WorldSnapshot& snapshot) const {
+    const std::vector<float>& impulses = solver.getGroundImpulses();
+    const SnapshotHeader header{ bodies.count(), awakeCount, pairs.size(), impulses.size(), joints.size() };
+
+    snapshot.bytes.resize(sizeof(header) + bodies.rawSize() + pairs.size() * (sizeof(Broadphase::Pair) + sizeof(Manifold))
+                          + impulses.size() * sizeof(float) + joints.rawSize());
+    snapshot.bodyCount = bodies.count();
+
+    uint8_t* out = snapshot.bytes.data();
+    putArray(out, &header, 1);
+    bodies.saveRaw(out);
+    out += bodies.rawSize();
+    putArray(out, pairs.data(), pairs.size());
+    putArray(out, manifolds.data(), manifolds.size());
+    putArray(out, impulses.data(), impulses.size());
+    joints.saveRaw(out);
+}
+
+bool World::restoreSnapshot(const WorldSnapshot& snapshot) {
+    if (snapshot.empty()) return false;
+
+    SnapshotHeader header;
+    const uint8_t* in = snapshot.bytes.data();
+    std::memcpy(&header, in, sizeof(header));
+    in += sizeof(header);
+
+    const size_t n = static_cast<size_t>(header.bodyCount);
+    const bool sameCount = n == bodies.count();
+    const bool changed = bodies.loadRaw(in, n);
+    in += bodies.rawSize();
+    awakeCount = static_cast<size_t>(header.awakeCount);
+
+    getArray(in, pairs, static_cast<size_t>(header.pairCount));
+    getArray(in, manifolds, static_cast<size_t>(header.pairCount));
+    getArray(in, solver.getGroundImpulses(), static_cast<size_t>(header.impulseCount));
+    joints.loadRaw(in, static_cast<size_t>(header.jointCount));
+    prevPairs.clear();
+    prevManifolds.clear();
+    impacts.clear();
+    islandsBuilt = false;
+
+    if (sameCount) {
+        markMoved();
+    }
+    else {
+        std::vector<Aabb> boxes(n);
+        for (size_t i = 0; i < n; ++i) boxes[i] = { bodies.minX[i], bodies.minY[i], bodies.maxX[i], bodies.maxY[i] };
+        proxies.resize(n);
+        tree.build(boxes.data(), n, 0, proxies.data());
+        treeDirty = false;
+    }
+    return changed;
+}
+
+// --- Sleeping ---
+void World::wake(size_t index) {
+    bodies.sleepTimer[index] = 0.f;
+    if (bodies.awake[index]) return;
+    bodies.awake[index] = 1;
+    ++awakeCount;
+}
+
+void World::setSleepEnabled(bool enabled) {
+    sleepEnabled = enabled;
+    if (enabled) return;
+    for (size_t i = 0; i < bodies.count(); ++i) wake(i);
+}
+
+// Timers run per body, but bodies only fall asleep once their whole
+// island has been slow long enough
+void World::updateSleep(float dt) {
+    PROFILE_ZONE("Sleep");
+    const size_t n = bodies.count();
+    uint8_t* awake = bodies.awake.data();
+    float* timer = bodies.sleepTimer.data();
+    const float* vx = bodies.velX.data();
+    const float* vy = bodies.velY.data();
+    const float limit2 = sleepSpeed * sleepSpeed;
+
+    for (size_t i = 0; i < n; ++i) {
+        if (!awake[i]) continue;
+        timer[i] = (vx[i] * vx[i] + vy[i] * vy[i] < limit2) ? timer[i] + dt : 0.f;
+    }
+
+    if (!islandsBuilt) {
+        islands.build(n, pairs);
+        lastIslandCount = islands.getIslandCount();
+    }
+    islandMinTimer.assign(islands.getIslandCount(), sleepTime);
+    for (size_t i = 0; i < n; ++i) {
+        const uint32_t k = islands.getBodyIsland(i);
+        if (awake[i] && k != IslandBuilder::noIsland) islandMinTimer[k] = std::min(islandMinTimer[k], timer[i]);
+    }
+
+    awakeCount = 0;
+    for (size_t i = 0; i < n; ++i) {
+        if (!awake[i]) continue;
+        const uint32_t k = islands.getBodyIsland(i);
+        const float t = k == IslandBuilder::noIsland ? timer[i] : islandMinTimer[k];
+        if (t >= sleepTime) {
+            awake[i] = 0;
+            bodies.velX[i] = 0.f;
+            bodies.velY[i] = 0.f;
+        }
+        else {
+            ++awakeCount;
+        }
+    }
+}
+
+// --- Step ---
+void World::step(float dt) {
+    PROFILE_ZONE("World::step");
+    std::copy(bodies.posX.begin(), bodies.posX.end(), bodies.prevX.begin());
+    std::copy(bodies.posY.begin(), bodies.posY.end(), bodies.prevY.begin());
+    impacts.clear();
+
+    if (sleepEnabled && awakeCount == 0) {
+        pairs.clear();
+        manifolds.clear();
+        lastIslandCount = 0;
+        lastSweptCount = lastImpactCount = 0;
+        return;
+    }
+
+    islandsBuilt = false;
+    awakeCount += joints.wakeJoined(bodies);
+    integrate(dt);
+    joints.solve(bodies, dt, pool);
+    collide(dt);
+    solveContinuous();
+    if (sleepEnabled) updateSleep(dt);
+    treeDirty = true;
+}
+
+// Gravity, position update and ground bounce, streamed over the hot
+// arrays by the widest SIMD kernel the CPU supports
+void World::integrate(float dt) {
+    PROFILE_ZONE("Integrate");
+    integrateBodies(bodies, 0, bodies.count(), { dt, gravity, groundY, groundFriction });
+}
+
+// Broadphase candidates get their manifolds first, then the solver works
+// through them in (i, j) order. With a pool, the pairs are split into
+// islands and islands are solved concurrently; each island still sees its
+// pairs in (i, j) order, so the result is the same.
+void World::collide(float dt) {
+    {
+        PROFILE_ZONE("Broadphase");
+        std::swap(pairs, prevPairs);
+        std::swap(manifolds, prevManifolds);
+        broadphase.findPairs(bodies, pairs);
+        joints.filterPairs(pairs);
+        matchManifolds();
+    }
+    PROFILE_ZONE("Contacts");
+    lastIslandCount = 0;
+
+    // Each pair is solved by exactly one task, so impulses can be kept
+    // per pair and turned into events afterwards in a fixed order
+    const bool recordImpacts = impactThreshold > 0.f;
+    if (recordImpacts) pairImpulse.assign(pairs.size(), 0.f);
+    float* impulses = recordImpacts ? pairImpulse.data() : nullptr;
+    solver.begin(bodies.count(), pairs.size(), groundY);
+
+    const size_t parallelThreshold = 2048;
+    if (!pool || pool->getThreadCount() < 2 || pairs.size() < parallelThreshold) {
+        for (size_t k = 0; k < pairs.size(); ++k) updateManifold(k);
+
+        serialOrder.resize(pairs.size());
+        for (size_t k = 0; k < pairs.size(); ++k) serialOrder[k] = static_cast<uint32_t>(k);
+        solver.solve(bodies, pairs.data(), manifolds.data(), serialOrder.data(), 0, pairs.size(), dt, impulses);
+
+        if (recordImpacts) gatherImpacts();
+        return;
+    }
+
+    islands.build(bodies.count(), pairs);
+    islandsBuilt = true;
+    lastIslandCount = islands.getIslandCount();
+    const auto& order = islands.getPairOrder();
+    const auto& start = islands.getIslandStart();
+
+    // Batch consecutive islands into tasks of roughly equal pair counts
+    const size_t target = std::max<size_t>(256, pairs.size() / (pool->getThreadCount() * 8));
+    taskStart.clear();
+    taskStart.push_back(0);
+    for (uint32_t k = 0; k < lastIslandCount; ++k) {
+        if (start[k + 1] - start[taskStart.back()] >= target)
+            taskStart.push_back(k + 1);
+    }
+    if (taskStart.back() != lastIslandCount) taskStart.push_back(static_cast<uint32_t>(lastIslandCount));
+
+    pool->parallelFor(taskStart.size() - 1, [&](size_t t) {
+        PROFILE_ZONE("Island batch");
+        const uint32_t first = start[taskStart[t]], last = start[taskStart[t + 1]];
+        for (uint32_t p = first; p < last; ++p) updateManifold(order[p]);
+        solver.solve(bodies, pairs.data(), manifolds.data(), order.data(), first, last, dt, impulses);
+    });
+    if (recordImpacts) gatherImpacts();
+}
+
+// Both pair lists are sorted, so a merge finds each pair's previous slot
+void World::matchManifolds() {
+    manifolds.resize(pairs.size());
+    prevMatch.resize(pairs.size());
+
+    size_t p = 0;
+    for (size_t k = 0; k < pairs.size(); ++k) {
+        while (p < prevPairs.size() && prevPairs[p] < pairs[k]) ++p;
+        prevMatch[k] = (p < prevPairs.size() && prevPairs[p] == pairs[k]) ? static_cast<uint32_t>(p) : noMatch;
+    }
+}
+
+size_t World::getContactCount() const {
+    size_t n = 0;
+    for (const Manifold& m : manifolds) n += static_cast<size_t>(m.pointCount);
+    return n;
+}
+
+void World::gatherImpacts() {
+    for (size_t k = 0; k < pairs.size() && impacts.size() < maxImpacts; ++k) {
+        if (pairImpulse[k] < impactThreshold) continue;
+
+        const Manifold& m = manifolds[k];
+        ImpactEvent e;
+        e.a = pairs[k].first;
+        e.b = pairs[k].second;
+        e.point = m.pointCount == 2 ? 0.5f * (m.points[0].point + m.points[1].point) : m.points[0].point;
+        e.normal = m.normal;
+        e.impulse = pairImpulse[k];
+        impacts.push_back(e);
+    }
+}
+
+// Exact test of pair k, done for every pair before anything moves. A
+// fast body wakes a sleeper it hits; both are in the same island, so this
+// is safe from the island workers.
+void World::updateManifold(size_t k) {
+    const size_t i = pairs[k].first, j = pairs[k].second;
+    Manifold& m = manifolds[k];
+    m.pointCount = 0;
+    if (!collideShapes(makeCollisionShape(bodies, i), makeCollisionShape(bodies, j), m)) return;
+
+    // Carry accumulated impulses over to points with the same feature id
+    for (int p = 0; p < m.pointCount; ++p) m.points[p].normalImpulse = 0.f;
+    if (prevMatch[k] != noMatch) {
+        const Manifold& old = prevManifolds[prevMatch[k]];
+        for (int p = 0; p < m.pointCount; ++p) {
+            for (int q = 0; q < old.pointCount; ++q) {
+                if (old.points[q].id != m.points[p].id) continue;
+                m.points[p].normalImpulse = old.points[q].normalImpulse;
+            }
+        }
+    }
+
+    if (!bodies.awake[i] || !bodies.awake[j]) {
+        const size_t sleeper = bodies.awake[i] ? j : i;
+        const size_t mover = bodies.awake[i] ? i : j;
+        const float vx = bodies.velX[mover], vy = bodies.velY[mover];
+        if (vx * vx + vy * vy > sleepSpeed * sleepSpeed) {
+            bodies.awake[sleeper] = 1;
+            bodies.sleepTimer[sleeper] = 0.f;
+        }
+    }
+}
+
+// --- Continuous collision ---
+// Bodies are swept one at a time in index order against the others'
+// motion over the step, so the result does not depend on threads. The
+// tree holds the bodies where they ended, so it is queried with the
+// swept body's path grown by the furthest any body moved on each axis; each
+// candidate is then checked in the frame of its own motion (bodies
+// falling together barely move relative to each other) before the exact
+// test.
+void World::solveContinuous() {
+    lastSweptCount = lastImpactCount = 0;
+    const size_t n = bodies.count();
+    const float* px = bodies.posX.data();
+    const float* py = bodies.posY.data();
+    const float* qx = bodies.prevX.data();
+    const float* qy = bodies.prevY.data();
+
+    sweptBodies.clear();
+    float growX = 0.f, growY = 0.f;
+    for (size_t i = 0; i < n; ++i) {
+        if (!bodies.awake[i]) continue;
+        const float dx = px[i] - qx[i], dy = py[i] - qy[i];
+        const float d2 = dx * dx + dy * dy;
+        growX = std::max(growX, std::abs(dx));
+        growY = std::max(growY, std::abs(dy));
+        if (d2 == 0.f) continue;
+
+        bool swept = bodies.fast[i] != 0;
+        if (!swept && continuousThreshold > 0.f) {
+            const float extent = continuousThreshold * std::min(bodies.localMaxX[i] - bodies.localMinX[i],
+                                                                bodies.localMaxY[i] - bodies.localMinY[i]);
+            swept = d2 > extent * extent;
+        }
+        if (swept) sweptBodies.push_back(static_cast<uint32_t>(i));
+    }
+    if (sweptBodies.empty()) return;
+    PROFILE_ZONE("Continuous");
+    lastSweptCount = sweptBodies.size();
+
+    treeDirty = true;
+    refitTree();
+    for (uint32_t i : sweptBodies) {
+        const sf::Vector2f di(px[i] - qx[i], py[i] - qy[i]);
+        const Aabb path(std::min(bodies.minX[i], bodies.minX[i] - di.x), std::min(bodies.minY[i], bodies.minY[i] - di.y),
+                        std::max(bodies.maxX[i], bodies.maxX[i] - di.x), std::max(bodies.maxY[i], bodies.maxY[i] - di.y));
+        const Aabb query(path.minX - growX, path.minY - growY, path.maxX + growX, path.maxY + growY);
+
+        CollisionShape a = makeCollisionShape(bodies, i);
+        translateShape(a, -di);
+        float first = 2.f;
+        uint32_t hit = 0;
+        sf::Vector2f normal, point;
+        tree.queryRect(query, [&](uint32_t j) {
+            if (j == i) return true;
+            // In j's frame, i's start bounds swept by the relative motion
+            // must reach j's start bounds
+            const sf::Vector2f dj(px[j] - qx[j], py[j] - qy[j]);
+            const sf::Vector2f rel = di - dj;
+            const Aabb start(bodies.minX[i] - di.x, bodies.minY[i] - di.y, bodies.maxX[i] - di.x, bodies.maxY[i] - di.y);
+            const Aabb relative(start.minX + std::min(rel.x, 0.f), start.minY + std::min(rel.y, 0.f),
+                                start.maxX + std::max(rel.x, 0.f), start.maxY + std::max(rel.y, 0.f));
+            if (!relative.overlaps({ bodies.minX[j] - dj.x, bodies.minY[j] - dj.y, bodies.maxX[j] - dj.x, bodies.maxY[j] - dj.y }))
+                return true;
+            CollisionShape b = makeCollisionShape(bodies, j);
+            translateShape(b, -dj);
+            sf::Vector2f n, p;
+            const float t = timeOfImpact(a, di, b, dj, continuousSlop, n, p);
+            if (t >= 0.f && t < first) {
+                first = t;
+                hit = j;
+                normal = n;
+                point = p + dj * (1.f - t);   // where the contact is at the end of the step
+            }
+            return true;
+        });
+        if (first > 1.f) continue;
+        ++lastImpactCount;
+
+        // Back to the touching pose relative to where the other body ended
+        const sf::Vector2f dj(px[hit] - qx[hit], py[hit] - qy[hit]);
+        bodies.posX[i] = qx[i] + di.x * first + dj.x * (1.f - first);
+        bodies.posY[i] = qy[i] + di.y * first + dj.y * (1.f - first);
+        bodies.refreshBounds(i);
+
+        // Bounce off it if still closing, as a contact with no friction; a
+        // sleeper it hits wakes up and takes its share
+        const float invA = bodies.invMass[i];
+        const float invB = bodies.invMass[hit];
+        const float vn = (bodies.velX[i] - bodies.velX[hit]) * normal.x + (bodies.velY[i] - bodies.velY[hit]) * normal.y;
+        if (vn <= 0.f || invA + invB <= 0.f) continue;
+        const float e = std::min(bodies.restitution[i], bodies.restitution[hit]);
+        const float impulse = (1.f + e) * vn / (invA + invB);
+        bodies.velX[i] -= impulse * invA * normal.x;
+        bodies.velY[i] -= impulse * invA * normal.y;
+        bodies.velX[hit] += impulse * invB * normal.x;
+        bodies.velY[hit] += impulse * invB * normal.y;
+        wake(hit);
+
+        if (impactThreshold > 0.f && impulse >= impactThreshold && impacts.size() < maxImpacts)
+            impacts.push_back({ std::min(i, hit), std::max(i, hit), point, i < hit ? normal : -normal, impulse });
+    }
+    treeDirty = true;
+}
+
+// --- Spatial queries ---
+void World::refitTree() const {
+    if (!treeDirty) return;
+    treeDirty = false;
+    for (size_t i = 0; i < proxies.size(); ++i)
+        tree.move(proxies[i], { bodies.minX[i], bodies.minY[i], bodies.maxX[i], bodies.maxY[i] });
+}
+
+void World::queryPoint(const sf::Vector2f& point, std::vector<size_t>& out) const {
+    refitTree();
+    tree.queryPoint(point, [&](uint32_t i) {
+        if (point.x >= bodies.minX[i] && point.x < bodies.maxX[i] && point.y >= bodies.minY[i] && point.y < bodies.maxY[i])
+            out.push_back(i);
+        return true;
+    });
+}
+
+void World::queryRect(const sf::FloatRect& rect, std::vector<size_t>& out) const {
+    refitTree();
+    const Aabb box(rect);
+    tree.queryRect(box, [&](uint32_t i) {
+        if (box.overlaps({ bodies.minX[i], bodies.minY[i], bodies.maxX[i], bodies.maxY[i] }))
+            out.push_back(i);
+        return true;
+    });
+}
+
+bool World::raycast(const sf::Vector2f& from, const sf::Vector2f& to, RayHit& hit) const {
+    refitTree();
+    bool found = false;
+    tree.raycast(from, to, [&](uint32_t i, const sf::Vector2f& a, const sf::Vector2f& b, float maxT) {
+        const float t = segmentAabb(a, b, { bodies.minX[i], bodies.minY[i], bodies.maxX[i], bodies.maxY[i] }, maxT);
+        if (t < 0.f) return maxT;
+
+        found = true;
+        hit.body = i;
+        hit.fraction = t;
+        hit.point = a + (b - a) * t;
+        return t;
+    });
+    return found;
+}
@@ -0,0 +1,293 @@
+#pragma once
+#include "BodyStore.hpp"
+#include "Broadphase.hpp"
+#include "AabbTree.hpp"
+#include "Islands.hpp"
+#include "ThreadPool.hpp"
+#include "Collision.hpp"
+#include "ContactSolver.hpp"
+#include "Joints.hpp"
+
+// ---------------------
+// Headless simulation core. Only uses the header-only SFML vector/rect
+// types, so it can be stepped without a window or the TGUI/graphics libs.
+// ---------------------
+
+struct RayHit {
+    size_t body = 0;
+    float fraction = 1.f;
+    sf::Vector2f point{};
+};
+
+// Body/body contact whose impulse passed the impact threshold
+struct ImpactEvent {
+    uint32_t a = 0, b = 0;
+    sf::Vector2f point{};     // centre of the bounds overlap
+    sf::Vector2f normal{};    // from a towards b
+    float impulse = 0.f;
+};
+
+// ---------------------
+// Complete simulation state of a World in one flat buffer: every body
+// array, sleep state, the joints, the persistent contacts and ground
+// impulses (so a restored world warm starts exactly as it would have), but
+// none of the settings (gravity, ground, solver, sleep thresholds).
+// Saving into the same snapshot again reuses its buffer, so once it has
+// grown to the world's size a save or restore is a few memcpys and no
+// allocation.
+// ---------------------
+class WorldSnapshot {
+public:
+    bool empty() const { return bytes.empty(); }
+    size_t getBodyCount() const { return bodyCount; }
+    size_t getByteSize() const { return bytes.size(); }
+    // Keeps the buffer for the next save
+    void clear() { bytes.clear(); bodyCount = 0; }
+
+private:
+    friend class World;
+    std::vector<uint8_t> bytes;
+    size_t bodyCount = 0;
+};
+
+// ---------------------
+// World
+// ---------------------
+class World {
+public:
+    World() = default;
+
+    // Bodies
+    size_t addBody(const Body& body);
+    // Bulk add (scene loading). Into an empty world the query tree is
+    // built in one pass instead of body by body. Returns the first index.
+    size_t addBodies(const BodyColumns& columns);
+    // O(1) apart from waking the neighbours and dropping the body's cached
+    // contacts: the last body takes over 'index', so hold on to bodies by
+    // handle, not by index. Other contacts keep their warm start.
+    void removeBody(size_t index);
+    // False if the body was already gone
+    bool removeBody(BodyHandle body);
+    // Removes every body still there; returns how many that were. The
+    // contact cache is remapped and the neighbours woken once for the
+    // whole batch. 'removedAt', if given, gets the index each body had
+    // when it went, in order, so a mirror can repeat the swaps.
+    size_t removeBodies(const std::vector<BodyHandle>& handles, std::vector<size_t>* removedAt = nullptr);
+    void clear();
+    void reserve(size_t n) { bodies.reserve(n); }
+    size_t size() const { return bodies.count(); }
+
+    BodyHandle getHandle(size_t index) const { return bodies.handle[index]; }
+    // Current index of the body, or BodyStore::noBody once it is removed
+    size_t indexOf(BodyHandle body) const { return bodies.indexOf(body); }
+    bool contains(BodyHandle body) const { return bodies.indexOf(body) != BodyStore::noBody; }
+
+    Body getBody(size_t index) const { return bodies.get(index); }
+    void setBody(size_t index, const Body& body);
+
+    sf::Vector2f getPosition(size_t index) const { return { bodies.posX[index], bodies.posY[index] }; }
+    // Teleports: the previous position is reset too, so nothing is interpolated
+    void setPosition(size_t index, const sf::Vector2f& pos);
+    // Blend of the positions before and after the last step, alpha in [0, 1]
+    sf::Vector2f getInterpolatedPosition(size_t index, float alpha) const {
+        const float px = bodies.prevX[index], py = bodies.prevY[index];
+        return { px + (bodies.posX[index] - px) * alpha, py + (bodies.posY[index] - py) * alpha };
+    }
+    sf::Vector2f getVelocity(size_t index) const { return { bodies.velX[index], bodies.velY[index] }; }
+    void setVelocity(size_t index, const sf::Vector2f& vel);
+
+    // Cached world bounds, outline included (see BodyStore)
+    sf::FloatRect getBounds(size_t index) const { return bodies.bounds(index); }
+    // Bumped by anything but motion (see BodyStore::getLayoutRevision)
+    uint64_t getLayoutRevision() const { return bodies.getLayoutRevision(); }
+
+    // Direct access for hot loops. Call markMoved() after moving bodies.
+    BodyStore& getStore() { return bodies; }
+    const BodyStore& getStore() const { return bodies; }
+
+    // Spatial queries against the dynamic AABB tree, tested on the tight
+    // bounds. Hits are appended to 'out' in no particular order. The tree
+    // is refitted lazily on the first query after bodies moved, so steps
+    // that nobody queries (headless runs) never pay for it.
+    void queryPoint(const sf::Vector2f& point, std::vector<size_t>& out) const;
+    void queryRect(const sf::FloatRect& rect, std::vector<size_t>& out) const;
+    // Closest body whose bounds the segment from -> to enters
+    bool raycast(const sf::Vector2f& from, const sf::Vector2f& to, RayHit& hit) const;
+
+    const AabbTree& getTree() const { refitTree(); return tree; }
+    void markMoved() { treeDirty = true; }
+
+    // Joints (see JointSolver). They are solved every step before the
+    // contacts, and bodies joined to each other do not collide. A joint
+    // goes away with either of its bodies; like bodies, the last joint
+    // takes over a removed joint's index.
+    // Returns JointSolver::noJoint if a body is missing or both are the same
+    size_t addJoint(const JointDef& joint);
+    void removeJoint(size_t index) { joints.remove(index); }
+    void clearJoints() { joints.clear(); }
+    size_t getJointCount() const { return joints.size(); }
+    const JointDef& getJoint(size_t index) const { return joints.get(index); }
+    // Adds the rope's segments as bodies and joins them up; returns the
+    // index of the first segment (the rest follow it), or BodyStore::noBody
+    // if an end is missing
+    size_t addRope(const RopeDef& rope);
+    // Iteration budgets and early-out tolerance (px/s) of the joint solve
+    void setJointVelocityIterations(int n) { joints.setVelocityIterations(n); }
+    int getJointVelocityIterations() const { return joints.getVelocityIterations(); }
+    void setJointPositionIterations(int n) { joints.setPositionIterations(n); }
+    int getJointPositionIterations() const { return joints.getPositionIterations(); }
+    void setJointTolerance(float t) { joints.setTolerance(t); }
+    float getJointTolerance() const { return joints.getTolerance(); }
+    const JointSolver& getJointSolver() const { return joints; }
+
+    // Simulation
+    void step(float dt);
+
+    // Snapshots. Restoring into a world with a different body count
+    // rebuilds the query tree in one pass; otherwise it is refitted lazily
+    // like after any move. Returns true if the bodies themselves (count,
+    // types or sizes) differ from before, i.e. anything mirroring them
+    // (shapes, per-body UI state) has to be rebuilt.
+    void saveSnapshot(WorldSnapshot& snapshot) const;
+    bool restoreSnapshot(const WorldSnapshot& snapshot);
+
+    // Changing gravity or moving the ground wakes every body
+    void setGravity(float g);
+    float getGravity() const { return gravity; }
+    void setGroundY(float y);
+    float getGroundY() const { return groundY; }
+    void setGroundFriction(float f) { groundFriction = f; }
+    float getGroundFriction() const { return groundFriction; }
+
+    // Broadphase grid cell size in world units, 0 = automatic
+    void setCellSize(float size) { broadphase.setCellSize(size); }
+    float getCellSize() const { return broadphase.getCellSize(); }
+
+    // Contact solver. Velocity iterations trade time for how well stacks
+    // and piles converge; position iterations drive the split-impulse
+    // overlap correction (ignored with Baumgarte).
+    void setVelocityIterations(int n) { solver.setVelocityIterations(n); }
+    int getVelocityIterations() const { return solver.getVelocityIterations(); }
+    void setPositionIterations(int n) { solver.setPositionIterations(n); }
+    int getPositionIterations() const { return solver.getPositionIterations(); }
+    void setContactCorrection(ContactSolver::Correction c) { solver.setCorrection(c); }
+    ContactSolver::Correction getContactCorrection() const { return solver.getCorrection(); }
+
+    // Candidate pairs handed to the contact solver by the last step
+    size_t getPairCount() const { return pairs.size(); }
+    // Contact manifold of each pair from the last step (pointCount 0 if
+    // the shapes did not touch), parallel to getPairs()
+    const std::vector<Broadphase::Pair>& getPairs() const { return pairs; }
+    const std::vector<Manifold>& getManifolds() const { return manifolds; }
+    size_t getContactCount() const;
+    // Contact islands solved in parallel by the last step (0 if serial)
+    size_t getIslandCount() const { return lastIslandCount; }
+
+    // Optional pool for the contact solve (not owned). Islands are solved
+    // independently, so results match the serial solve for any thread count.
+    void setThreadPool(ThreadPool* p) { pool = p; }
+
+    // Sleeping. Bodies that stay slower than sleepSpeed (px/s) for
+    // sleepTime seconds, together with every body they touch, stop being
+    // integrated and drop out of the broadphase. A sleeper wakes when an
+    // awake body faster than sleepSpeed hits it, when it is edited, or when
+    // a neighbour is removed; slower bodies treat it as immovable.
+    void setSleepEnabled(bool enabled);
+    bool isSleepEnabled() const { return sleepEnabled; }
+    void setSleepThresholds(float speed, float time) { sleepSpeed = speed; sleepTime = time; }
+    float getSleepSpeed() const { return sleepSpeed; }
+    float getSleepTime() const { return sleepTime; }
+    bool isAwake(size_t index) const { return bodies.awake[index] != 0; }
+    void wake(size_t index);
+    size_t getAwakeCount() const { return awakeCount; }
+
+    // Continuous collision. After the discrete solve, fast bodies
+    // (Body::fast), and with a threshold > 0 every body that moved further
+    // than that fraction of its smallest extent in the step, are swept
+    // from their previous position against the bodies near their path
+    // (see timeOfImpact). One that reaches another inside the step is put
+    // back where they first touched and bounced off it, so it cannot pass
+    // through; it gives up the rest of the step to do so. Only the swept
+    // bodies pay for this, instead of every body taking smaller steps.
+    void setContinuousThreshold(float fraction) { continuousThreshold = fraction; }
+    float getContinuousThreshold() const { return continuousThreshold; }
+    void setFast(size_t index, bool fast) { bodies.fast[index] = fast ? 1 : 0; }
+    bool isFast(size_t index) const { return bodies.fast[index] != 0; }
+    // Bodies swept and contacts found by the last step
+    size_t getSweptCount() const { return lastSweptCount; }
+    size_t getTimeOfImpactCount() const { return lastImpactCount; }
+    static constexpr float continuousSlop = 0.1f;
+
+    // Impacts of the last step, in pair order (then continuous contacts
+    // in body order), capped at maxImpacts per step. Threshold is the
+    // impulse (mass * px/s) needed; 0 turns collection off.
+    void setImpactThreshold(float impulse) { impactThreshold = impulse; }
+    float getImpactThreshold() const { return impactThreshold; }
+    void setMaxImpacts(size_t n) { maxImpacts = n; impacts.reserve(n); }
+    const std::vector<ImpactEvent>& getImpacts() const { return impacts; }
+
+    static constexpr float defaultGravity = 9.81f * 50.f;
+
+private:
+    void integrate(float dt);
+    void collide(float dt);
+    void matchManifolds();
+    void updateManifold(size_t k);
+    void gatherImpacts();
+    void updateSleep(float dt);
+    void solveContinuous();
+    void refitTree() const;
+    // Removal without the contact cache or the neighbours
+    void eraseBody(size_t index);
+    // Renumbers the cached pairs with 'map' (old index -> new, or
+    // BodyStore::noBody) and drops those of removed bodies
+    template <typename Map> void remapPairs(Map map);
+
+private:
+    BodyStore bodies;
+    Broadphase broadphase;
+    std::vector<Broadphase::Pair> pairs;
+
+    // Manifolds persist between steps; prevMatch[k] is the previous
+    // step's index of pair k (noMatch if it is new)
+    std::vector<Manifold> manifolds, prevManifolds;
+    std::vector<Broadphase::Pair> prevPairs;
+    std::vector<uint32_t> prevMatch;
+    static constexpr uint32_t noMatch = 0xffffffffu;
+
+    ContactSolver solver;
+    std::vector<uint32_t> serialOrder;
+    JointSolver joints;
+
+    ThreadPool* pool = nullptr;
+    IslandBuilder islands;
+    std::vector<uint32_t> taskStart;
+    size_t lastIslandCount = 0;
+    bool islandsBuilt = false;
+
+    bool sleepEnabled = true;
+    float sleepSpeed = 10.f;
+    float sleepTime = 0.5f;
+    size_t awakeCount = 0;
+    std::vector<float> islandMinTimer;
+
+    float continuousThreshold = 0.f;
+    std::vector<uint32_t> sweptBodies;
+    size_t lastSweptCount = 0;
+    size_t lastImpactCount = 0;
+
+    float impactThreshold = 0.f;
+    size_t maxImpacts = 256;
+    std::vector<float> pairImpulse;
+    std::vector<ImpactEvent> impacts;
+
+    mutable AabbTree tree;
+    mutable bool treeDirty = false;
+    std::vector<int32_t> proxies;
+    std::vector<size_t> neighbours;
+    std::vector<uint32_t> movedPairs;
+
+    float gravity = defaultGravity;
+    float groundY = 0.f;
+    float groundFriction = 0.f;
+};
@@ -0,0 +1,350 @@
+#include "World.hpp"
+#include "Scene.hpp"
+#include "Recording.hpp"
+#include "SimdKernels.hpp"
+#include "Profiler.hpp"
+#include "Sweep.hpp"
+#include <chrono>
+#include <cmath>
+#include <memory>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+// Headless batch runner: loads a scene and steps it as fast as possible.
+//
+//   Physics_____Runner <scene> [options]
+//   Physics_____Runner --rain N    [options]
+//   Physics_____Runner --scaling   [options]
+//   Physics_____Runner <scene> --sweep field min max count [...] [options]
+//   Physics_____Runner --convert <in> <out>
+//
+// Scenes can be text or binary (.pscene); see Scene.hpp.
+//
+//   --steps N      steps to run (default 1000)
+//   --dt seconds   step length (default 1/60)
+//   --cell size    broadphase cell size, 0 = automatic
+//   --threads N    solve contact islands on N threads (default 1, 0 = one
+//                  per core); a sweep runs that many worlds at once
+//   --simd level   scalar, sse2 or avx2 (default: best supported)
+//   --no-sleep     keep every body awake
+//   --iterations N contact solver velocity iterations (default: scene's)
+//   --position-iterations N  split-impulse passes (default: scene's)
+//   --ccd fraction sweep bodies that move further than this fraction of
+//                  their size per step (continuous collision, default off)
+//   --save path    write the loaded or generated scene and exit
+//   --record path  stream every step to a recording (.prec)
+//   --profile path time the step's zones, print their averages and write
+//                  the last steps as a Chrome trace
+//
+// --convert rewrites a scene in the format its output name implies
+// (binary for .pscene, text otherwise), e.g. to turn a text scene into
+// one that maps in directly. "--rain N --save big.pscene" makes a
+// large test scene.
+//
+// --scaling runs the rain scene from 1k to 100k circles and prints one
+// row per size, to check the broadphase stays near-linear.
+//
+// A sweep relaunches one body of the scene with every combination of
+// the --sweep ranges, or with random draws from them, each run in its
+// own copy of the world until that body comes to rest (see Sweep.hpp):
+//
+//   --sweep field min max count  field: speed, angle, mass or elasticity;
+//                  repeat for more fields
+//   --samples N    N Monte Carlo runs instead of the grid
+//   --seed S       their random seed (default 1)
+//   --body index   the launched body (default 0)
+//   --out path     results as CSV, or binary for a .psweep path
+//
+// --steps is then each run's step limit.
+
+static void printUsage() {
+    std::printf("usage: Physics_____Runner <scene> | --rain N | --scaling [--steps N] [--dt seconds] [--cell size] [--threads N] [--simd level] [--no-sleep] [--iterations N] [--position-iterations N] [--ccd fraction] [--save path] [--record path] [--profile path]\n");
+    std::printf("       Physics_____Runner <scene> --sweep field min max count [--sweep ...] [--samples N] [--seed S] [--body index] [--out path] [options]\n");
+    std::printf("       Physics_____Runner --convert <in> <out>\n");
+}
+
+struct RunResult {
+    double seconds = 0.0;
+    double pairsPerStep = 0.0;
+};
+
+static RunResult runSteps(World& world, long long steps, float dt, RecordingWriter* recorder = nullptr) {
+    RunResult result;
+    size_t pairs = 0;
+
+    const auto start = std::chrono::steady_clock::now();
+    for (long long s = 0; s < steps; ++s) {
+        world.step(dt);
+        pairs += world.getPairCount();
+        if (recorder) recorder->capture(world, static_cast<uint64_t>(s + 1));
+        if (Profiler::isEnabled()) Profiler::endFrame();
+    }
+    const auto end = std::chrono::steady_clock::now();
+
+    result.seconds = std::chrono::duration<double>(end - start).count();
+    result.pairsPerStep = static_cast<double>(pairs) / static_cast<double>(steps);
+    return result;
+}
+
+static int convertScene(const std::string& in, const std::string& out) {
+    World world;
+    std::vector<SceneLine> lines;
+    std::string error;
+    if (!loadScene(in, world, &lines, error) || !saveScene(out, world, lines, error)) {
+        std::fprintf(stderr, "error: %s\n", error.c_str());
+        return 1;
+    }
+    std::printf("wrote %s: %zu bodies, %zu trigger lines\n", out.c_str(), world.size(), lines.size());
+    return 0;
+}
+
+static void runScaling(long long steps, float dt, float cellSize, bool sleep, int velocityIterations, ThreadPool* pool) {
+    const size_t sizes[] = { 1000, 2000, 5000, 10000, 20000, 50000, 100000 };
+
+    std::printf("%10s %12s %14s %14s\n", "bodies", "steps/sec", "ns/body/step", "pairs/step");
+    for (size_t count : sizes) {
+        World world;
+        world.setCellSize(cellSize);
+        world.setThreadPool(pool);
+        world.setSleepEnabled(sleep);
+        if (velocityIterations > 0) world.setVelocityIterations(velocityIterations);
+        generateRain(world, count, 4.f);
+
+        const RunResult r = runSteps(world, steps, dt);
+        const double nsPerBody = r.seconds * 1e9 / (static_cast<double>(steps) * static_cast<double>(count));
+        std::printf("%10zu %12.1f %14.1f %14.1f\n", count, static_cast<double>(steps) / r.seconds, nsPerBody, r.pairsPerStep);
+    }
+}
+
+static int runSweepMode(const World& world, const std::vector<SceneLine>& lines, const SweepSpec& spec,
+                        ThreadPool* pool, const std::string& outPath) {
+    SweepWriter writer;
+    std::string error;
+    if (!outPath.empty() && !writer.open(outPath, error)) {
+        std::fprintf(stderr, "error: %s\n", error.c_str());
+        return 1;
+    }
+
+    size_t landed = 0, rested = 0;
+    double steps = 0.0;
+    const auto sink = [&](const std::vector<SweepResult>& batch, std::string& sinkError) {
+        for (const SweepResult& r : batch) {
+            landed += r.landingTime >= 0.f;
+            rested += r.restTime >= 0.f;
+            steps += r.restTime >= 0.f ? std::round(r.restTime / spec.dt) : spec.maxSteps;
+        }
+        return outPath.empty() || writer.write(batch, sinkError);
+    };
+
+    const auto start = std::chrono::steady_clock::now();
+    if (!runSweep(world, lines, spec, pool, sink, error) || !writer.close(error)) {
+        std::fprintf(stderr, "error: %s\n", error.c_str());
+        return 1;
+    }
+    const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    const size_t runs = getSweepRunCount(spec);
+    std::printf("runs:             %zu (%s)\n", runs, spec.samples ? "random" : "grid");
+    std::printf("bodies per run:   %zu\n", world.size());
+    std::printf("landed / rested:  %zu / %zu\n", landed, rested);
+    std::printf("wall time:        %.3f s\n", seconds);
+    std::printf("runs/sec:         %.1f\n", seconds > 0.0 ? static_cast<double>(runs) / seconds : 0.0);
+    std::printf("steps/sec:        %.1f\n", seconds > 0.0 ? steps / seconds : 0.0);
+    std::printf("threads:          %u\n", pool ? pool->getThreadCount() : 1u);
+    if (!outPath.empty()) std::printf("results:          %s\n", outPath.c_str());
+    return 0;
+}
+
+int main(int argc, char** argv)
+{
+    std::string scenePath;
+    std::string savePath;
+    std::string recordPath;
+    std::string profilePath;
+    long long steps = 1000;
+    float dt = 1.f / 60.f;
+    float cellSize = -1.f;
+    size_t rainCount = 0;
+    unsigned threads = 1;
+    bool scaling = false;
+    int velocityIterations = 0;
+    int positionIterations = -1;
+    float continuousThreshold = 0.f;
+    bool sleep = true;
+    SweepSpec sweep;
+    std::string sweepOut;
+
+    for (int i = 1; i < argc; ++i) {
+        if (std::strcmp(argv[i], "--steps") == 0 && i + 1 < argc)
+            steps = std::atoll(argv[++i]);
+        else if (std::strcmp(argv[i], "--dt") == 0 && i + 1 < argc)
+            dt = static_cast<float>(std::atof(argv[++i]));
+        else if (std::strcmp(argv[i], "--cell") == 0 && i + 1 < argc)
+            cellSize = static_cast<float>(std::atof(argv[++i]));
+        else if (std::strcmp(argv[i], "--rain") == 0 && i + 1 < argc)
+            rainCount = static_cast<size_t>(std::atoll(argv[++i]));
+        else if (std::strcmp(argv[i], "--threads") == 0 && i + 1 < argc)
+            threads = static_cast<unsigned>(std::atoi(argv[++i]));
+        else if (std::strcmp(argv[i], "--simd") == 0 && i + 1 < argc) {
+            const char* level = argv[++i];
+            setSimdLevel(std::strcmp(level, "scalar") == 0 ? SimdLevel::Scalar
+                : std::strcmp(level, "sse2") == 0 ? SimdLevel::Sse2 : SimdLevel::Avx2);
+        }
+        else if (std::strcmp(argv[i], "--scaling") == 0)
+            scaling = true;
+        else if (std::strcmp(argv[i], "--no-sleep") == 0)
+            sleep = false;
+        else if (std::strcmp(argv[i], "--iterations") == 0 && i + 1 < argc)
+            velocityIterations = std::atoi(argv[++i]);
+        else if (std::strcmp(argv[i], "--position-iterations") == 0 && i + 1 < argc)
+            positionIterations = std::atoi(argv[++i]);
+        else if (std::strcmp(argv[i], "--ccd") == 0 && i + 1 < argc)
+            continuousThreshold = static_cast<float>(std::atof(argv[++i]));
+        else if (std::strcmp(argv[i], "--save") == 0 && i + 1 < argc)
+            savePath = argv[++i];
+        else if (std::strcmp(argv[i], "--record") == 0 && i + 1 < argc)
+            recordPath = argv[++i];
+        else if (std::strcmp(argv[i], "--profile") == 0 && i + 1 < argc)
+            profilePath = argv[++i];
+        else if (std::strcmp(argv[i], "--sweep") == 0 && i + 4 < argc) {
+            SweepAxis axis;
+            if (!parseSweepField(argv[i + 1], axis.field)) {
+                printUsage();
+                return 1;
+            }
+            axis.min = static_cast<float>(std::atof(argv[i + 2]));
+            axis.max = static_cast<float>(std::atof(argv[i + 3]));
+            axis.count = static_cast<uint32_t>(std::atoi(argv[i + 4]));
+            sweep.axes.push_back(axis);
+            i += 4;
+        }
+        else if (std::strcmp(argv[i], "--samples") == 0 && i + 1 < argc)
+            sweep.samples = static_cast<size_t>(std::atoll(argv[++i]));
+        else if (std::strcmp(argv[i], "--seed") == 0 && i + 1 < argc)
+            sweep.seed = static_cast<uint64_t>(std::atoll(argv[++i]));
+        else if (std::strcmp(argv[i], "--body") == 0 && i + 1 < argc)
+            sweep.body = static_cast<size_t>(std::atoll(argv[++i]));
+        else if (std::strcmp(argv[i], "--out") == 0 && i + 1 < argc)
+            sweepOut = argv[++i];
+        else if (std::strcmp(argv[i], "--convert") == 0 && i + 2 < argc)
+            return convertScene(argv[i + 1], argv[i + 2]);
+        else if (argv[i][0] != '-' && scenePath.empty())
+            scenePath = argv[i];
+        else {
+            printUsage();
+            return 1;
+        }
+    }
+
+    if (steps <= 0 || dt <= 0.f || (!scaling && scenePath.empty() && rainCount == 0)) {
+        printUsage();
+        return 1;
+    }
+
+    std::unique_ptr<ThreadPool> pool;
+    if (threads != 1) pool = std::make_unique<ThreadPool>(threads);
+
+    if (scaling) {
+        runScaling(steps, dt, cellSize < 0.f ? 0.f : cellSize, sleep, velocityIterations, pool.get());
+        return 0;
+    }
+
+    World world;
+    world.setThreadPool(pool.get());
+    std::vector<SceneLine> lines;
+    const auto loadStart = std::chrono::steady_clock::now();
+    if (rainCount > 0) {
+        generateRain(world, rainCount, 4.f);
+    }
+    else {
+        std::string error;
+        if (!loadScene(scenePath, world, &lines, error)) {
+            std::fprintf(stderr, "error: %s\n", error.c_str());
+            return 1;
+        }
+    }
+    const double loadSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - loadStart).count();
+
+    if (!savePath.empty()) {
+        std::string error;
+        if (!saveScene(savePath, world, lines, error)) {
+            std::fprintf(stderr, "error: %s\n", error.c_str());
+            return 1;
+        }
+        std::printf("wrote %s: %zu bodies, %zu trigger lines\n", savePath.c_str(), world.size(), lines.size());
+        return 0;
+    }
+    if (!sleep) world.setSleepEnabled(false);
+    if (cellSize >= 0.f) world.setCellSize(cellSize);
+    if (velocityIterations > 0) world.setVelocityIterations(velocityIterations);
+    if (positionIterations >= 0) world.setPositionIterations(positionIterations);
+    world.setContinuousThreshold(continuousThreshold);
+
+    if (!sweep.axes.empty()) {
+        sweep.dt = dt;
+        sweep.maxSteps = static_cast<uint32_t>(std::min<long long>(steps, UINT32_MAX));
+        return runSweepMode(world, lines, sweep, pool.get(), sweepOut);
+    }
+
+    // Step 0 is the initial state
+    RecordingWriter recorder;
+    recorder.setDropWhenBehind(false);
+    if (!recordPath.empty()) {
+        std::string error;
+        if (!recorder.start(recordPath, dt, error)) {
+            std::fprintf(stderr, "error: %s\n", error.c_str());
+            return 1;
+        }
+        recorder.capture(world, 0);
+    }
+
+    Profiler::setThreadName("main");
+    Profiler::setEnabled(!profilePath.empty());
+    const RunResult r = runSteps(world, steps, dt, recorder.isRecording() ? &recorder : nullptr);
+    recorder.stop();
+    Profiler::setEnabled(false);
+    const double stepsPerSec = r.seconds > 0.0 ? static_cast<double>(steps) / r.seconds : 0.0;
+
+    std::printf("bodies:           %zu\n", world.size());
+    std::printf("load time:        %.3f s\n", loadSeconds);
+    std::printf("steps:            %lld (dt %.6f s)\n", steps, dt);
+    std::printf("wall time:        %.3f s\n", r.seconds);
+    std::printf("steps/sec:        %.1f\n", stepsPerSec);
+    std::printf("bodies*steps/sec: %.1f\n", stepsPerSec * static_cast<double>(world.size()));
+    std::printf("pairs/step:       %.1f\n", r.pairsPerStep);
+    std::printf("awake at end:     %zu\n", world.getAwakeCount());
+    if (continuousThreshold > 0.f)
+        std::printf("swept last step:  %zu (%zu contacts)\n", world.getSweptCount(), world.getTimeOfImpactCount());
+    if (world.getJointCount()) {
+        const JointSolver& joints = world.getJointSolver();
+        std::printf("joints:           %zu (%zu rows in %zu colours, %zu chains; last step %d of %d passes)\n",
+                    world.getJointCount(), joints.getRowCount(), joints.getColourCount(), joints.getChainCount(),
+                    joints.getIterationsUsed(), joints.getVelocityIterations());
+    }
+    std::printf("solver:           %d velocity, %d position iterations (%s)\n", world.getVelocityIterations(),
+                world.getPositionIterations(),
+                world.getContactCorrection() == ContactSolver::Correction::Baumgarte ? "baumgarte" : "split impulses");
+    std::printf("threads:          %u\n", pool ? pool->getThreadCount() : 1u);
+    std::printf("simd:             %s\n", simdLevelName(getSimdLevel()));
+    if (!recordPath.empty()) {
+        const uint64_t frames = recorder.getFramesWritten();
+        std::printf("recording:        %llu frames, %llu dropped, %.2f MB (%.1f bytes/frame)%s\n",
+                    static_cast<unsigned long long>(frames), static_cast<unsigned long long>(recorder.getFramesDropped()),
+                    static_cast<double>(recorder.getBytesWritten()) / 1e6,
+                    frames ? static_cast<double>(recorder.getBytesWritten()) / static_cast<double>(frames) : 0.0,
+                    recorder.isFull() ? ", size limit hit" : "");
+    }
+    if (!profilePath.empty()) {
+        std::string error;
+        if (!Profiler::writeChromeTrace(profilePath, error)) {
+            std::fprintf(stderr, "error: %s\n", error.c_str());
+            return 1;
+        }
+        std::printf("profile (per step, last %zu steps):\n%s", std::min<size_t>(Profiler::statsWindow, static_cast<size_t>(steps)),
+                    Profiler::formatStats().c_str());
+    }
+    return 0;
+}